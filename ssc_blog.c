@@ -0,0 +1,461 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_blog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ssc_log.h"
+
+// bounds of the call site section, provided by the linker
+extern ssc_blog_site_t __start_ssc_blog_sites[] __attribute__((weak));
+extern ssc_blog_site_t __stop_ssc_blog_sites[] __attribute__((weak));
+
+// largest record: header plus every argument as a capped string
+#define BLOG_RECORD_MAX \
+   (sizeof(ssc_blog_file_rec_t) + SSC_BLOG_MAX_ARGS * (2 + SSC_BLOG_STR_MAX) + 8)
+
+// ssc_blog_site_t::cap of a string bounded by the preceding '*' argument
+#define BLOG_CAP_STAR 0xffff
+
+#define BLOG_ALIGN(x) (((x) + 7u) & ~(size_t)7u)
+
+int sscBlogActive = 0;
+
+static int blogFd = -1;
+static char *blogBase = NULL;
+static ssc_blog_file_hdr_t *blogHdr = NULL;
+
+static int priv_blog_parse(ssc_blog_site_t *site);
+static int priv_blog_int_arg(int length, char conv);
+static size_t priv_blog_site_size(const ssc_blog_site_t *site);
+static size_t priv_blog_site_write(char *p, const ssc_blog_site_t *site);
+static size_t priv_blog_encode(char *rec, const ssc_blog_site_t *site, va_list ap);
+
+// Must be called from main thread
+int sscBlogOpen(const char *path, size_t size)
+{
+   if (!path)
+   {
+      SSCError("%s: NULL path", __func__);
+      return BLOG_FAILURE;
+   }
+
+   if (blogBase)
+   {
+      SSCError("%s: binary log already open", __func__);
+      return BLOG_FAILURE;
+   }
+
+   if (size == 0)
+   {
+      size = SSC_BLOG_DEFAULT_SIZE;
+   }
+
+   // parse every call site once, so the hot path only reads the result
+   size_t sitesSize = 0;
+   unsigned nsites = 0;
+   ssc_blog_site_t *site;
+   for (site = __start_ssc_blog_sites; site && site < __stop_ssc_blog_sites; ++site)
+   {
+      if (site->nargs == 0)
+      {
+         site->nargs = priv_blog_parse(site);
+      }
+      sitesSize += priv_blog_site_size(site);
+      ++nsites;
+   }
+
+   size_t recsOff = BLOG_ALIGN(sizeof(ssc_blog_file_hdr_t)) + sitesSize;
+   if (size < recsOff + BLOG_RECORD_MAX)
+   {
+      SSCError("%s: size %zu too small, need at least %zu", __func__,
+            size, recsOff + BLOG_RECORD_MAX);
+      return BLOG_FAILURE;
+   }
+
+   int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+   {
+      SSCError("%s: cannot open %s: %s", __func__, path, strerror(errno));
+      return BLOG_FAILURE;
+   }
+
+   if (ftruncate(fd, (off_t)size) != 0)
+   {
+      SSCError("%s: cannot size %s: %s", __func__, path, strerror(errno));
+      close(fd);
+      return BLOG_FAILURE;
+   }
+
+   char *base = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (base == MAP_FAILED)
+   {
+      SSCError("%s: cannot map %s: %s", __func__, path, strerror(errno));
+      close(fd);
+      return BLOG_FAILURE;
+   }
+
+   ssc_blog_file_hdr_t *hdr = (ssc_blog_file_hdr_t *)base;
+   memcpy(hdr->magic, SSC_BLOG_MAGIC, sizeof(hdr->magic));
+   hdr->version = SSC_BLOG_VERSION;
+   hdr->sites = nsites;
+   hdr->sites_off = BLOG_ALIGN(sizeof(ssc_blog_file_hdr_t));
+   hdr->recs_off = recsOff;
+   hdr->size = size;
+   hdr->wpos = recsOff;
+   hdr->dropped = 0;
+
+   char *p = base + hdr->sites_off;
+   for (site = __start_ssc_blog_sites; site && site < __stop_ssc_blog_sites; ++site)
+   {
+      p += priv_blog_site_write(p, site);
+   }
+
+   blogFd = fd;
+   blogBase = base;
+   __atomic_store_n(&blogHdr, hdr, __ATOMIC_RELEASE);
+   __atomic_store_n(&sscBlogActive, 1, __ATOMIC_RELEASE);
+
+   return BLOG_SUCCESS;
+}
+
+// Must be called from main thread
+void sscBlogClose(void)
+{
+   if (!blogBase) { return; }
+
+   __atomic_store_n(&sscBlogActive, 0, __ATOMIC_RELEASE);
+   __atomic_store_n(&blogHdr, NULL, __ATOMIC_RELEASE);
+
+   ssc_blog_file_hdr_t *hdr = (ssc_blog_file_hdr_t *)blogBase;
+   size_t size = hdr->size;
+   size_t used = hdr->wpos < size ? hdr->wpos : size;
+   if (hdr->dropped)
+   {
+      SSCWarning("%s: %lu binary log record(s) dropped, file full", __func__,
+            (unsigned long)hdr->dropped);
+   }
+
+   msync(blogBase, size, MS_SYNC);
+   munmap(blogBase, size);
+   blogBase = NULL;
+
+   // keep only what was written
+   if (ftruncate(blogFd, (off_t)used) != 0)
+   {
+      SSCError("%s: cannot truncate binary log: %s", __func__, strerror(errno));
+   }
+   close(blogFd);
+   blogFd = -1;
+}
+
+unsigned long sscBlogDropped(void)
+{
+   ssc_blog_file_hdr_t *hdr = __atomic_load_n(&blogHdr, __ATOMIC_ACQUIRE);
+   return hdr ? (unsigned long)__atomic_load_n(&hdr->dropped, __ATOMIC_RELAXED) : 0;
+}
+
+bool sscBlogWrite(ssc_blog_site_t *site, ...)
+{
+   ssc_blog_file_hdr_t *hdr = __atomic_load_n(&blogHdr, __ATOMIC_ACQUIRE);
+   if (!hdr)
+   {
+      return false;
+   }
+
+   // sites from other link units are not in our table
+   if (site < __start_ssc_blog_sites || site >= __stop_ssc_blog_sites)
+   {
+      return false;
+   }
+
+   if (site->nargs <= 0)
+   {
+      return false;
+   }
+
+   char rec[BLOG_RECORD_MAX];
+   struct timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+
+   va_list ap;
+   va_start(ap, site);
+   size_t len = BLOG_ALIGN(priv_blog_encode(rec, site, ap));
+   va_end(ap);
+
+   uint64_t off = __atomic_fetch_add(&hdr->wpos, len, __ATOMIC_RELAXED);
+   if (off + len > hdr->size)
+   {
+      __atomic_fetch_add(&hdr->dropped, 1, __ATOMIC_RELAXED);
+      return true;
+   }
+
+   ssc_blog_file_rec_t *r = (ssc_blog_file_rec_t *)rec;
+   r->site = (uint32_t)(site - __start_ssc_blog_sites);
+   r->ts_ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+   // body first, then publish the length
+   char *dst = blogBase + off;
+   memcpy(dst + sizeof(r->len), rec + sizeof(r->len), len - sizeof(r->len));
+   __atomic_store_n((uint32_t *)dst, (uint32_t)len, __ATOMIC_RELEASE);
+
+   return true;
+}
+
+
+/** internal functions follow **/
+
+// work out the argument encodings of a printf format.
+// @return number of arguments + 1, or -1 if the format cannot be encoded
+int priv_blog_parse(ssc_blog_site_t *site)
+{
+   const char *p = site->fmt;
+   int n = 0;
+
+   while (*p)
+   {
+      if (*p++ != '%') { continue; }
+      if (*p == '%') { ++p; continue; }
+
+      while (*p && strchr("-+ #0'", *p)) { ++p; }
+
+      if (*p == '*')
+      {
+         if (n >= SSC_BLOG_MAX_ARGS) { return -1; }
+         site->sig[n] = SSC_BLOG_ARG_I32;
+         site->cap[n++] = 0;
+         ++p;
+      }
+      else
+      {
+         while (*p >= '0' && *p <= '9') { ++p; }
+      }
+
+      int prec = -1;       // -1 none, -2 taken from a '*' argument
+      if (*p == '.')
+      {
+         ++p;
+         if (*p == '*')
+         {
+            if (n >= SSC_BLOG_MAX_ARGS) { return -1; }
+            site->sig[n] = SSC_BLOG_ARG_I32;
+            site->cap[n++] = 0;
+            prec = -2;
+            ++p;
+         }
+         else
+         {
+            prec = 0;
+            while (*p >= '0' && *p <= '9') { prec = prec * 10 + (*p++ - '0'); }
+         }
+      }
+
+      // length modifier: 'H' = hh, 'Q' = ll
+      int length = 0;
+      switch (*p)
+      {
+         case 'h': length = (p[1] == 'h') ? 'H' : 'h'; p += (p[1] == 'h') ? 2 : 1; break;
+         case 'l': length = (p[1] == 'l') ? 'Q' : 'l'; p += (p[1] == 'l') ? 2 : 1; break;
+         case 'q': case 'j': case 'z': case 't': case 'L': length = *p++; break;
+         default: break;
+      }
+
+      char conv = *p;
+      if (!conv) { return -1; }
+      ++p;
+
+      if (n >= SSC_BLOG_MAX_ARGS) { return -1; }
+
+      switch (conv)
+      {
+         case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+            site->sig[n] = (uint8_t)priv_blog_int_arg(length, conv);
+            break;
+
+         case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            if (length == 'L') { return -1; }
+            site->sig[n] = SSC_BLOG_ARG_DBL;
+            break;
+
+         case 's':
+            if (length == 'l') { return -1; }
+            site->sig[n] = SSC_BLOG_ARG_STR;
+            break;
+
+         case 'p':
+            site->sig[n] = SSC_BLOG_ARG_PTR;
+            break;
+
+         default:
+            return -1;
+      }
+
+      // string copy limit
+      site->cap[n] = SSC_BLOG_STR_MAX;
+      if (prec == -2)
+      {
+         site->cap[n] = BLOG_CAP_STAR;
+      }
+      else if (prec >= 0 && prec < SSC_BLOG_STR_MAX)
+      {
+         site->cap[n] = (uint16_t)prec;
+      }
+      ++n;
+   }
+
+   return n + 1;
+}
+
+int priv_blog_int_arg(int length, char conv)
+{
+   size_t size;
+   switch (length)
+   {
+      case 'l': size = (conv == 'c') ? sizeof(int) : sizeof(long); break;
+      case 'Q': case 'q': size = sizeof(long long); break;
+      case 'j': size = sizeof(long long); break;
+      case 'z': size = sizeof(size_t); break;
+      case 't': size = sizeof(ptrdiff_t); break;
+      default: size = sizeof(int); break;
+   }
+   return size > 4 ? SSC_BLOG_ARG_I64 : SSC_BLOG_ARG_I32;
+}
+
+size_t priv_blog_site_size(const ssc_blog_site_t *site)
+{
+   size_t len = sizeof(ssc_blog_file_site_t);
+   if (site->nargs > 0) { len += site->nargs - 1; }
+   len += strlen(site->file) + 1 + strlen(site->tag) + 1 + strlen(site->fmt) + 1;
+   return BLOG_ALIGN(len);
+}
+
+size_t priv_blog_site_write(char *p, const ssc_blog_site_t *site)
+{
+   ssc_blog_file_site_t *fs = (ssc_blog_file_site_t *)p;
+   size_t len = priv_blog_site_size(site);
+
+   memset(p, 0, len);
+   fs->len = (uint32_t)len;
+   fs->line = (uint32_t)site->line;
+   fs->level = (uint16_t)site->level;
+   fs->nargs = (site->nargs > 0) ? (uint16_t)(site->nargs - 1) : 0xffff;
+
+   char *q = p + sizeof(*fs);
+   if (site->nargs > 0)
+   {
+      memcpy(q, site->sig, site->nargs - 1);
+      q += site->nargs - 1;
+   }
+
+   size_t l = strlen(site->file) + 1;
+   memcpy(q, site->file, l);
+   q += l;
+   l = strlen(site->tag) + 1;
+   memcpy(q, site->tag, l);
+   q += l;
+   memcpy(q, site->fmt, strlen(site->fmt) + 1);
+
+   return len;
+}
+
+// @return unpadded record length
+size_t priv_blog_encode(char *rec, const ssc_blog_site_t *site, va_list ap)
+{
+   char *p = rec + sizeof(ssc_blog_file_rec_t);
+   int last = 0;      // last integer argument, for '*' precisions
+   int i;
+
+   for (i = 0; i < site->nargs - 1; ++i)
+   {
+      switch (site->sig[i])
+      {
+         case SSC_BLOG_ARG_I32:
+         {
+            int32_t v = (int32_t)va_arg(ap, int);
+            last = v;
+            memcpy(p, &v, sizeof(v));
+            p += sizeof(v);
+            break;
+         }
+
+         case SSC_BLOG_ARG_I64:
+         {
+            int64_t v = (int64_t)va_arg(ap, long long);
+            memcpy(p, &v, sizeof(v));
+            p += sizeof(v);
+            break;
+         }
+
+         case SSC_BLOG_ARG_DBL:
+         {
+            double v = va_arg(ap, double);
+            memcpy(p, &v, sizeof(v));
+            p += sizeof(v);
+            break;
+         }
+
+         case SSC_BLOG_ARG_PTR:
+         {
+            uint64_t v = (uint64_t)(uintptr_t)va_arg(ap, void *);
+            memcpy(p, &v, sizeof(v));
+            p += sizeof(v);
+            break;
+         }
+
+         case SSC_BLOG_ARG_STR:
+         {
+            const char *s = va_arg(ap, const char *);
+            uint16_t l = 0xffff;
+            if (s)
+            {
+               size_t cap = site->cap[i];
+               if (cap == BLOG_CAP_STAR)
+               {
+                  cap = (last >= 0 && last < SSC_BLOG_STR_MAX) ? (size_t)last : SSC_BLOG_STR_MAX;
+               }
+               l = (uint16_t)strnlen(s, cap);
+            }
+            memcpy(p, &l, sizeof(l));
+            p += sizeof(l);
+            if (s)
+            {
+               memcpy(p, s, l);
+               p += l;
+            }
+            break;
+         }
+      }
+   }
+
+   return (size_t)(p - rec);
+}
@@ -0,0 +1,140 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// binary deferred-format logging.
+///
+/// while a binary log is open, every SSC log call site that lives in this
+/// library writes a compact record into a memory mapped file instead of
+/// formatting text: the call site ID, a timestamp and the raw arguments,
+/// with strings copied up to SSC_BLOG_STR_MAX bytes.  the format strings
+/// are written once to a table at the head of the file, and
+/// tools/ssc_blog_decode renders the records as text offline.
+///
+/// each call site is a static ssc_blog_site_t placed in the ssc_blog_sites
+/// section by the log macros; its ID is its index in that section.  call
+/// sites outside the library, and formats that cannot be encoded (%n, %ls,
+/// long double, more than SSC_BLOG_MAX_ARGS arguments), keep logging text.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// some simple return codes
+#define BLOG_SUCCESS   0
+#define BLOG_FAILURE  -1
+
+/// longest string argument copied into a record
+#define SSC_BLOG_STR_MAX 128
+
+/// most arguments a call site may take, '*' widths included
+#define SSC_BLOG_MAX_ARGS 16
+
+/// default size of the mapped file
+#define SSC_BLOG_DEFAULT_SIZE (64u * 1024u * 1024u)
+
+/// argument encodings, see ssc_blog_site_t::sig
+#define SSC_BLOG_ARG_I32  'i'   ///< 4 byte integer
+#define SSC_BLOG_ARG_I64  'l'   ///< 8 byte integer
+#define SSC_BLOG_ARG_DBL  'd'   ///< double
+#define SSC_BLOG_ARG_PTR  'p'   ///< pointer, stored as 8 bytes
+#define SSC_BLOG_ARG_STR  's'   ///< uint16_t length + bytes; 0xffff is NULL
+
+/// one log call site. defined by the log macros, do not create directly.
+typedef struct ssc_blog_site_s
+{
+   const char *file;
+   const char *fmt;
+   const char *tag;      // level text, e.g. "LOW   "
+   int line;
+   int level;
+
+   // filled in by sscBlogOpen()
+   int nargs;            // 0 = not parsed yet, -1 = cannot be encoded, else args + 1
+   uint8_t sig[SSC_BLOG_MAX_ARGS];
+   uint16_t cap[SSC_BLOG_MAX_ARGS];   // string copy limit per argument
+} __attribute__((aligned(8))) ssc_blog_site_t;
+
+#define SSC_BLOG_SITE_ATTR                                                      \
+   __attribute__((section("ssc_blog_sites"), used, aligned(8)))
+
+/// set while a binary log is open; checked by the log macros before
+/// anything else.
+extern int sscBlogActive;
+
+/// open (create or truncate) a binary log file of @p size bytes and map it.
+/// call from the main thread before logging threads start.
+/// @param[in] path  file to write
+/// @param[in] size  file size in bytes, 0 selects SSC_BLOG_DEFAULT_SIZE.
+///                  records that do not fit are dropped and counted.
+/// @return BLOG_SUCCESS or BLOG_FAILURE
+int sscBlogOpen(const char *path, size_t size);
+
+/// unmap the binary log and truncate the file to what was written. logging
+/// threads must be quiesced first; later log calls go back to text.
+void sscBlogClose(void);
+
+/// @return number of records dropped because the file was full
+unsigned long sscBlogDropped(void);
+
+/// write one record for @p site.  used by the log macros.
+/// @return true if the record was taken (written or counted as dropped),
+///         false if the caller should log it as text instead.
+bool sscBlogWrite(ssc_blog_site_t *site, ...);
+
+
+/// on-disk layout, shared with the decoder
+
+#define SSC_BLOG_MAGIC "SSCBLOG1"
+#define SSC_BLOG_VERSION 1
+
+typedef struct ssc_blog_file_hdr_s
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t sites;       // number of site table entries
+   uint64_t sites_off;   // offset of the first site table entry
+   uint64_t recs_off;    // offset of the first record
+   uint64_t size;        // size of the file
+   uint64_t wpos;        // next free offset; may run past size once full
+   uint64_t dropped;     // records that did not fit
+} ssc_blog_file_hdr_t;
+
+/// site table entry, followed by sig[nargs], then the NUL terminated file,
+/// tag and format strings, padded to 8 bytes
+typedef struct ssc_blog_file_site_s
+{
+   uint32_t len;         // entry length including this header and padding
+   uint32_t line;
+   uint16_t level;
+   uint16_t nargs;       // 0xffff if the site cannot be encoded
+} ssc_blog_file_site_t;
+
+/// record header, followed by the encoded arguments, padded to 8 bytes.
+/// len is stored last, so a record with len 0 is incomplete.
+typedef struct ssc_blog_file_rec_s
+{
+   uint32_t len;         // record length including this header and padding
+   uint32_t site;        // call site ID
+   uint64_t ts_ns;       // CLOCK_REALTIME in nanoseconds
+} ssc_blog_file_rec_t;
@@ -0,0 +1,377 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_group.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sofia-sip/su.h>
+#include <sofia-sip/su_alloc.h>
+
+#include "ssc_log.h"
+#include "ssc_sip.h"
+#include "ssc_oper.h"
+#include "ssc_metrics.h"
+
+#define GRP_DEFAULT_CAPACITY 16
+
+typedef struct ssc_group_leg_s
+{
+   ssc_oper_t *op;
+   unsigned long mark;     // owner's value, see ssc_group_get_mark()
+   unsigned pending : 1;   // teardown sent, waiting for the op to be destroyed
+} ssc_group_leg_t;
+
+struct ssc_group_s
+{
+   ssc_t *ssc;
+
+   ssc_group_leg_t *leg;
+   unsigned count;
+   unsigned capacity;
+
+   // teardown in progress
+   unsigned pending;
+   unsigned byes;
+   unsigned cancels;
+   unsigned busy : 1;
+   ssc_group_done_cb done_cb;
+   void *done_context;
+
+   ssc_group_state_cb state_cb;
+   void *state_context;
+};
+
+static ssc_group_leg_t *priv_grp_find(const ssc_group_t *group, const ssc_oper_t *op);
+static int priv_grp_is_answered(const ssc_oper_t *op);
+static int priv_grp_is_calling(const ssc_oper_t *op);
+static int priv_grp_teardown(ssc_group_t *group, int bye, ssc_group_done_cb cb, void *context);
+static void priv_grp_complete(ssc_group_t *group);
+
+ssc_group_t *ssc_group_create(ssc_t *ssc, unsigned capacity)
+{
+   if (!ssc || !ssc->ssc_home)
+   {
+      SSCError("%s: NULL ssc context or home ptr", __func__);
+      return NULL;
+   }
+
+   ssc_group_t *group = (ssc_group_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_group_t));
+   if (!group)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_group_t));
+      return NULL;
+   }
+
+   group->ssc = ssc;
+   group->capacity = capacity ? capacity : GRP_DEFAULT_CAPACITY;
+   group->leg = (ssc_group_leg_t *)su_zalloc(ssc->ssc_home, group->capacity * sizeof(ssc_group_leg_t));
+   if (!group->leg)
+   {
+      SSCError("%s: alloc fail - %u legs", __func__, group->capacity);
+      su_free(ssc->ssc_home, group);
+      return NULL;
+   }
+
+   return group;
+}
+
+void ssc_group_destroy(ssc_group_t *group)
+{
+   if (!group) { return; }
+
+   unsigned i;
+   for (i=0; i<group->count; ++i)
+   {
+      group->leg[i].op->op_group = NULL;
+   }
+
+   su_free(group->ssc->ssc_home, group->leg);
+   su_free(group->ssc->ssc_home, group);
+}
+
+int ssc_group_add(ssc_group_t *group, ssc_oper_t *op)
+{
+   if (!group || !op)
+   {
+      SSCError("%s: NULL group or operation ptr", __func__);
+      return GRP_FAILURE;
+   }
+
+   if (op->op_group)
+   {
+      SSCError("%s: operation <%p> already belongs to a group", __func__, (void *)op);
+      return GRP_FAILURE;
+   }
+
+   if (group->count == group->capacity)
+   {
+      unsigned capacity = group->capacity * 2;
+      ssc_group_leg_t *leg = (ssc_group_leg_t *)su_realloc(group->ssc->ssc_home,
+            group->leg, capacity * sizeof(ssc_group_leg_t));
+      if (!leg)
+      {
+         SSCError("%s: alloc fail - %u legs", __func__, capacity);
+         return GRP_FAILURE;
+      }
+
+      group->leg = leg;
+      group->capacity = capacity;
+   }
+
+   group->leg[group->count].op = op;
+   group->leg[group->count].mark = 0;
+   group->leg[group->count].pending = 0;
+   ++group->count;
+
+   op->op_group = group;
+
+   return GRP_SUCCESS;
+}
+
+unsigned ssc_group_add_ops(ssc_group_t *group, ssc_oper_t *ops[], unsigned n)
+{
+   unsigned i, added = 0;
+
+   if (!group || !ops) { return 0; }
+
+   for (i=0; i<n; ++i)
+   {
+      if (ops[i] && ssc_group_add(group, ops[i]) == GRP_SUCCESS)
+      {
+         ++added;
+      }
+   }
+
+   return added;
+}
+
+void ssc_group_rem_op(ssc_oper_t *op)
+{
+   if (!op || !op->op_group) { return; }
+
+   ssc_group_t *group = (ssc_group_t *)op->op_group;
+   op->op_group = NULL;
+
+   unsigned i;
+   for (i=0; i<group->count; ++i)
+   {
+      if (group->leg[i].op == op)
+      {
+         break;
+      }
+   }
+
+   if (i == group->count) { return; }
+
+   int pending = group->leg[i].pending;
+
+   // order does not matter; fill the hole with the last leg
+   group->leg[i] = group->leg[--group->count];
+
+   if (pending && group->pending > 0 && --group->pending == 0)
+   {
+      priv_grp_complete(group);
+   }
+}
+
+void ssc_group_op_state(ssc_oper_t *op, int state, int status)
+{
+   if (!op || !op->op_group) { return; }
+
+   ssc_group_t *group = (ssc_group_t *)op->op_group;
+   if (group->state_cb)
+   {
+      group->state_cb(group, op, state, status, group->state_context);
+   }
+}
+
+void ssc_group_set_state_cb(ssc_group_t *group, ssc_group_state_cb cb, void *context)
+{
+   if (!group) { return; }
+
+   group->state_cb = cb;
+   group->state_context = context;
+}
+
+unsigned long ssc_group_get_mark(const ssc_group_t *group, const ssc_oper_t *op)
+{
+   const ssc_group_leg_t *leg = priv_grp_find(group, op);
+
+   return leg ? leg->mark : 0;
+}
+
+int ssc_group_set_mark(ssc_group_t *group, const ssc_oper_t *op, unsigned long mark)
+{
+   ssc_group_leg_t *leg = priv_grp_find(group, op);
+   if (!leg)
+   {
+      SSCError("%s: operation <%p> not in group", __func__, (const void *)op);
+      return GRP_FAILURE;
+   }
+
+   leg->mark = mark;
+
+   return GRP_SUCCESS;
+}
+
+unsigned ssc_group_size(const ssc_group_t *group)
+{
+   return group ? group->count : 0;
+}
+
+ssc_oper_t *ssc_group_get_op(const ssc_group_t *group, unsigned index)
+{
+   if (!group || index >= group->count)
+   {
+      return NULL;
+   }
+
+   return group->leg[index].op;
+}
+
+int ssc_group_bye(ssc_group_t *group, ssc_group_done_cb cb, void *context)
+{
+   return priv_grp_teardown(group, 1, cb, context);
+}
+
+int ssc_group_cancel(ssc_group_t *group, ssc_group_done_cb cb, void *context)
+{
+   return priv_grp_teardown(group, 0, cb, context);
+}
+
+
+/** internal functions follow **/
+
+ssc_group_leg_t *priv_grp_find(const ssc_group_t *group, const ssc_oper_t *op)
+{
+   if (!group || !op || op->op_group != group) { return NULL; }
+
+   unsigned i;
+   for (i=0; i<group->count; ++i)
+   {
+      if (group->leg[i].op == op)
+      {
+         return &group->leg[i];
+      }
+   }
+
+   return NULL;
+}
+
+int priv_grp_is_answered(const ssc_oper_t *op)
+{
+   return op->op_prev_state == nua_callstate_completing ||
+          op->op_prev_state == nua_callstate_completed ||
+          op->op_prev_state == nua_callstate_ready;
+}
+
+int priv_grp_is_calling(const ssc_oper_t *op)
+{
+   return (op->op_callstate & opc_sent) && !priv_grp_is_answered(op);
+}
+
+int priv_grp_teardown(ssc_group_t *group, int bye, ssc_group_done_cb cb, void *context)
+{
+   if (!group)
+   {
+      SSCError("%s: NULL group ptr", __func__);
+      return GRP_FAILURE;
+   }
+
+   if (group->busy)
+   {
+      SSCError("%s: group teardown already pending", __func__);
+      return GRP_FAILURE;
+   }
+
+   group->busy = 1;
+   group->pending = 0;
+   group->byes = 0;
+   group->cancels = 0;
+   group->done_cb = cb;
+   group->done_context = context;
+
+   unsigned i;
+   for (i=0; i<group->count; ++i)
+   {
+      ssc_group_leg_t *leg = &group->leg[i];
+      ssc_oper_t *op = leg->op;
+
+      if (op->op_callstate == opc_none || !op->op_handle)
+      {
+         continue;
+      }
+
+      if (bye && priv_grp_is_answered(op))
+      {
+         ssc_metrics_request(SSC_METRICS_TX, sip_method_bye);
+         nua_bye(op->op_handle, TAG_END());
+         op->op_callstate = opc_none;
+         ++group->byes;
+      }
+      else if (priv_grp_is_calling(op))
+      {
+         ssc_metrics_request(SSC_METRICS_TX, sip_method_cancel);
+         nua_cancel(op->op_handle, TAG_END());
+         ++group->cancels;
+      }
+      else
+      {
+         continue;
+      }
+
+      leg->pending = 1;
+      ++group->pending;
+   }
+
+   SSCDebugHigh("%s: %s: group of %u: %u BYE, %u CANCEL", __func__,
+         group->ssc->ssc_name, group->count, group->byes, group->cancels);
+
+   int sent = (int)group->pending;
+
+   if (group->pending == 0)
+   {
+      // nothing to wait for
+      priv_grp_complete(group);
+   }
+
+   return sent;
+}
+
+void priv_grp_complete(ssc_group_t *group)
+{
+   ssc_group_done_cb cb = group->done_cb;
+   void *context = group->done_context;
+
+   group->busy = 0;
+   group->done_cb = NULL;
+   group->done_context = NULL;
+
+   // last thing done; the callback may destroy the group
+   if (cb)
+   {
+      cb(group, group->byes, group->cancels, context);
+   }
+}
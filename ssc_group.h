@@ -0,0 +1,160 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// groups the operations created for one logical call (for example the
+/// legs of a group call sent with ssc_invite_group()) so they can be torn
+/// down together.
+///
+/// ssc_group_bye() ends every leg, choosing BYE or CANCEL for each one
+/// from its call state; ssc_group_cancel() only cancels the legs that have
+/// not been answered yet.  in both cases the application gets one callback
+/// once every leg that was sent a request has been destroyed, instead of
+/// tracking each operation itself.
+///
+/// an operation belongs to at most one group.  destroyed operations leave
+/// their group automatically.
+
+#include "ssc_sip.h"
+#include "ssc_oper.h"
+
+/// some simple return codes
+#define GRP_SUCCESS   0
+#define GRP_FAILURE  -1
+
+typedef struct ssc_group_s ssc_group_t;
+
+/// called once when every leg torn down by ssc_group_bye() or
+/// ssc_group_cancel() has been destroyed.  it is safe to destroy the group
+/// from inside the callback.
+///
+/// @param[in]  group    the group that completed
+/// @param[in]  byes     number of legs sent a BYE
+/// @param[in]  cancels  number of legs sent a CANCEL
+/// @param[in]  context  context passed to ssc_group_bye()/ssc_group_cancel()
+typedef void (*ssc_group_done_cb)(ssc_group_t *group, unsigned byes, unsigned cancels, void *context);
+
+/// called when the call state of a leg changes, after the operation has
+/// taken the new state.  it is safe to send requests on the leg from
+/// inside the callback, but not to destroy the group.
+///
+/// @param[in]  group    the leg's group
+/// @param[in]  op       the leg
+/// @param[in]  state    new call state (enum nua_callstate)
+/// @param[in]  status   status code of the state event
+/// @param[in]  context  context passed to ssc_group_set_state_cb()
+typedef void (*ssc_group_state_cb)(ssc_group_t *group, ssc_oper_t *op, int state, int status, void *context);
+
+/// create an empty group.
+///
+/// @param[in]  ssc       ptr to SSC context owning the operations
+/// @param[in]  capacity  number of legs to make room for up front (grows as needed)
+///
+/// @return new group, or NULL on failure.
+ssc_group_t *ssc_group_create(ssc_t *ssc, unsigned capacity);
+
+/// release a group.  the operations are detached but not torn down.
+///
+/// @param[in]  group    group to release
+void ssc_group_destroy(ssc_group_t *group);
+
+/// add an operation to the group.
+///
+/// @param[in]  group    group to add to
+/// @param[in]  op       operation to add; must not belong to another group
+///
+/// @return GRP_SUCCESS, or GRP_FAILURE on bad args or alloc failure.
+int ssc_group_add(ssc_group_t *group, ssc_oper_t *op);
+
+/// add the operations returned by ssc_invite_group().  NULL entries are
+/// skipped.
+///
+/// @param[in]  group    group to add to
+/// @param[in]  ops      operations to add
+/// @param[in]  n        number of entries in @p ops
+///
+/// @return number of operations added.
+unsigned ssc_group_add_ops(ssc_group_t *group, ssc_oper_t *ops[], unsigned n);
+
+/// remove an operation from its group, if any.  called by
+/// ssc_oper_destroy().
+///
+/// @param[in]  op       operation to remove
+void ssc_group_rem_op(ssc_oper_t *op);
+
+/// report a call state change of an operation to its group, if any.
+/// called by ssc_i_state().
+///
+/// @param[in]  op       operation whose state changed
+/// @param[in]  state    new call state
+/// @param[in]  status   status code of the state event
+void ssc_group_op_state(ssc_oper_t *op, int state, int status);
+
+/// set the callback for call state changes of the legs.
+///
+/// @param[in]  group    group to watch
+/// @param[in]  cb       [optional] callback, NULL to stop
+/// @param[in]  context  passed to @p cb
+void ssc_group_set_state_cb(ssc_group_t *group, ssc_group_state_cb cb, void *context);
+
+/// per-leg value kept for the owner of the group, e.g. what the leg was
+/// last sent.  it is 0 when the leg is added.
+///
+/// @return the leg's mark, or 0 if @p op is not in the group.
+unsigned long ssc_group_get_mark(const ssc_group_t *group, const ssc_oper_t *op);
+
+/// set the mark of a leg, see ssc_group_get_mark().
+///
+/// @return GRP_SUCCESS, or GRP_FAILURE if @p op is not in the group.
+int ssc_group_set_mark(ssc_group_t *group, const ssc_oper_t *op, unsigned long mark);
+
+/// returns the number of operations in the group.
+unsigned ssc_group_size(const ssc_group_t *group);
+
+/// returns the operation at @p index (0 .. ssc_group_size() - 1).  the
+/// order changes as operations leave the group.
+///
+/// @return the operation, or NULL if @p index is out of range.
+ssc_oper_t *ssc_group_get_op(const ssc_group_t *group, unsigned index);
+
+/// end every leg of the group: established legs are sent a BYE, legs whose
+/// INVITE is still in progress are sent a CANCEL and idle legs are skipped.
+///
+/// @param[in]  group    group to tear down
+/// @param[in]  cb       [optional] called once all torn-down legs are gone
+/// @param[in]  context  passed to @p cb
+///
+/// @return number of legs a request was sent on, or GRP_FAILURE on bad args
+///         or if a teardown is already pending.
+int ssc_group_bye(ssc_group_t *group, ssc_group_done_cb cb, void *context);
+
+/// cancel the legs of the group whose INVITE has not been answered yet.
+/// answered legs are left up.
+///
+/// @param[in]  group    group to cancel
+/// @param[in]  cb       [optional] called once all cancelled legs are gone
+/// @param[in]  context  passed to @p cb
+///
+/// @return number of legs cancelled, or GRP_FAILURE on bad args or if a
+///         teardown is already pending.
+int ssc_group_cancel(ssc_group_t *group, ssc_group_done_cb cb, void *context);
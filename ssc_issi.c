@@ -0,0 +1,193 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef _ISSI
+
+#include "ssc_issi.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sofia-sip/su_alloc.h>
+
+#include "ssc_log.h"
+
+#define ISSI_CONTENT_TYPE "application/x-tia-p25-issi"
+
+// each parameter is absent, 0 or 1
+#define ISSI_PARAM_STATES 3
+#define ISSI_VARIANTS (ISSI_PARAM_STATES * ISSI_PARAM_STATES * ISSI_PARAM_STATES)
+
+typedef struct ssc_issi_part_s
+{
+   char *text;   // delimiter, part headers and parameter lines; NULL until first use
+   size_t len;
+} ssc_issi_part_t;
+
+typedef struct ssc_issi_cache_s
+{
+   ssc_mime_boundary_t boundary;
+   sip_content_type_t *ct;
+
+   // delimiter + part headers of the SDP part
+   char head[SSC_MIME_BOUNDARY_MAX + 64];
+   size_t head_len;
+
+   // closing delimiter
+   char tail[SSC_MIME_BOUNDARY_MAX + 16];
+   size_t tail_len;
+
+   ssc_issi_part_t part[ISSI_VARIANTS];
+} ssc_issi_cache_t;
+
+static ssc_issi_cache_t *priv_issi_cache(ssc_t *ssc);
+static unsigned priv_issi_state(short v);
+static const ssc_issi_part_t *priv_issi_part(ssc_t *ssc, ssc_issi_cache_t *c, const ssc_config_issi_t *issi);
+
+int ssc_issi_invite_body(ssc_t *ssc, const ssc_config_issi_t *issi,
+      const char *sdp, size_t sdp_len,
+      ssc_mime_t *m, sip_payload_t *pl, sip_content_type_t **ct)
+{
+   if (!ssc || !issi || !sdp || !m || !pl || !ct)
+   {
+      SSCError("%s: NULL argument", __func__);
+      return ISSI_FAILURE;
+   }
+
+   ssc_issi_cache_t *c = priv_issi_cache(ssc);
+   if (!c)
+   {
+      return ISSI_FAILURE;
+   }
+
+   const ssc_issi_part_t *p = priv_issi_part(ssc, c, issi);
+   if (!p)
+   {
+      return ISSI_FAILURE;
+   }
+
+   // everything but the SDP comes from the cache
+   if (ssc_mime_reserve(m, c->head_len + sdp_len + p->len + c->tail_len) != MIME_SUCCESS ||
+       ssc_mime_write(m, c->head, c->head_len) != MIME_SUCCESS ||
+       ssc_mime_write(m, sdp, sdp_len) != MIME_SUCCESS ||
+       ssc_mime_write(m, p->text, p->len) != MIME_SUCCESS ||
+       ssc_mime_write(m, c->tail, c->tail_len) != MIME_SUCCESS)
+   {
+      SSCError("%s: failed to write body", __func__);
+      return ISSI_FAILURE;
+   }
+
+   if (ssc_mime_payload(m, pl) != MIME_SUCCESS)
+   {
+      return ISSI_FAILURE;
+   }
+
+   *ct = c->ct;
+
+   return ISSI_SUCCESS;
+}
+
+
+/** internal functions follow **/
+
+ssc_issi_cache_t *priv_issi_cache(ssc_t *ssc)
+{
+   if (ssc->ssc_issi)
+   {
+      return (ssc_issi_cache_t *)ssc->ssc_issi;
+   }
+
+   ssc_issi_cache_t *c = (ssc_issi_cache_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_issi_cache_t));
+   if (!c)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_issi_cache_t));
+      return NULL;
+   }
+
+   ssc_mime_boundary_init(&c->boundary, NULL);
+
+   c->ct = ssc_mime_content_type(ssc->ssc_home, &c->boundary);
+   if (!c->ct)
+   {
+      SSCError("%s: failed to make content type", __func__);
+      su_free(ssc->ssc_home, c);
+      return NULL;
+   }
+
+   c->head_len = snprintf(c->head, sizeof(c->head),
+         "--%s\r\nContent-Type: application/sdp\r\n\r\n", c->boundary.str);
+   c->tail_len = snprintf(c->tail, sizeof(c->tail),
+         "\r\n--%s--\r\n", c->boundary.str);
+
+   ssc->ssc_issi = c;
+
+   return c;
+}
+
+unsigned priv_issi_state(short v)
+{
+   return v < 0 ? 0 : (v == 0 ? 1 : 2);
+}
+
+const ssc_issi_part_t *priv_issi_part(ssc_t *ssc, ssc_issi_cache_t *c, const ssc_config_issi_t *issi)
+{
+   unsigned s_res = priv_issi_state(issi->c_resavail);
+   unsigned s_gct = priv_issi_state(issi->c_groupcalltype);
+   unsigned s_pro = priv_issi_state(issi->c_protected);
+
+   ssc_issi_part_t *p = &c->part[(s_res * ISSI_PARAM_STATES + s_gct) * ISSI_PARAM_STATES + s_pro];
+   if (p->text)
+   {
+      return p;
+   }
+
+   // first use of this combination; render it once
+   char buf[SSC_MIME_BOUNDARY_MAX + 128];
+   int n = snprintf(buf, sizeof(buf),
+         "\r\n--%s\r\nContent-Type: " ISSI_CONTENT_TYPE "\r\n\r\n", c->boundary.str);
+
+   if (s_res)
+   {
+      n += snprintf(buf + n, sizeof(buf) - n, "c-resavail:%u\r\n", s_res - 1);
+   }
+   if (s_gct)
+   {
+      n += snprintf(buf + n, sizeof(buf) - n, "c-groupcalltype:%u\r\n", s_gct - 1);
+   }
+   if (s_pro)
+   {
+      n += snprintf(buf + n, sizeof(buf) - n, "c-protected:%u\r\n", s_pro - 1);
+   }
+
+   p->text = su_strndup(ssc->ssc_home, buf, n);
+   if (!p->text)
+   {
+      SSCError("%s: alloc fail - %d bytes", __func__, n);
+      return NULL;
+   }
+   p->len = (size_t)n;
+
+   return p;
+}
+
+#endif /* _ISSI */
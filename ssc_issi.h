@@ -0,0 +1,64 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// pre-rendered P25 ISSI multipart INVITE bodies.
+///
+/// an ISSI INVITE carries a multipart/mixed body with the SDP and an
+/// application/x-tia-p25-issi part holding the call parameters
+/// (c-resavail, c-groupcalltype, c-protected).  everything but the SDP is
+/// constant for a given combination of parameters, so the delimiter lines,
+/// part headers and parameter part are rendered once per SSC context and
+/// combination, and each call only copies those cached pieces around the
+/// SDP.
+///
+/// used by ssc_invite() when ssc_config_t::p25InviteUseMultipart is set and
+/// no payload or payloadStr is given.
+
+#ifdef _ISSI
+
+#include "ssc_sip.h"
+#include "ssc_mime.h"
+
+/// some simple return codes
+#define ISSI_SUCCESS   0
+#define ISSI_FAILURE  -1
+
+/// build an ISSI multipart INVITE body.
+///
+/// @param[in]  ssc      ptr to SSC context (holds the cache)
+/// @param[in]  issi     ISSI call parameters
+/// @param[in]  sdp      SDP part body
+/// @param[in]  sdp_len  length of @p sdp
+/// @param[in]  m        writer set up with ssc_mime_init(); its boundary
+///                      is not used
+/// @param[out] pl       payload to fill in
+/// @param[out] ct       receives the cached multipart Content-Type; owned
+///                      by the SSC context, do not free.
+///
+/// @return ISSI_SUCCESS, or ISSI_FAILURE on failure.
+int ssc_issi_invite_body(ssc_t *ssc, const ssc_config_issi_t *issi,
+      const char *sdp, size_t sdp_len,
+      ssc_mime_t *m, sip_payload_t *pl, sip_content_type_t **ct);
+
+#endif /* _ISSI */
@@ -24,42 +24,910 @@
 
 #include "ssc_log.h"
 
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
+
+#define LOG_DEFAULT_RING_SIZE (256u * 1024u)
+#define LOG_MIN_RING_SIZE (4u * SSC_LOG_RECORD_MAX)
+
+// longest writer wait when every ring is empty; producers wake it sooner
+#define LOG_WRITER_IDLE_MS 100
+
+// producer back-off while waiting for room under SSC_LOG_OVERFLOW_BLOCK
+#define LOG_BLOCK_WAIT_US 100
+
+// longest timestamp prefix: ISO date, microseconds and thread ID
+#define LOG_STAMP_MAX 64
+
+// per-thread buffered sink; holds whole records only
+typedef struct ssc_log_sink_s
+{
+   char *buf;
+   size_t len;
+   size_t size;
+   uint64_t firstMs;     // when the oldest buffered record was added
+} ssc_log_sink_t;
+
+// per-thread timestamp cache; the text up to the seconds is only
+// reformatted when the second changes
+typedef struct ssc_log_stamp_cache_s
+{
+   time_t sec;
+   unsigned flags;       // sscLogStampFlags the text was made for
+   size_t len;
+   char text[32];        // "HH:MM:SS." or "YYYY-MM-DDTHH:MM:SS."
+
+   size_t tidLen;        // thread ID text, 0 until first use
+   char tid[16];
+} ssc_log_stamp_cache_t;
+
+// single-producer single-consumer byte ring. each record is a uint32_t
+// length followed by the record bytes; both may wrap around the end.
+// head is only written by the owning thread, tail only by the writer.
+typedef struct ssc_log_ring_s
+{
+   struct ssc_log_ring_s *next;
+   char *buf;
+   size_t mask;
+   int dead;            // owning thread has exited; writer frees it once empty
+
+   uint64_t head __attribute__((aligned(64)));
+   uint64_t tail __attribute__((aligned(64)));
+} ssc_log_ring_t;
 
 static FILE *globalLogFile = NULL;
 
-// Must be called from main thread
+int sscLogLevel = SSC_LOG_LOW;
+static unsigned sscLogStampFlags = 0;
+static __thread ssc_log_stamp_cache_t stampCache = { .sec = -1 };
+static int sscLogFormat = SSC_LOG_FORMAT_TEXT;
+static __thread const ssc_log_kv_t *threadKv = NULL;
+
+static const char *const levelLabel[] = { "LOW   ", "MED   ", "HIGH  ", "WARN  ", "ERROR " };
+static const char *const levelName[] = { "LOW", "MED", "HIGH", "WARN", "ERROR" };
+
+// per-thread sink settings; 0 size means records are written straight out
+static size_t sinkSize = 0;
+static unsigned sinkDelayMs = 0;
+static pthread_once_t sinkKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t sinkKey;
+static __thread ssc_log_sink_t threadSink;
+__thread int sscLogCtxLevel = SSC_LOG_NONE;
+
+// async backend state
+static int asyncRunning = 0;
+static int asyncStopping = 0;
+static size_t asyncRingSize = LOG_DEFAULT_RING_SIZE;
+static ssc_log_overflow_t asyncOverflow = SSC_LOG_OVERFLOW_DROP;
+static unsigned long asyncDropped = 0;
+static unsigned long asyncDroppedReported = 0;
+static pthread_t asyncWriter;
+
+// ring list is only locked when a thread registers its ring and by the
+// writer to walk or unlink rings, never on the logging path itself and
+// never while writing
+static pthread_mutex_t asyncRingsLock = PTHREAD_MUTEX_INITIALIZER;
+static ssc_log_ring_t *asyncRings = NULL;
+
+// idle writer waits here; producers only take the lock when it is idle
+static pthread_mutex_t asyncWakeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t asyncWake = PTHREAD_COND_INITIALIZER;
+static int asyncIdle = 0;
+
+// serializes output to the log file between the writer and sscSetLogFile()
+static pthread_mutex_t asyncFileLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t asyncKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t asyncKey;
+static __thread ssc_log_ring_t *threadRing = NULL;
+
+static size_t priv_log_stamp(char *buf, size_t size, int kv);
+static size_t priv_log_format(char *buf, size_t size, int level,
+      const char *file, unsigned line, const char *fmt, va_list ap);
+static size_t priv_log_format_kv(char *buf, size_t size, size_t len, int level,
+      const char *file, unsigned line, const char *fmt, va_list ap);
+static void priv_log_emit(int level, const char *rec, size_t len);
+static void priv_log_sink_key_init(void);
+static void priv_log_sink_release(void *arg);
+static void priv_log_sink_flush(ssc_log_sink_t *sk);
+static uint64_t priv_log_clock_ms(void);
+static bool priv_log_async_push(const char *rec, uint32_t len);
+static ssc_log_ring_t *priv_log_ring_get(void);
+static void priv_log_key_init(void);
+static void priv_log_ring_release(void *arg);
+static void priv_log_ring_copy_in(ssc_log_ring_t *r, uint64_t pos, const void *src, size_t len);
+static void priv_log_ring_copy_out(const ssc_log_ring_t *r, uint64_t pos, void *dst, size_t len);
+static size_t priv_log_drain(FILE *logFile);
+static bool priv_log_pending(void);
+static void priv_log_wake(void);
+static void *priv_log_writer(void *arg);
+static void priv_log_sleep_us(long us);
+
+// may be called from any thread. with the async backend running, records
+// already queued are written to the old file before the switch.
 void sscSetLogFile(FILE *logFile)
 {
-   globalLogFile = logFile;
+   if (!__atomic_load_n(&asyncRunning, __ATOMIC_ACQUIRE))
+   {
+      __atomic_store_n(&globalLogFile, logFile, __ATOMIC_RELEASE);
+      return;
+   }
+
+   // flush what is queued to the old file so the caller can close it
+   pthread_mutex_lock(&asyncFileLock);
+   priv_log_drain(sscGetLogFile());
+   __atomic_store_n(&globalLogFile, logFile, __ATOMIC_RELEASE);
+   pthread_mutex_unlock(&asyncFileLock);
 }
 
-// Must be called from main thread
 FILE *sscGetLogFile()
 {
-   if (globalLogFile == NULL)
+   FILE *logFile = __atomic_load_n(&globalLogFile, __ATOMIC_ACQUIRE);
+   if (logFile == NULL)
    {
       return stdout;
    }
-   return globalLogFile;
+   return logFile;
+}
+
+// Must be called from main thread
+void sscSetLogLevel(int level)
+{
+   sscLogLevel = level;
+}
+
+int sscGetLogLevel()
+{
+   return sscLogLevel;
+}
+
+// Must be called from main thread
+void sscSetLogStamp(unsigned flags)
+{
+   __atomic_store_n(&sscLogStampFlags, flags, __ATOMIC_RELAXED);
 }
 
 void sscLogTimestamp(FILE *logFile)
 {
-   struct timeval stamp;
-   struct tm hms;
-   gettimeofday(&stamp, NULL);
-   gmtime_r(&stamp.tv_sec, &hms);
-   fprintf(
-         logFile,
-         "%02d:%02d:%02d.%06ld ",
-         hms.tm_hour,
-         hms.tm_min,
-         hms.tm_sec,
-         stamp.tv_usec);
+   char stamp[LOG_STAMP_MAX];
+   size_t len = priv_log_stamp(stamp, sizeof(stamp), 0);
+   fwrite(stamp, 1, len, logFile);
+}
+
+void sscLogVPrintf(const char *fmt, va_list ap)
+{
+   char rec[SSC_LOG_RECORD_MAX];
+   size_t len = priv_log_format(rec, sizeof(rec), -1, NULL, 0, fmt, ap);
+   priv_log_emit(SSC_LOG_LOW, rec, len);
+}
+
+void sscLogPrintf(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   sscLogVPrintf(fmt, ap);
+   va_end(ap);
+}
+
+void sscLogRecord(int level, const char *file, unsigned line, const char *fmt, ...)
+{
+   char rec[SSC_LOG_RECORD_MAX];
+   va_list ap;
+
+   va_start(ap, fmt);
+   size_t len = priv_log_format(rec, sizeof(rec), level, file, line, fmt, ap);
+   va_end(ap);
+
+   if (len < sizeof(rec) || __atomic_load_n(&asyncRunning, __ATOMIC_ACQUIRE))
+   {
+      priv_log_emit(level, rec, len < sizeof(rec) ? len : sizeof(rec) - 1);
+      return;
+   }
+
+   // too long for the stack buffer; only the async rings truncate
+   char *big = (char *)malloc(len + 1);
+   if (!big)
+   {
+      priv_log_emit(level, rec, sizeof(rec) - 1);
+      return;
+   }
+
+   va_start(ap, fmt);
+   len = priv_log_format(big, len + 1, level, file, line, fmt, ap);
+   va_end(ap);
+
+   priv_log_emit(level, big, len);
+   free(big);
+}
+
+// Must be called from main thread
+void sscSetLogFormat(int format)
+{
+   __atomic_store_n(&sscLogFormat, format, __ATOMIC_RELAXED);
+}
+
+const ssc_log_kv_t *sscLogKvPush(const ssc_log_kv_t *kv)
+{
+   const ssc_log_kv_t *saved = threadKv;
+   threadKv = kv;
+   return saved;
+}
+
+void sscLogKvPop(const ssc_log_kv_t *saved)
+{
+   threadKv = saved;
+}
+
+// Must be called from main thread
+int sscSetLogThreadBuffer(size_t size, unsigned maxDelayMs)
+{
+   if (pthread_once(&sinkKeyOnce, priv_log_sink_key_init) != 0)
+   {
+      SSCError("%s: failed to create thread key", __func__);
+      return -1;
+   }
+
+   if (size && size < SSC_LOG_RECORD_MAX)
+   {
+      size = SSC_LOG_RECORD_MAX;
+   }
+
+   __atomic_store_n(&sinkDelayMs, maxDelayMs, __ATOMIC_RELAXED);
+   __atomic_store_n(&sinkSize, size, __ATOMIC_RELEASE);
+
+   return 0;
+}
+
+void sscLogFlush(void)
+{
+   priv_log_sink_flush(&threadSink);
+}
+
+// Must be called from main thread
+int sscLogAsyncStart(size_t ringSize, ssc_log_overflow_t overflow)
+{
+   if (__atomic_load_n(&asyncRunning, __ATOMIC_ACQUIRE))
+   {
+      SSCError("%s: async logging already running", __func__);
+      return -1;
+   }
+
+   if (pthread_once(&asyncKeyOnce, priv_log_key_init) != 0)
+   {
+      SSCError("%s: failed to create thread key", __func__);
+      return -1;
+   }
+
+   size_t size = LOG_MIN_RING_SIZE;
+   if (ringSize == 0)
+   {
+      ringSize = LOG_DEFAULT_RING_SIZE;
+   }
+   while (size < ringSize)
+   {
+      size <<= 1;
+   }
+
+   asyncRingSize = size;
+   asyncOverflow = overflow;
+   asyncStopping = 0;
+
+   int rv = pthread_create(&asyncWriter, NULL, priv_log_writer, NULL);
+   if (rv != 0)
+   {
+      SSCError("%s: failed to start writer thread: %s", __func__, strerror(rv));
+      return -1;
+   }
+
+   __atomic_store_n(&asyncRunning, 1, __ATOMIC_RELEASE);
+
+   return 0;
+}
+
+// Must be called from main thread
+void sscLogAsyncStop(void)
+{
+   if (!__atomic_load_n(&asyncRunning, __ATOMIC_ACQUIRE))
+   {
+      return;
+   }
+
+   __atomic_store_n(&asyncRunning, 0, __ATOMIC_RELEASE);
+   __atomic_store_n(&asyncStopping, 1, __ATOMIC_RELEASE);
+
+   pthread_mutex_lock(&asyncWakeLock);
+   pthread_cond_signal(&asyncWake);
+   pthread_mutex_unlock(&asyncWakeLock);
+
+   pthread_join(asyncWriter, NULL);
+
+   // pick up anything pushed while the writer was shutting down
+   pthread_mutex_lock(&asyncFileLock);
+   priv_log_drain(sscGetLogFile());
+   pthread_mutex_unlock(&asyncFileLock);
+}
+
+unsigned long sscLogAsyncDropped(void)
+{
+   return __atomic_load_n(&asyncDropped, __ATOMIC_RELAXED);
+}
+
+
+/** internal functions follow **/
+
+// format the line timestamp into @p buf, which must hold LOG_STAMP_MAX bytes.
+// with @p kv set the fields are written as "ts=... tid=... ".
+// @return length written
+size_t priv_log_stamp(char *buf, size_t size, int kv)
+{
+   ssc_log_stamp_cache_t *c = &stampCache;
+   unsigned flags = __atomic_load_n(&sscLogStampFlags, __ATOMIC_RELAXED);
+
+   if (size < LOG_STAMP_MAX)
+   {
+      if (size) { buf[0] = '\0'; }
+      return 0;
+   }
+
+   struct timespec ts;
+   clock_gettime((flags & SSC_LOG_STAMP_COARSE) ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME, &ts);
+
+   if (ts.tv_sec != c->sec || flags != c->flags)
+   {
+      struct tm hms;
+      gmtime_r(&ts.tv_sec, &hms);
+      int n;
+      if (flags & SSC_LOG_STAMP_ISO)
+      {
+         n = snprintf(c->text, sizeof(c->text), "%04d-%02d-%02dT%02d:%02d:%02d.",
+               hms.tm_year + 1900, hms.tm_mon + 1, hms.tm_mday,
+               hms.tm_hour, hms.tm_min, hms.tm_sec);
+      }
+      else
+      {
+         n = snprintf(c->text, sizeof(c->text), "%02d:%02d:%02d.",
+               hms.tm_hour, hms.tm_min, hms.tm_sec);
+      }
+      c->len = (n > 0 && (size_t)n < sizeof(c->text)) ? (size_t)n : 0;
+      c->sec = ts.tv_sec;
+      c->flags = flags;
+   }
+
+   char *p = buf;
+   if (kv)
+   {
+      memcpy(p, "ts=", 3);
+      p += 3;
+   }
+   memcpy(p, c->text, c->len);
+   p += c->len;
+
+   // microseconds, always six digits
+   unsigned us = (unsigned)(ts.tv_nsec / 1000);
+   int i;
+   for (i = 5; i >= 0; --i)
+   {
+      p[i] = (char)('0' + us % 10);
+      us /= 10;
+   }
+   p += 6;
+
+   if (flags & SSC_LOG_STAMP_ISO)
+   {
+      *p++ = 'Z';
+   }
+   *p++ = ' ';
+
+   if (flags & SSC_LOG_STAMP_TID)
+   {
+      if (!c->tidLen)
+      {
+         int n = snprintf(c->tid, sizeof(c->tid), "%ld ", (long)syscall(SYS_gettid));
+         c->tidLen = (n > 0 && (size_t)n < sizeof(c->tid)) ? (size_t)n : 0;
+      }
+      if (kv)
+      {
+         memcpy(p, "tid=", 4);
+         p += 4;
+      }
+      memcpy(p, c->tid, c->tidLen);
+      p += c->tidLen;
+   }
+
+   *p = '\0';
+   return (size_t)(p - buf);
+}
+
+bool priv_log_async_push(const char *rec, uint32_t len)
+{
+   ssc_log_ring_t *r = priv_log_ring_get();
+   if (!r)
+   {
+      return false;
+   }
+
+   size_t need = sizeof(uint32_t) + len;
+   size_t size = r->mask + 1;
+   uint64_t head = r->head;
+
+   while (size - (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE)) < need)
+   {
+      if (asyncOverflow != SSC_LOG_OVERFLOW_BLOCK ||
+          !__atomic_load_n(&asyncRunning, __ATOMIC_ACQUIRE))
+      {
+         return false;
+      }
+      priv_log_sleep_us(LOG_BLOCK_WAIT_US);
+   }
+
+   priv_log_ring_copy_in(r, head, &len, sizeof(len));
+   priv_log_ring_copy_in(r, head + sizeof(len), rec, len);
+   __atomic_store_n(&r->head, head + need, __ATOMIC_RELEASE);
+
+   priv_log_wake();
+
+   return true;
+}
+
+ssc_log_ring_t *priv_log_ring_get(void)
+{
+   if (threadRing)
+   {
+      return threadRing;
+   }
+
+   ssc_log_ring_t *r = (ssc_log_ring_t *)calloc(1, sizeof(ssc_log_ring_t));
+   if (!r)
+   {
+      return NULL;
+   }
+
+   r->buf = (char *)malloc(asyncRingSize);
+   if (!r->buf)
+   {
+      free(r);
+      return NULL;
+   }
+   r->mask = asyncRingSize - 1;
+
+   // once per thread; the writer never holds this lock while writing
+   pthread_mutex_lock(&asyncRingsLock);
+   r->next = asyncRings;
+   asyncRings = r;
+   pthread_mutex_unlock(&asyncRingsLock);
+
+   pthread_setspecific(asyncKey, r);
+   threadRing = r;
+
+   return r;
+}
+
+void priv_log_key_init(void)
+{
+   pthread_key_create(&asyncKey, priv_log_ring_release);
+}
+
+void priv_log_ring_release(void *arg)
+{
+   ssc_log_ring_t *r = (ssc_log_ring_t *)arg;
+   __atomic_store_n(&r->dead, 1, __ATOMIC_RELEASE);
+}
+
+void priv_log_ring_copy_in(ssc_log_ring_t *r, uint64_t pos, const void *src, size_t len)
+{
+   size_t off = (size_t)pos & r->mask;
+   size_t first = r->mask + 1 - off;
+   if (first > len) { first = len; }
+
+   memcpy(r->buf + off, src, first);
+   memcpy(r->buf, (const char *)src + first, len - first);
+}
+
+void priv_log_ring_copy_out(const ssc_log_ring_t *r, uint64_t pos, void *dst, size_t len)
+{
+   size_t off = (size_t)pos & r->mask;
+   size_t first = r->mask + 1 - off;
+   if (first > len) { first = len; }
+
+   memcpy(dst, r->buf + off, first);
+   memcpy((char *)dst + first, r->buf, len - first);
+}
+
+// write out every queued record. caller holds asyncFileLock, which also
+// makes this the only place rings are unlinked: the list is walked from a
+// snapshot of its head without asyncRingsLock (new rings are only pushed
+// in front of it), so the fwrites never block a thread registering a ring.
+// @return number of lines written
+size_t priv_log_drain(FILE *logFile)
+{
+   size_t count = 0;
+   char rec[SSC_LOG_RECORD_MAX];
+
+   pthread_mutex_lock(&asyncRingsLock);
+   ssc_log_ring_t *r = asyncRings;
+   pthread_mutex_unlock(&asyncRingsLock);
+
+   while (r)
+   {
+      ssc_log_ring_t *next = r->next;
+
+      // check before reading head so nothing pushed before exit is lost
+      int dead = __atomic_load_n(&r->dead, __ATOMIC_ACQUIRE);
+      uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+      uint64_t tail = r->tail;
+
+      while (tail != head)
+      {
+         uint32_t len;
+         priv_log_ring_copy_out(r, tail, &len, sizeof(len));
+         priv_log_ring_copy_out(r, tail + sizeof(len), rec, len);
+         tail += sizeof(len) + len;
+
+         // hand the slot back before the write so a blocked producer can go on
+         __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+         fwrite(rec, 1, len, logFile);
+         ++count;
+      }
+
+      if (dead)
+      {
+         pthread_mutex_lock(&asyncRingsLock);
+         ssc_log_ring_t **pr = &asyncRings;
+         while (*pr != r)
+         {
+            pr = &(*pr)->next;
+         }
+         *pr = next;
+         pthread_mutex_unlock(&asyncRingsLock);
+
+         free(r->buf);
+         free(r);
+      }
+
+      r = next;
+   }
+
+   unsigned long dropped = __atomic_load_n(&asyncDropped, __ATOMIC_RELAXED);
+   if (dropped != asyncDroppedReported)
+   {
+      sscLogTimestamp(logFile);
+      fprintf(logFile, "[WARN  ] %s:%u:: %lu log record(s) dropped, ring full\n",
+            __FILE__, __LINE__, dropped - asyncDroppedReported);
+      asyncDroppedReported = dropped;
+      ++count;
+   }
+
+   if (count)
+   {
+      fflush(logFile);
+   }
+
+   return count;
+}
+
+// true if any ring holds a record the writer has not taken yet
+bool priv_log_pending(void)
+{
+   bool pending = false;
+
+   pthread_mutex_lock(&asyncRingsLock);
+   ssc_log_ring_t *r;
+   for (r = asyncRings; r && !pending; r = r->next)
+   {
+      pending = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) != __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+   }
+   pthread_mutex_unlock(&asyncRingsLock);
+
+   return pending;
+}
+
+// called by a producer after publishing a record.  pairs with the writer
+// setting asyncIdle before it rechecks the rings, so either the writer
+// sees the record or the producer sees it idle.
+void priv_log_wake(void)
+{
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if (!__atomic_load_n(&asyncIdle, __ATOMIC_RELAXED))
+   {
+      return;
+   }
+
+   pthread_mutex_lock(&asyncWakeLock);
+   pthread_cond_signal(&asyncWake);
+   pthread_mutex_unlock(&asyncWakeLock);
+}
+
+void *priv_log_writer(void *arg)
+{
+   (void)arg;
+
+   // leave signal handling to the application threads
+   sigset_t all;
+   sigfillset(&all);
+   pthread_sigmask(SIG_BLOCK, &all, NULL);
+
+   while (!__atomic_load_n(&asyncStopping, __ATOMIC_ACQUIRE))
+   {
+      pthread_mutex_lock(&asyncFileLock);
+      size_t count = priv_log_drain(sscGetLogFile());
+      pthread_mutex_unlock(&asyncFileLock);
+
+      if (count)
+      {
+         continue;
+      }
+
+      // nothing queued: sleep until a producer signals, the timeout only
+      // bounds how late a drop report can be
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += LOG_WRITER_IDLE_MS * 1000000L;
+      if (deadline.tv_nsec >= 1000000000L)
+      {
+         deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+         deadline.tv_nsec %= 1000000000L;
+      }
+
+      pthread_mutex_lock(&asyncWakeLock);
+      __atomic_store_n(&asyncIdle, 1, __ATOMIC_SEQ_CST);
+      if (!__atomic_load_n(&asyncStopping, __ATOMIC_ACQUIRE) && !priv_log_pending())
+      {
+         pthread_cond_timedwait(&asyncWake, &asyncWakeLock, &deadline);
+      }
+      __atomic_store_n(&asyncIdle, 0, __ATOMIC_RELAXED);
+      pthread_mutex_unlock(&asyncWakeLock);
+   }
+
+   return NULL;
+}
+
+// build one record into @p buf: the timestamp, then the text or key/value
+// layout of the message.  @p level < 0 writes the bare message.
+// @return full record length; if it is >= @p size the record was truncated
+// and keeps its trailing newline.
+size_t priv_log_format(char *buf, size_t size, int level,
+      const char *file, unsigned line, const char *fmt, va_list ap)
+{
+   int kv = __atomic_load_n(&sscLogFormat, __ATOMIC_RELAXED) == SSC_LOG_FORMAT_KV;
+   size_t len = priv_log_stamp(buf, size, kv);
+   size_t need;
+
+   if (level > SSC_LOG_ERROR)
+   {
+      level = SSC_LOG_ERROR;
+   }
+
+   if (kv)
+   {
+      need = priv_log_format_kv(buf, size, len, level, file, line, fmt, ap);
+   }
+   else
+   {
+      if (level >= 0)
+      {
+         int n = snprintf(buf + len, size - len, "[%s] %s:%u:: ", levelLabel[level], file, line);
+         len += (n > 0) ? (size_t)n : 0;
+         if (len >= size) { len = size - 1; }
+      }
+
+      int n = vsnprintf(buf + len, size - len, fmt, ap);
+      need = len + ((n > 0) ? (size_t)n : 0);
+
+      // the bare form carries its own line ends
+      if (level >= 0)
+      {
+         if (need + 1 < size)
+         {
+            buf[need] = '\n';
+            buf[need + 1] = '\0';
+         }
+         ++need;
+      }
+   }
+
+   if (need >= size)
+   {
+      buf[size - 2] = '\n';
+      buf[size - 1] = '\0';
+   }
+
+   return need;
+}
+
+// key/value layout: ... level= file= line= [op= method= status= callid=] msg="..."
+size_t priv_log_format_kv(char *buf, size_t size, size_t len, int level,
+      const char *file, unsigned line, const char *fmt, va_list ap)
+{
+   const ssc_log_kv_t *kv = threadKv;
+   int n;
+
+   if (level >= 0)
+   {
+      n = snprintf(buf + len, size - len, "level=%s file=%s line=%u ",
+            levelName[level], file, line);
+      len += (n > 0) ? (size_t)n : 0;
+   }
+
+   if (kv && len < size)
+   {
+      n = 0;
+      if (kv->op)
+      {
+         n = snprintf(buf + len, size - len, "op=%p ", kv->op);
+         len += (n > 0) ? (size_t)n : 0;
+      }
+      if (kv->method && len < size)
+      {
+         n = snprintf(buf + len, size - len, "method=%s ", kv->method);
+         len += (n > 0) ? (size_t)n : 0;
+      }
+      if (kv->status && len < size)
+      {
+         n = snprintf(buf + len, size - len, "status=%d ", kv->status);
+         len += (n > 0) ? (size_t)n : 0;
+      }
+      if (kv->callid && kv->callid[0] && len < size)
+      {
+         n = snprintf(buf + len, size - len, "callid=%s ", kv->callid);
+         len += (n > 0) ? (size_t)n : 0;
+      }
+   }
+
+   if (len + 8 >= size)
+   {
+      return size;
+   }
+
+   // message goes in quotes; escape what would break the field
+   char msg[SSC_LOG_RECORD_MAX];
+   n = vsnprintf(msg, sizeof(msg), fmt, ap);
+   size_t mlen = (n < 0) ? 0 : ((size_t)n < sizeof(msg) ? (size_t)n : sizeof(msg) - 1);
+   while (mlen && (msg[mlen - 1] == '\n' || msg[mlen - 1] == '\r'))
+   {
+      --mlen;
+   }
+
+   char *p = buf + len;
+   char *end = buf + size - 3;    // room for the closing quote, newline and NUL
+   size_t i;
+
+   memcpy(p, "msg=\"", 5);
+   p += 5;
+   for (i = 0; i < mlen && p < end - 1; ++i)
+   {
+      char ch = msg[i];
+      if (ch == '"' || ch == '\\')
+      {
+         *p++ = '\\';
+         *p++ = ch;
+      }
+      else if (ch == '\n' || ch == '\r' || ch == '\t')
+      {
+         *p++ = '\\';
+         *p++ = (ch == '\n') ? 'n' : (ch == '\r') ? 'r' : 't';
+      }
+      else
+      {
+         *p++ = ch;
+      }
+   }
+   *p++ = '"';
+   *p++ = '\n';
+   *p = '\0';
+
+   return (size_t)(p - buf);
+}
+
+// hand a finished record to the async rings, the thread's sink or the file
+void priv_log_emit(int level, const char *rec, size_t len)
+{
+   if (__atomic_load_n(&asyncRunning, __ATOMIC_ACQUIRE))
+   {
+      if (len >= SSC_LOG_RECORD_MAX)
+      {
+         len = SSC_LOG_RECORD_MAX - 1;
+      }
+      if (!priv_log_async_push(rec, (uint32_t)len))
+      {
+         __atomic_fetch_add(&asyncDropped, 1, __ATOMIC_RELAXED);
+      }
+      return;
+   }
+
+   ssc_log_sink_t *sk = &threadSink;
+   size_t want = __atomic_load_n(&sinkSize, __ATOMIC_ACQUIRE);
+
+   if (sk->size != want)
+   {
+      // buffering was switched on, off or resized since this thread last logged
+      priv_log_sink_flush(sk);
+      free(sk->buf);
+      sk->buf = want ? (char *)malloc(want) : NULL;
+      sk->size = sk->buf ? want : 0;
+      if (sk->buf)
+      {
+         pthread_setspecific(sinkKey, sk);
+      }
+   }
+
+   if (!sk->size || len > sk->size)
+   {
+      // one fwrite per record, so threads never split each other's lines
+      priv_log_sink_flush(sk);
+      FILE *logFile = sscGetLogFile();
+      fwrite(rec, 1, len, logFile);
+      fflush(logFile);
+      return;
+   }
+
+   if (len > sk->size - sk->len)
+   {
+      priv_log_sink_flush(sk);
+   }
+
+   uint64_t now = priv_log_clock_ms();
+   if (sk->len == 0)
+   {
+      sk->firstMs = now;
+   }
+   memcpy(sk->buf + sk->len, rec, len);
+   sk->len += len;
+
+   if (level >= SSC_LOG_WARN ||
+       now - sk->firstMs >= __atomic_load_n(&sinkDelayMs, __ATOMIC_RELAXED))
+   {
+      priv_log_sink_flush(sk);
+   }
+}
+
+void priv_log_sink_key_init(void)
+{
+   pthread_key_create(&sinkKey, priv_log_sink_release);
+}
+
+void priv_log_sink_release(void *arg)
+{
+   ssc_log_sink_t *sk = (ssc_log_sink_t *)arg;
+   priv_log_sink_flush(sk);
+   free(sk->buf);
+   sk->buf = NULL;
+   sk->size = 0;
+}
+
+void priv_log_sink_flush(ssc_log_sink_t *sk)
+{
+   if (!sk->len) { return; }
+
+   FILE *logFile = sscGetLogFile();
+   fwrite(sk->buf, 1, sk->len, logFile);
+   fflush(logFile);
+   sk->len = 0;
+}
+
+uint64_t priv_log_clock_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+   return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
 }
 
+void priv_log_sleep_us(long us)
+{
+   struct timespec ts;
+   ts.tv_sec = us / 1000000;
+   ts.tv_nsec = (us % 1000000) * 1000;
+   while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+   {
+   }
+}
@@ -43,37 +43,150 @@ extern FILE *sscGetLogFile();
 extern void sscSetLogFile(FILE *logFile);
 extern void sscLogTimestamp(FILE *logFile);
 
+/// timestamp options for sscSetLogStamp(). the default is "HH:MM:SS.uuuuuu"
+/// from CLOCK_REALTIME.  with ISO and TID set, each line starts with the
+/// structured prefix "YYYY-MM-DDTHH:MM:SS.uuuuuuZ <tid> [LEVEL ] ".
+#define SSC_LOG_STAMP_COARSE  0x1   ///< use CLOCK_REALTIME_COARSE; cheaper, ms resolution
+#define SSC_LOG_STAMP_ISO     0x2   ///< ISO 8601 date and time in UTC
+#define SSC_LOG_STAMP_TID     0x4   ///< kernel thread ID after the timestamp
+extern void sscSetLogStamp(unsigned flags);
+
+/// log levels, least severe first
+#define SSC_LOG_LOW     0
+#define SSC_LOG_MED     1
+#define SSC_LOG_HIGH    2
+#define SSC_LOG_WARN    3
+#define SSC_LOG_ERROR   4
+#define SSC_LOG_NONE    5
+
+/// compile-time minimum log level. calls below this level are folded away
+/// by the compiler, arguments included.  e.g. build with
+/// -D SSC_LOG_MIN_LEVEL=SSC_LOG_WARN to drop all debug output.
+#ifndef SSC_LOG_MIN_LEVEL
+#define SSC_LOG_MIN_LEVEL SSC_LOG_LOW
+#endif
+
+/// runtime minimum log level; read on every log call, so keep it a plain int.
+/// use sscSetLogLevel() to change it.
+extern int sscLogLevel;
+extern void sscSetLogLevel(int level);
+extern int sscGetLogLevel();
+
+/// per-thread level override for the call or SSC context being worked on
+/// (see ssc_log_ctx.h); SSC_LOG_NONE when there is none.
+extern __thread int sscLogCtxLevel;
+
+/// true if a message at @p lvl would be written. use this to guard
+/// expensive work done only to produce log output.
+#define SSCLogEnabled(lvl)                                                      \
+   ((lvl) >= SSC_LOG_MIN_LEVEL &&                                              \
+    ((lvl) >= sscLogLevel || (lvl) >= sscLogCtxLevel))
+
 extern const char *DEFAULT_LOG_FILE_PATH;
 #define MAX_LOG_PATH_LEN 256
 
-#define SSCLogVarArgBase(fmt, ...)                                              \
-   do                                                                          \
-   {                                                                           \
-      FILE *SSCLogVarArgBase_logFile = sscGetLogFile();                        \
-      sscLogTimestamp(SSCLogVarArgBase_logFile);                                   \
-      vfprintf(SSCLogVarArgBase_logFile, fmt, ##__VA_ARGS__);                   \
-      fflush(SSCLogVarArgBase_logFile);                                         \
-   } while (0)
+/// asynchronous backend. while running, each log record is formatted on
+/// the calling thread, copied into that thread's lock-free ring and written
+/// out by a background writer thread.  sscSetLogFile() keeps working; it
+/// drains the rings into the old file before switching.
+typedef enum
+{
+   SSC_LOG_OVERFLOW_DROP,   ///< ring full: drop the record and count it
+   SSC_LOG_OVERFLOW_BLOCK   ///< ring full: wait for the writer to make room
+} ssc_log_overflow_t;
+
+/// longest record kept by the async backend; longer ones are truncated
+#define SSC_LOG_RECORD_MAX 2048
+
+/// start the async writer thread.
+/// @param[in] ringSize  bytes per thread ring, rounded up to a power of two
+///                      (0 selects the default of 256 KiB)
+/// @param[in] overflow  what a thread does when its ring is full
+/// @return 0 on success, -1 on failure
+extern int sscLogAsyncStart(size_t ringSize, ssc_log_overflow_t overflow);
+
+/// write out everything still queued and stop the writer thread. threads
+/// that keep logging afterwards fall back to synchronous writes.
+extern void sscLogAsyncStop(void);
+
+/// @return number of records dropped because a ring was full
+extern unsigned long sscLogAsyncDropped(void);
+
+/// record layouts for sscSetLogFormat()
+#define SSC_LOG_FORMAT_TEXT   0   ///< "<stamp> [LEVEL ] file:line:: message"
+#define SSC_LOG_FORMAT_KV     1   ///< "ts=.. level=.. file=.. line=.. [op=.. method=..
+                                  ///  status=.. callid=..] msg=\"..\""
+extern void sscSetLogFormat(int format);
+
+/// key/value fields added to each record in SSC_LOG_FORMAT_KV. a thread
+/// pushes the fields of the operation it works on and pops them when done;
+/// unset fields (NULL or 0) are left out.
+typedef struct ssc_log_kv_s
+{
+   const void *op;
+   const char *method;
+   int status;
+   const char *callid;
+} ssc_log_kv_t;
+
+/// make @p kv the calling thread's current fields; it must stay valid
+/// until popped.  @return previous fields, to pass to sscLogKvPop()
+extern const ssc_log_kv_t *sscLogKvPush(const ssc_log_kv_t *kv);
+extern void sscLogKvPop(const ssc_log_kv_t *saved);
+
+/// per-thread buffered sinks. each thread collects whole records in its own
+/// buffer of @p size bytes and writes them out with a single call when the
+/// buffer is full, a WARN or ERROR record arrives, the thread logs a record
+/// once its oldest buffered one is @p maxDelayMs old, the thread calls
+/// sscLogFlush() or the thread exits.  the delay is only checked on the
+/// thread's next log call: nothing flushes the buffer of a thread that has
+/// gone quiet, so a thread that may sit idle (an event loop, for one)
+/// should call sscLogFlush() from its own timer.
+/// size 0 (the default) writes every record as it is made.  either way each
+/// record goes out in one write, so threads do not interleave partial lines.
+/// @return 0 on success, -1 on failure
+extern int sscSetLogThreadBuffer(size_t size, unsigned maxDelayMs);
+
+/// write out the calling thread's buffered records
+extern void sscLogFlush(void);
+
+#include <stdarg.h>
+#include "ssc_blog.h"
+extern void sscLogVPrintf(const char *fmt, va_list ap);
+extern void sscLogPrintf(const char *fmt, ...)
+   __attribute__((format(printf, 1, 2)));
+extern void sscLogRecord(int level, const char *file, unsigned line, const char *fmt, ...)
+   __attribute__((format(printf, 4, 5)));
+
+#define SSCLogVarArgBase(fmt, ...) sscLogVPrintf(fmt, ##__VA_ARGS__)
 
 #define SSCLogMacroBase(level, zzz, ...)                                        \
+   sscLogRecord(level, __FILE__, __LINE__, zzz, ##__VA_ARGS__)
+
+// level check comes first so nothing below the active level evaluates
+// its arguments, takes a timestamp or touches the log file.
+// each call site also gets a static ssc_blog_site_t so it can be written
+// to a binary log (see ssc_blog.h) instead of being formatted.
+#define SSCLogMacroLevel(lvl, label, zzz, ...)                                  \
    do                                                                          \
    {                                                                           \
-      FILE *SSCLogMacroBase_logFile = sscGetLogFile();                         \
-      sscLogTimestamp(SSCLogMacroBase_logFile);                                    \
-      fprintf(                                                                 \
-            SSCLogMacroBase_logFile,                                            \
-            "[" level "] "                                                     \
-            "%s:%u:: " zzz "\n",                                               \
-            __FILE__,                                                          \
-            __LINE__,                                                          \
-            ##__VA_ARGS__);                                                    \
-      fflush(SSCLogMacroBase_logFile);                                          \
+      if (SSCLogEnabled(lvl))                                                  \
+      {                                                                        \
+         static ssc_blog_site_t SSCLogMacroLevel_site SSC_BLOG_SITE_ATTR =      \
+            { .file = __FILE__, .fmt = zzz, .tag = label,                      \
+              .line = __LINE__, .level = lvl };                                \
+         if (!sscBlogActive ||                                                 \
+             !sscBlogWrite(&SSCLogMacroLevel_site, ##__VA_ARGS__))             \
+         {                                                                     \
+            SSCLogMacroBase(lvl, zzz, ##__VA_ARGS__);                          \
+         }                                                                     \
+      }                                                                        \
    } while (0)
 
-#define SSCDebugHigh(zzz, ...) SSCLogMacroBase("HIGH  ", zzz, ##__VA_ARGS__)
-#define SSCDebugMed(zzz, ...) SSCLogMacroBase("MED   ", zzz, ##__VA_ARGS__)
-#define SSCDebugLow(zzz, ...) SSCLogMacroBase("LOW   ", zzz, ##__VA_ARGS__)
-#define SSCWarning(zzz, ...) SSCLogMacroBase("WARN  ", zzz, ##__VA_ARGS__)
-#define SSCError(zzz, ...) SSCLogMacroBase("ERROR ", zzz, ##__VA_ARGS__)
+#define SSCDebugHigh(zzz, ...) SSCLogMacroLevel(SSC_LOG_HIGH, "HIGH  ", zzz, ##__VA_ARGS__)
+#define SSCDebugMed(zzz, ...) SSCLogMacroLevel(SSC_LOG_MED, "MED   ", zzz, ##__VA_ARGS__)
+#define SSCDebugLow(zzz, ...) SSCLogMacroLevel(SSC_LOG_LOW, "LOW   ", zzz, ##__VA_ARGS__)
+#define SSCWarning(zzz, ...) SSCLogMacroLevel(SSC_LOG_WARN, "WARN  ", zzz, ##__VA_ARGS__)
+#define SSCError(zzz, ...) SSCLogMacroLevel(SSC_LOG_ERROR, "ERROR ", zzz, ##__VA_ARGS__)
 
 #endif // SSC_LOG_H
@@ -0,0 +1,297 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_log_ctx.h"
+
+#include <string.h>
+#include <strings.h>
+
+#include <sofia-sip/su_alloc.h>
+
+#include "ssc_log.h"
+
+typedef struct ssc_log_ctx_s
+{
+   int sscLevel;          // level for all work on the context
+   int callLevel;         // level for selected calls
+   unsigned sampleN;
+   unsigned sampleCount;
+
+   char *groupName;
+   char *fromUser;
+   char *callIdPrefix;
+   size_t callIdPrefixLen;
+   char *peerHost;
+} ssc_log_ctx_t;
+
+static ssc_log_ctx_t *priv_log_ctx_get(ssc_t *ssc);
+static char *priv_log_ctx_strdup(ssc_t *ssc, char *old, const char *str);
+static int priv_log_ctx_match(ssc_log_ctx_t *c,
+      const char *group,
+      const char *user, size_t userLen,
+      const char *callId,
+      const char *host, size_t hostLen);
+static void priv_log_uri_split(const char *uri,
+      const char **user, size_t *userLen,
+      const char **host, size_t *hostLen);
+
+int ssc_log_ctx_set_level(ssc_t *ssc, int level)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return LOGCTX_FAILURE;
+   }
+
+   ssc_log_ctx_t *c = priv_log_ctx_get(ssc);
+   if (!c)
+   {
+      return LOGCTX_FAILURE;
+   }
+
+   c->sscLevel = level;
+
+   return LOGCTX_SUCCESS;
+}
+
+int ssc_log_ctx_set_filter(ssc_t *ssc, int level, const ssc_log_filter_t *filter)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return LOGCTX_FAILURE;
+   }
+
+   ssc_log_ctx_t *c = priv_log_ctx_get(ssc);
+   if (!c)
+   {
+      return LOGCTX_FAILURE;
+   }
+
+   static const ssc_log_filter_t none;
+   if (!filter)
+   {
+      filter = &none;
+   }
+
+   c->callLevel = level;
+   c->sampleN = filter->sampleN;
+   c->sampleCount = 0;
+   c->groupName = priv_log_ctx_strdup(ssc, c->groupName, filter->groupName);
+   c->fromUser = priv_log_ctx_strdup(ssc, c->fromUser, filter->fromUser);
+   c->callIdPrefix = priv_log_ctx_strdup(ssc, c->callIdPrefix, filter->callIdPrefix);
+   c->callIdPrefixLen = c->callIdPrefix ? strlen(c->callIdPrefix) : 0;
+   c->peerHost = priv_log_ctx_strdup(ssc, c->peerHost, filter->peerHost);
+
+   return LOGCTX_SUCCESS;
+}
+
+int ssc_log_ctx_match_req(
+      ssc_t *ssc,
+      const char *groupName,
+      const char *fromUri,
+      const char *callId,
+      const char *peerUri)
+{
+   if (!ssc || !ssc->ssc_log_ctx) { return 0; }
+
+   const char *user = NULL, *host = NULL, *dummy;
+   size_t userLen = 0, hostLen = 0, dummyLen;
+
+   priv_log_uri_split(fromUri, &user, &userLen, &dummy, &dummyLen);
+   priv_log_uri_split(peerUri, &dummy, &dummyLen, &host, &hostLen);
+
+   return priv_log_ctx_match((ssc_log_ctx_t *)ssc->ssc_log_ctx,
+         groupName, user, userLen, callId, host, hostLen);
+}
+
+int ssc_log_ctx_match_sip(ssc_t *ssc, const sip_t *sip)
+{
+   if (!ssc || !ssc->ssc_log_ctx || !sip) { return 0; }
+
+   const char *user = NULL, *host = NULL, *callId = NULL;
+
+   if (sip->sip_from)
+   {
+      user = sip->sip_from->a_url->url_user;
+   }
+   if (sip->sip_call_id)
+   {
+      callId = sip->sip_call_id->i_id;
+   }
+   if (sip->sip_via)
+   {
+      host = sip->sip_via->v_host;
+   }
+   else if (sip->sip_contact)
+   {
+      host = sip->sip_contact->m_url->url_host;
+   }
+
+   return priv_log_ctx_match((ssc_log_ctx_t *)ssc->ssc_log_ctx,
+         NULL,
+         user, user ? strlen(user) : 0,
+         callId,
+         host, host ? strlen(host) : 0);
+}
+
+int ssc_log_ctx_enter(ssc_t *ssc, int verbose)
+{
+   int saved = sscLogCtxLevel;
+
+   if (!ssc || !ssc->ssc_log_ctx) { return saved; }
+
+   const ssc_log_ctx_t *c = (const ssc_log_ctx_t *)ssc->ssc_log_ctx;
+   int level = c->sscLevel;
+   if (verbose && c->callLevel < level)
+   {
+      level = c->callLevel;
+   }
+
+   sscLogCtxLevel = level;
+
+   return saved;
+}
+
+void ssc_log_ctx_leave(int saved)
+{
+   sscLogCtxLevel = saved;
+}
+
+
+/** internal functions follow **/
+
+ssc_log_ctx_t *priv_log_ctx_get(ssc_t *ssc)
+{
+   if (ssc->ssc_log_ctx)
+   {
+      return (ssc_log_ctx_t *)ssc->ssc_log_ctx;
+   }
+
+   ssc_log_ctx_t *c = (ssc_log_ctx_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_log_ctx_t));
+   if (!c)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_log_ctx_t));
+      return NULL;
+   }
+
+   c->sscLevel = SSC_LOG_NONE;
+   c->callLevel = SSC_LOG_NONE;
+   ssc->ssc_log_ctx = c;
+
+   return c;
+}
+
+char *priv_log_ctx_strdup(ssc_t *ssc, char *old, const char *str)
+{
+   su_free(ssc->ssc_home, old);
+   return (str && str[0]) ? su_strdup(ssc->ssc_home, str) : NULL;
+}
+
+int priv_log_ctx_match(ssc_log_ctx_t *c,
+      const char *group,
+      const char *user, size_t userLen,
+      const char *callId,
+      const char *host, size_t hostLen)
+{
+   if (c->callLevel >= SSC_LOG_NONE)
+   {
+      return 0;
+   }
+
+   if (c->sampleN && ++c->sampleCount >= c->sampleN)
+   {
+      c->sampleCount = 0;
+      return 1;
+   }
+
+   if (c->groupName && group && strcmp(c->groupName, group) == 0)
+   {
+      return 1;
+   }
+
+   if (c->fromUser && user &&
+       strlen(c->fromUser) == userLen && strncmp(c->fromUser, user, userLen) == 0)
+   {
+      return 1;
+   }
+
+   if (c->callIdPrefix && callId && strncmp(c->callIdPrefix, callId, c->callIdPrefixLen) == 0)
+   {
+      return 1;
+   }
+
+   if (c->peerHost && host &&
+       strlen(c->peerHost) == hostLen && strncasecmp(c->peerHost, host, hostLen) == 0)
+   {
+      return 1;
+   }
+
+   return 0;
+}
+
+// find the user and host parts of a SIP URI string such as
+// "Name <sip:user@host:port;params>", without copying
+void priv_log_uri_split(const char *uri,
+      const char **user, size_t *userLen,
+      const char **host, size_t *hostLen)
+{
+   *user = NULL;
+   *userLen = 0;
+   *host = NULL;
+   *hostLen = 0;
+
+   if (!uri || !uri[0]) { return; }
+
+   const char *p = strchr(uri, '<');
+   p = p ? p + 1 : uri;
+
+   if (strncasecmp(p, "sips:", 5) == 0)
+   {
+      p += 5;
+   }
+   else if (strncasecmp(p, "sip:", 4) == 0)
+   {
+      p += 4;
+   }
+
+   size_t n = strcspn(p, "@;>?");
+   if (p[n] == '@')
+   {
+      *user = p;
+      *userLen = n;
+      p += n + 1;
+   }
+
+   if (*p == '[')
+   {
+      // IPv6 reference, keep the brackets
+      const char *e = strchr(p, ']');
+      *hostLen = e ? (size_t)(e - p) + 1 : strlen(p);
+   }
+   else
+   {
+      *hostLen = strcspn(p, ":;>?");
+   }
+   *host = p;
+}
@@ -0,0 +1,92 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// per-call verbose logging.
+///
+/// each SSC context can carry a log context that raises the log level for
+/// everything done on that context, and a filter that picks out single
+/// calls for verbose output: a sampled 1 in N, or calls matching a group
+/// name, From user, Call-ID prefix or peer host.  a call is selected once,
+/// when its INVITE operation is created, and the choice is kept in the op.
+///
+/// the level is applied through a thread-local override that SSCLogEnabled()
+/// checks after the global level, so calls that are not selected pay one
+/// extra compare per suppressed log line.  priv_callback() and the INVITE
+/// senders enter the context of the op they work on.
+
+#include "ssc_sip.h"
+#include "ssc_oper.h"
+
+/// some simple return codes
+#define LOGCTX_SUCCESS   0
+#define LOGCTX_FAILURE  -1
+
+/// call selection filter.  a call is selected if it is sampled or if any
+/// of the fields that are set matches.  strings are copied.
+typedef struct ssc_log_filter_s
+{
+   unsigned sampleN;           ///< select 1 in N calls; 0 = no sampling
+   const char *groupName;      ///< exact match on the group name (outgoing calls)
+   const char *fromUser;       ///< exact match on the user part of From:
+   const char *callIdPrefix;   ///< prefix match on Call-ID
+   const char *peerHost;       ///< case-insensitive match on the peer host:
+                               ///  request URI host for outgoing calls,
+                               ///  top Via host for incoming ones
+} ssc_log_filter_t;
+
+/// set the log level for everything done on this SSC context.
+/// @param[in] ssc    ptr to SSC context
+/// @param[in] level  SSC_LOG_* level; SSC_LOG_NONE leaves the global level alone
+/// @return LOGCTX_SUCCESS or LOGCTX_FAILURE
+int ssc_log_ctx_set_level(ssc_t *ssc, int level);
+
+/// set the filter that selects calls for verbose logging.
+/// @param[in] ssc     ptr to SSC context
+/// @param[in] level   SSC_LOG_* level used for selected calls
+/// @param[in] filter  selection filter, NULL to select no calls
+/// @return LOGCTX_SUCCESS or LOGCTX_FAILURE
+int ssc_log_ctx_set_filter(ssc_t *ssc, int level, const ssc_log_filter_t *filter);
+
+/// decide whether an outgoing call is selected.  advances the sampling count.
+/// @return 1 if selected, 0 if not
+int ssc_log_ctx_match_req(
+      ssc_t *ssc,
+      const char *groupName,
+      const char *fromUri,
+      const char *callId,
+      const char *peerUri);
+
+/// decide whether an incoming call is selected.  advances the sampling count.
+/// @return 1 if selected, 0 if not
+int ssc_log_ctx_match_sip(ssc_t *ssc, const sip_t *sip);
+
+/// switch the calling thread to the log level of @p ssc, or of a selected
+/// call on it.
+/// @param[in] ssc      ptr to SSC context, may be NULL
+/// @param[in] verbose  non-zero if the work is for a selected call
+/// @return previous level, to pass to ssc_log_ctx_leave()
+int ssc_log_ctx_enter(ssc_t *ssc, int verbose);
+
+/// restore the level saved by ssc_log_ctx_enter().
+void ssc_log_ctx_leave(int saved);
@@ -0,0 +1,277 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_loop_mon.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <sofia-sip/su.h>
+#include <sofia-sip/su_wait.h>
+
+#include "ssc_log.h"
+
+#define LM_DEFAULT_INTERVAL_MS 100
+
+typedef struct ssc_lm_s
+{
+   su_timer_t *timer;
+
+   unsigned interval_ms;
+   uint64_t threshold_us;
+   ssc_lm_overload_cb overload_cb;
+
+   uint64_t expected;     // ssc_clock_us() the timer is due at
+   uint64_t last_turn;    // ssc_clock_us() of the previous prepoll, 0 before the first
+   int prepoll_set;
+
+   int overloaded;
+   uint64_t overloads;
+
+   ssc_hist_t lag;
+   ssc_hist_t turn;
+} ssc_lm_t;
+
+static int priv_lm_arm(ssc_t *ssc, ssc_lm_t *lm);
+static void priv_lm_tick(su_root_magic_t *magic, su_timer_t *t, su_timer_arg_t *arg);
+static void priv_lm_prepoll(su_prepoll_magic_t *magic, su_root_t *root);
+
+int ssc_lm_start(ssc_t *ssc, unsigned interval_ms, unsigned threshold_ms, ssc_lm_overload_cb cb)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return LM_FAILURE;
+   }
+
+   if (!ssc->ssc_home || !ssc->ssc_root)
+   {
+      SSCError("%s: ssc context has no home or root", __func__);
+      return LM_FAILURE;
+   }
+
+   if (ssc->ssc_lm)
+   {
+      SSCError("%s: loop monitor already running", __func__);
+      return LM_FAILURE;
+   }
+
+   ssc_lm_t *lm = (ssc_lm_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_lm_t));
+   if (!lm)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_lm_t));
+      return LM_FAILURE;
+   }
+
+   lm->interval_ms = interval_ms ? interval_ms : LM_DEFAULT_INTERVAL_MS;
+   lm->threshold_us = (uint64_t)threshold_ms * 1000u;
+   lm->overload_cb = cb;
+
+   lm->timer = su_timer_create(su_root_task(ssc->ssc_root), lm->interval_ms);
+   if (!lm->timer)
+   {
+      SSCError("%s: failed to create su_timer", __func__);
+      su_free(ssc->ssc_home, lm);
+      return LM_FAILURE;
+   }
+
+   ssc->ssc_lm = lm;
+
+   if (priv_lm_arm(ssc, lm) != LM_SUCCESS)
+   {
+      ssc_lm_stop(ssc);
+      return LM_FAILURE;
+   }
+
+   if (su_root_set_prepoll(ssc->ssc_root, priv_lm_prepoll, (su_prepoll_magic_t *)ssc) < 0)
+   {
+      // lag is still measured; only turn times are missing
+      SSCWarning("%s: failed to set prepoll hook, loop turn times not measured", __func__);
+   }
+   else
+   {
+      lm->prepoll_set = 1;
+   }
+
+   return LM_SUCCESS;
+}
+
+void ssc_lm_stop(ssc_t *ssc)
+{
+   if (!ssc) { return; }
+   if (!ssc->ssc_lm) { return; }
+
+   ssc_lm_t *lm = (ssc_lm_t *)ssc->ssc_lm;
+   ssc->ssc_lm = NULL;
+
+   if (lm->prepoll_set && ssc->ssc_root)
+   {
+      su_root_remove_prepoll(ssc->ssc_root);
+   }
+
+   if (lm->timer)
+   {
+      su_timer_destroy(lm->timer);
+   }
+
+   su_free(ssc->ssc_home, lm);
+}
+
+int ssc_lm_get_stats(const ssc_t *ssc, ssc_lm_stats_t *out)
+{
+   if (!ssc || !out)
+   {
+      SSCError("%s: NULL ptr arg", __func__);
+      return LM_FAILURE;
+   }
+
+   const ssc_lm_t *lm = (const ssc_lm_t *)ssc->ssc_lm;
+   if (!lm)
+   {
+      SSCError("%s: loop monitor not running", __func__);
+      return LM_FAILURE;
+   }
+
+   memset(out, 0, sizeof(*out));
+
+   out->samples = lm->lag.count;
+   out->lag_p50_us = ssc_hist_percentile(&lm->lag, 50.0);
+   out->lag_p99_us = ssc_hist_percentile(&lm->lag, 99.0);
+   out->lag_max_us = lm->lag.max;
+
+   out->turns = lm->turn.count;
+   out->turn_p50_us = ssc_hist_percentile(&lm->turn, 50.0);
+   out->turn_p99_us = ssc_hist_percentile(&lm->turn, 99.0);
+   out->turn_max_us = lm->turn.max;
+
+   out->overloads = lm->overloads;
+   out->overloaded = lm->overloaded;
+
+   return LM_SUCCESS;
+}
+
+int ssc_lm_get_hist(const ssc_t *ssc, ssc_hist_t *lag, ssc_hist_t *turn)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return LM_FAILURE;
+   }
+
+   const ssc_lm_t *lm = (const ssc_lm_t *)ssc->ssc_lm;
+   if (!lm)
+   {
+      SSCError("%s: loop monitor not running", __func__);
+      return LM_FAILURE;
+   }
+
+   if (lag) { memcpy(lag, &lm->lag, sizeof(*lag)); }
+   if (turn) { memcpy(turn, &lm->turn, sizeof(*turn)); }
+
+   return LM_SUCCESS;
+}
+
+void ssc_lm_reset(ssc_t *ssc)
+{
+   if (!ssc || !ssc->ssc_lm) { return; }
+
+   ssc_lm_t *lm = (ssc_lm_t *)ssc->ssc_lm;
+
+   ssc_hist_reset(&lm->lag);
+   ssc_hist_reset(&lm->turn);
+   lm->overloads = 0;
+   lm->last_turn = 0;
+}
+
+
+/** internal functions follow **/
+
+// the timer is re-armed one-shot on every firing rather than left running
+// for ever, so each sample measures a single interval from a known start.
+int priv_lm_arm(ssc_t *ssc, ssc_lm_t *lm)
+{
+   lm->expected = ssc_clock_us() + (uint64_t)lm->interval_ms * 1000u;
+
+   if (su_timer_set(lm->timer, priv_lm_tick, (su_timer_arg_t *)ssc) < 0)
+   {
+      SSCError("%s: failed to start su_timer", __func__);
+      return LM_FAILURE;
+   }
+
+   return LM_SUCCESS;
+}
+
+void priv_lm_tick(su_root_magic_t *magic, su_timer_t *t, su_timer_arg_t *arg)
+{
+   ssc_t *ssc = (ssc_t *)arg;
+   if (!ssc || !ssc->ssc_lm) { return; }
+
+   ssc_lm_t *lm = (ssc_lm_t *)ssc->ssc_lm;
+
+   uint64_t now = ssc_clock_us();
+   uint64_t lag = now > lm->expected ? now - lm->expected : 0;
+
+   ssc_hist_record(&lm->lag, lag);
+
+   if (lm->threshold_us)
+   {
+      int over = lag > lm->threshold_us;
+      if (over != lm->overloaded)
+      {
+         lm->overloaded = over;
+         if (over)
+         {
+            ++lm->overloads;
+            SSCWarning("%s: event loop lag %llu us over threshold %llu us", __func__,
+                  (unsigned long long)lag, (unsigned long long)lm->threshold_us);
+         }
+
+         if (lm->overload_cb)
+         {
+            lm->overload_cb(ssc, lag, over, ssc->userData);
+         }
+      }
+   }
+
+   // the callback may have stopped the monitor
+   if (ssc->ssc_lm == lm)
+   {
+      priv_lm_arm(ssc, lm);
+   }
+}
+
+void priv_lm_prepoll(su_prepoll_magic_t *magic, su_root_t *root)
+{
+   ssc_t *ssc = (ssc_t *)magic;
+   if (!ssc || !ssc->ssc_lm) { return; }
+
+   ssc_lm_t *lm = (ssc_lm_t *)ssc->ssc_lm;
+
+   uint64_t now = ssc_clock_us();
+   if (lm->last_turn && now >= lm->last_turn)
+   {
+      ssc_hist_record(&lm->turn, now - lm->last_turn);
+   }
+   lm->last_turn = now;
+}
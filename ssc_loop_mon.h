@@ -0,0 +1,111 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// provides an optional monitor of the su_root event loop that drives the
+/// SSC context.  when the application's callbacks (or anything else on the
+/// root thread) block the loop, sofia's retransmission and transaction
+/// timers fire late and peers start timing us out; this makes that visible.
+///
+/// two things are measured:
+///  - lag: a su_timer is re-armed every interval and the difference between
+///    when it should have fired and when it did is recorded.
+///  - turn time: the time between consecutive passes of the loop, taken
+///    from the root's prepoll hook.  this includes the time spent waiting in
+///    poll, so long turns with low lag just mean the loop was idle.
+///
+/// both go into ssc_stats histograms, in microseconds.  when the lag goes
+/// over the configured threshold an overload callback is raised, and raised
+/// again once the lag is back under it.
+///
+/// the monitor takes the root's prepoll hook; applications that install
+/// their own prepoll callback will lose it.
+
+#include "ssc_sip.h"
+#include "ssc_stats.h"
+
+/// some simple return codes
+#define LM_SUCCESS   0
+#define LM_FAILURE  -1
+
+/// summary of the loop measurements, see ssc_lm_get_stats()
+typedef struct ssc_lm_stats_s
+{
+   uint64_t samples;      // timer firings measured
+   uint64_t lag_p50_us;   // median timer lag
+   uint64_t lag_p99_us;   // 99th percentile timer lag
+   uint64_t lag_max_us;   // worst timer lag
+   uint64_t turns;        // loop turns measured
+   uint64_t turn_p50_us;  // median loop turn time
+   uint64_t turn_p99_us;  // 99th percentile loop turn time
+   uint64_t turn_max_us;  // longest loop turn
+   uint64_t overloads;    // times the lag went over the threshold
+   int      overloaded;   // set while the last lag was over the threshold
+} ssc_lm_stats_t;
+
+/// called when the measured lag goes over the threshold (@p overloaded
+/// set) and when it first drops back under it (@p overloaded clear).
+///
+/// @param[in]  ssc         ptr to SSC context being monitored
+/// @param[in]  lag_us      lag of the firing that changed the state
+/// @param[in]  overloaded  1 when entering overload, 0 when leaving it
+/// @param[in]  context     SSC userData
+typedef void (*ssc_lm_overload_cb)(ssc_t *ssc, uint64_t lag_us, int overloaded, void *context);
+
+/// create the monitor for the indicated SSC context, start its su_timer on
+/// the SSC root and install the root's prepoll hook.
+///
+/// @param[in]  ssc           ptr to SSC context to use
+/// @param[in]  interval_ms   how often the lag is sampled (0 == 100ms)
+/// @param[in]  threshold_ms  lag that counts as overload (0 == no callback)
+/// @param[in]  cb            optional overload callback
+///
+/// @return LM_SUCCESS, or LM_FAILURE if the monitor could not be created.
+int ssc_lm_start(ssc_t *ssc, unsigned interval_ms, unsigned threshold_ms, ssc_lm_overload_cb cb);
+
+/// stop the timer, remove the prepoll hook and release the monitor.
+///
+/// @param[in]  ssc    ptr to SSC context to use
+void ssc_lm_stop(ssc_t *ssc);
+
+/// summarize the measurements taken since start or the last reset.
+///
+/// @param[in]  ssc    ptr to SSC context to use
+/// @param[out] out    filled in with the summary
+///
+/// @return LM_SUCCESS, or LM_FAILURE on bad args or if the monitor is not running.
+int ssc_lm_get_stats(const ssc_t *ssc, ssc_lm_stats_t *out);
+
+/// copy out the full lag and turn time histograms (usec).
+///
+/// @param[in]  ssc    ptr to SSC context to use
+/// @param[out] lag    optional, filled in with the lag histogram
+/// @param[out] turn   optional, filled in with the turn time histogram
+///
+/// @return LM_SUCCESS, or LM_FAILURE on bad args or if the monitor is not running.
+int ssc_lm_get_hist(const ssc_t *ssc, ssc_hist_t *lag, ssc_hist_t *turn);
+
+/// clear the measurements.  the overload state is kept.
+///
+/// @param[in]  ssc    ptr to SSC context to use
+void ssc_lm_reset(ssc_t *ssc);
@@ -0,0 +1,293 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ssc_log.h"
+
+static ssc_metrics_t sscMetrics;
+
+static const char *priv_metrics_dir[2] = { "rx", "tx" };
+
+static void priv_metrics_add(uint64_t *counter);
+static void priv_metrics_gauge(int64_t *gauge, int64_t delta);
+static int priv_metrics_method_index(sip_method_t method);
+static void priv_metrics_op_gauges(const ssc_oper_t *op, int64_t delta);
+static void priv_metrics_append(char *buf, size_t size, size_t *len, const char *fmt, ...)
+   __attribute__((format(printf, 4, 5)));
+static const char *priv_metrics_method_name(unsigned m);
+
+void ssc_metrics_request(int dir, sip_method_t method)
+{
+   int m = priv_metrics_method_index(method);
+   if (m < 0 || (dir != SSC_METRICS_RX && dir != SSC_METRICS_TX)) { return; }
+
+   priv_metrics_add(&sscMetrics.requests[dir][m]);
+}
+
+void ssc_metrics_response(int dir, sip_method_t method, int status)
+{
+   int m = priv_metrics_method_index(method);
+   if (m < 0 || (dir != SSC_METRICS_RX && dir != SSC_METRICS_TX)) { return; }
+   if (status < 100 || status >= 100 * (SSC_METRICS_CLASSES + 1)) { return; }
+
+   priv_metrics_add(&sscMetrics.responses[dir][m][status / 100 - 1]);
+}
+
+void ssc_metrics_event(nua_event_t event)
+{
+   if ((unsigned)event >= SSC_METRICS_EVENTS) { return; }
+
+   priv_metrics_add(&sscMetrics.callbacks[event]);
+}
+
+void ssc_metrics_op_added(const ssc_oper_t *op)
+{
+   priv_metrics_op_gauges(op, 1);
+}
+
+void ssc_metrics_op_removed(const ssc_oper_t *op)
+{
+   priv_metrics_op_gauges(op, -1);
+}
+
+void ssc_metrics_op_state(const ssc_oper_t *op, int state)
+{
+   if (!op || op->op_prev_state == state) { return; }
+
+   if ((unsigned)op->op_prev_state < SSC_METRICS_STATES)
+   {
+      priv_metrics_gauge(&sscMetrics.ops_state[op->op_prev_state], -1);
+   }
+
+   if ((unsigned)state < SSC_METRICS_STATES)
+   {
+      priv_metrics_gauge(&sscMetrics.ops_state[state], 1);
+   }
+}
+
+void ssc_metrics_snapshot(ssc_metrics_t *out)
+{
+   if (!out)
+   {
+      SSCError("%s: NULL ptr arg", __func__);
+      return;
+   }
+
+   unsigned d, m, c, i;
+   for (d=0; d<2; ++d)
+   {
+      for (m=0; m<SSC_METRICS_METHODS; ++m)
+      {
+         out->requests[d][m] = __atomic_load_n(&sscMetrics.requests[d][m], __ATOMIC_RELAXED);
+         for (c=0; c<SSC_METRICS_CLASSES; ++c)
+         {
+            out->responses[d][m][c] = __atomic_load_n(&sscMetrics.responses[d][m][c], __ATOMIC_RELAXED);
+         }
+      }
+   }
+
+   for (m=0; m<SSC_METRICS_METHODS; ++m)
+   {
+      out->ops_live[m] = __atomic_load_n(&sscMetrics.ops_live[m], __ATOMIC_RELAXED);
+   }
+
+   for (i=0; i<SSC_METRICS_STATES; ++i)
+   {
+      out->ops_state[i] = __atomic_load_n(&sscMetrics.ops_state[i], __ATOMIC_RELAXED);
+   }
+
+   for (i=0; i<SSC_METRICS_EVENTS; ++i)
+   {
+      out->callbacks[i] = __atomic_load_n(&sscMetrics.callbacks[i], __ATOMIC_RELAXED);
+   }
+}
+
+void ssc_metrics_reset(void)
+{
+   unsigned d, m, c, i;
+   for (d=0; d<2; ++d)
+   {
+      for (m=0; m<SSC_METRICS_METHODS; ++m)
+      {
+         __atomic_store_n(&sscMetrics.requests[d][m], 0, __ATOMIC_RELAXED);
+         for (c=0; c<SSC_METRICS_CLASSES; ++c)
+         {
+            __atomic_store_n(&sscMetrics.responses[d][m][c], 0, __ATOMIC_RELAXED);
+         }
+      }
+   }
+
+   for (i=0; i<SSC_METRICS_EVENTS; ++i)
+   {
+      __atomic_store_n(&sscMetrics.callbacks[i], 0, __ATOMIC_RELAXED);
+   }
+}
+
+size_t ssc_metrics_dump_prometheus(char *buf, size_t size)
+{
+   ssc_metrics_t s;
+   size_t len = 0;
+   unsigned d, m, c, i;
+
+   ssc_metrics_snapshot(&s);
+
+   if (buf && size) { buf[0] = '\0'; }
+
+   priv_metrics_append(buf, size, &len,
+         "# HELP ssc_sip_requests_total SIP requests sent (tx) and received (rx).\n"
+         "# TYPE ssc_sip_requests_total counter\n");
+   for (d=0; d<2; ++d)
+   {
+      for (m=0; m<SSC_METRICS_METHODS; ++m)
+      {
+         if (!s.requests[d][m]) { continue; }
+         priv_metrics_append(buf, size, &len,
+               "ssc_sip_requests_total{direction=\"%s\",method=\"%s\"} %llu\n",
+               priv_metrics_dir[d], priv_metrics_method_name(m),
+               (unsigned long long)s.requests[d][m]);
+      }
+   }
+
+   priv_metrics_append(buf, size, &len,
+         "# HELP ssc_sip_responses_total SIP responses sent (tx) and received (rx) by status class.\n"
+         "# TYPE ssc_sip_responses_total counter\n");
+   for (d=0; d<2; ++d)
+   {
+      for (m=0; m<SSC_METRICS_METHODS; ++m)
+      {
+         for (c=0; c<SSC_METRICS_CLASSES; ++c)
+         {
+            if (!s.responses[d][m][c]) { continue; }
+            priv_metrics_append(buf, size, &len,
+                  "ssc_sip_responses_total{direction=\"%s\",method=\"%s\",class=\"%uxx\"} %llu\n",
+                  priv_metrics_dir[d], priv_metrics_method_name(m), c + 1,
+                  (unsigned long long)s.responses[d][m][c]);
+         }
+      }
+   }
+
+   priv_metrics_append(buf, size, &len,
+         "# HELP ssc_ops_live SSC operations currently held, by method.\n"
+         "# TYPE ssc_ops_live gauge\n");
+   for (m=0; m<SSC_METRICS_METHODS; ++m)
+   {
+      if (!sip_method_name((sip_method_t)m, NULL) && m != sip_method_unknown) { continue; }
+      priv_metrics_append(buf, size, &len,
+            "ssc_ops_live{method=\"%s\"} %lld\n",
+            priv_metrics_method_name(m), (long long)s.ops_live[m]);
+   }
+
+   priv_metrics_append(buf, size, &len,
+         "# HELP ssc_ops_callstate SSC operations currently held, by NUA call state.\n"
+         "# TYPE ssc_ops_callstate gauge\n");
+   for (i=0; i<=nua_callstate_terminated; ++i)
+   {
+      priv_metrics_append(buf, size, &len,
+            "ssc_ops_callstate{state=\"%s\"} %lld\n",
+            nua_callstate_name((enum nua_callstate)i), (long long)s.ops_state[i]);
+   }
+
+   priv_metrics_append(buf, size, &len,
+         "# HELP ssc_callbacks_total NUA events dispatched by priv_callback.\n"
+         "# TYPE ssc_callbacks_total counter\n");
+   for (i=0; i<SSC_METRICS_EVENTS; ++i)
+   {
+      if (!s.callbacks[i]) { continue; }
+      priv_metrics_append(buf, size, &len,
+            "ssc_callbacks_total{event=\"%s\"} %llu\n",
+            nua_event_name((nua_event_t)i), (unsigned long long)s.callbacks[i]);
+   }
+
+   return len;
+}
+
+
+/** internal functions follow **/
+
+void priv_metrics_add(uint64_t *counter)
+{
+   __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+void priv_metrics_gauge(int64_t *gauge, int64_t delta)
+{
+   __atomic_fetch_add(gauge, delta, __ATOMIC_RELAXED);
+}
+
+int priv_metrics_method_index(sip_method_t method)
+{
+   if (method < sip_method_unknown || (unsigned)method >= SSC_METRICS_METHODS)
+   {
+      return -1;
+   }
+
+   return (int)method;
+}
+
+void priv_metrics_op_gauges(const ssc_oper_t *op, int64_t delta)
+{
+   if (!op) { return; }
+
+   int m = priv_metrics_method_index(op->op_method);
+   if (m >= 0)
+   {
+      priv_metrics_gauge(&sscMetrics.ops_live[m], delta);
+   }
+
+   if ((unsigned)op->op_prev_state < SSC_METRICS_STATES)
+   {
+      priv_metrics_gauge(&sscMetrics.ops_state[op->op_prev_state], delta);
+   }
+}
+
+// snprintf into the remaining space, keeping the full length in *len so the
+// caller can report how big the buffer needed to be.
+void priv_metrics_append(char *buf, size_t size, size_t *len, const char *fmt, ...)
+{
+   va_list ap;
+   char *dst = NULL;
+   size_t room = 0;
+
+   if (buf && *len < size)
+   {
+      dst = buf + *len;
+      room = size - *len;
+   }
+
+   va_start(ap, fmt);
+   int n = vsnprintf(dst, room, fmt, ap);
+   va_end(ap);
+
+   if (n > 0) { *len += (size_t)n; }
+}
+
+const char *priv_metrics_method_name(unsigned m)
+{
+   const char *name = sip_method_name((sip_method_t)m, NULL);
+   return name ? name : "UNKNOWN";
+}
@@ -0,0 +1,118 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// provides a process wide registry of SIP traffic counters, so monitoring
+/// does not have to be derived from the logs.
+///
+/// the library updates the registry from its existing hook points:
+///  - requests sent: where ssc_sip.c hands a request to nua
+///  - requests and responses received, callback invocations: priv_callback()
+///  - responses sent: where ssc_sip.c calls nua_respond()
+///  - live operations per method and NUA call state: the op container
+///    (ssc_oc_*) and ssc_i_state()
+///
+/// every counter is updated with a relaxed atomic add, so contexts running
+/// on different threads can share the registry.  a snapshot is a set of
+/// relaxed loads; it is not taken atomically as a whole.
+///
+/// retransmissions are handled inside nua's transaction layer and are not
+/// reported to the application, so they are not counted here.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ssc_sip.h"
+#include "ssc_oper.h"
+
+/// array sizes; values at or above these are not counted
+#define SSC_METRICS_METHODS   16   // sip_method_t
+#define SSC_METRICS_CLASSES   6    // status classes 1xx - 6xx
+#define SSC_METRICS_STATES    16   // enum nua_callstate
+#define SSC_METRICS_EVENTS    64   // nua_event_t
+
+/// traffic direction
+#define SSC_METRICS_RX  0
+#define SSC_METRICS_TX  1
+
+typedef struct ssc_metrics_s
+{
+   uint64_t requests[2][SSC_METRICS_METHODS];                      // [dir][method]
+   uint64_t responses[2][SSC_METRICS_METHODS][SSC_METRICS_CLASSES]; // [dir][method][class-1]
+   int64_t  ops_live[SSC_METRICS_METHODS];                          // ops in a container, by method
+   int64_t  ops_state[SSC_METRICS_STATES];                          // ops in a container, by call state
+   uint64_t callbacks[SSC_METRICS_EVENTS];                          // priv_callback invocations, by event
+} ssc_metrics_t;
+
+/// count a request sent or received.
+///
+/// @param[in]  dir      SSC_METRICS_RX or SSC_METRICS_TX
+/// @param[in]  method   SIP method of the request
+void ssc_metrics_request(int dir, sip_method_t method);
+
+/// count a response sent or received.  status codes outside 100-699 are
+/// not counted.
+///
+/// @param[in]  dir      SSC_METRICS_RX or SSC_METRICS_TX
+/// @param[in]  method   SIP method of the request being answered
+/// @param[in]  status   response status code
+void ssc_metrics_response(int dir, sip_method_t method, int status);
+
+/// count a priv_callback invocation.
+///
+/// @param[in]  event    NUA event being dispatched
+void ssc_metrics_event(nua_event_t event);
+
+/// account for an operation entering or leaving an op container.  the
+/// operation is counted under its method and its current call state
+/// (op_prev_state).
+///
+/// @param[in]  op       operation added or removed
+void ssc_metrics_op_added(const ssc_oper_t *op);
+void ssc_metrics_op_removed(const ssc_oper_t *op);
+
+/// move a contained operation from its current call state (op_prev_state)
+/// to @p state.  must be called before op_prev_state is updated.
+///
+/// @param[in]  op       operation changing state
+/// @param[in]  state    new NUA call state
+void ssc_metrics_op_state(const ssc_oper_t *op, int state);
+
+/// copy out the current counter values.
+///
+/// @param[out] out      filled in with the counters
+void ssc_metrics_snapshot(ssc_metrics_t *out);
+
+/// clear the counters.  the live operation gauges are kept.
+void ssc_metrics_reset(void);
+
+/// format the counters in the Prometheus text exposition format.
+/// zero counters are left out; gauges are always listed.
+///
+/// @param[out] buf      buffer to write into, always NUL terminated when
+///                      @p size is non-zero
+/// @param[in]  size     size of @p buf
+///
+/// @return the length of the full dump (excluding the NUL), as snprintf();
+///         the output was truncated if this is >= @p size.
+size_t ssc_metrics_dump_prometheus(char *buf, size_t size);
@@ -0,0 +1,375 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_mime.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sofia-sip/sip_header.h>
+
+#include "ssc_log.h"
+#include "ssc_stats.h"
+
+#define MIME_CRLF "\r\n"
+#define MIME_DASHES "--"
+#define MIME_CT_PREFIX "Content-Type: "
+
+#define MIME_CT_SDP "application/sdp"
+#define MIME_CT_RS_METADATA "application/rs-metadata+xml"
+
+static int priv_mime_put(ssc_mime_t *m, const void *data, size_t len);
+static void priv_mime_delim(ssc_mime_t *m);
+static int priv_mime_ends_crlf(const char *s, size_t len);
+static int priv_mime_grow(ssc_mime_t *m, size_t need, int exact);
+
+void ssc_mime_boundary_init(ssc_mime_boundary_t *b, const char *str)
+{
+   if (!b) { return; }
+
+   if (str)
+   {
+      snprintf(b->str, sizeof(b->str), "%s", str);
+   }
+   else
+   {
+      static uint32_t seq;
+      uint64_t t = ssc_clock_us();
+
+      snprintf(b->str, sizeof(b->str), "ssc-%08x%08x-%05u-%08x",
+            (unsigned)(t >> 32), (unsigned)t, (unsigned)getpid() & 0xffff, (unsigned)++seq);
+   }
+
+   b->len = strlen(b->str);
+}
+
+sip_content_type_t *ssc_mime_content_type(su_home_t *home, const ssc_mime_boundary_t *b)
+{
+   char buf[sizeof("multipart/mixed;boundary=\"\"") + SSC_MIME_BOUNDARY_MAX];
+
+   if (!b)
+   {
+      SSCError("%s: NULL boundary ptr", __func__);
+      return NULL;
+   }
+
+   snprintf(buf, sizeof(buf), "multipart/mixed;boundary=\"%s\"", b->str);
+
+   return sip_content_type_make(home, buf);
+}
+
+size_t ssc_mime_part_size(const ssc_mime_boundary_t *b, const char *content_type, size_t body_len)
+{
+   // CRLF "--" boundary CRLF "Content-Type: " type CRLF CRLF body
+   // (the first part of a body is written without the leading CRLF)
+   return strlen(MIME_CRLF MIME_DASHES) + b->len + strlen(MIME_CRLF) +
+          strlen(MIME_CT_PREFIX) + strlen(content_type) + strlen(MIME_CRLF MIME_CRLF) +
+          body_len;
+}
+
+size_t ssc_mime_close_size(const ssc_mime_boundary_t *b)
+{
+   // CRLF "--" boundary "--" CRLF
+   return strlen(MIME_CRLF MIME_DASHES) + b->len + strlen(MIME_DASHES MIME_CRLF);
+}
+
+size_t ssc_mime_parts_size(const ssc_mime_boundary_t *b, const ssc_mime_part_t parts[], unsigned n)
+{
+   size_t size = 0;
+   unsigned i;
+
+   if (!b || n == 0) { return 0; }
+
+   for (i=0; i<n; ++i)
+   {
+      // CRLF "--" boundary CRLF headers [CRLF] CRLF body
+      size += strlen(MIME_CRLF MIME_DASHES) + b->len + strlen(MIME_CRLF) +
+              parts[i].headers_len + strlen(MIME_CRLF) + parts[i].body_len;
+
+      if (parts[i].headers_len && !priv_mime_ends_crlf(parts[i].headers, parts[i].headers_len))
+      {
+         size += strlen(MIME_CRLF);
+      }
+   }
+
+   // the first delimiter has no leading CRLF
+   return size - strlen(MIME_CRLF) + ssc_mime_close_size(b);
+}
+
+void ssc_mime_init(ssc_mime_t *m, su_home_t *home, const ssc_mime_boundary_t *b, char *storage, size_t size)
+{
+   if (!m) { return; }
+
+   m->home = home;
+   m->boundary = b;
+   m->buf = storage;
+   m->size = storage ? size : 0;
+   m->len = 0;
+   m->parts = 0;
+   m->owned = 0;
+   m->failed = 0;
+}
+
+int ssc_mime_reserve(ssc_mime_t *m, size_t size)
+{
+   if (!m)
+   {
+      SSCError("%s: NULL writer ptr", __func__);
+      return MIME_FAILURE;
+   }
+
+   if (size <= m->size)
+   {
+      return MIME_SUCCESS;
+   }
+
+   return priv_mime_grow(m, size, 1);
+}
+
+int ssc_mime_part_begin(ssc_mime_t *m, const char *content_type)
+{
+   if (!m || !m->boundary || !content_type)
+   {
+      SSCError("%s: NULL writer, boundary or content type", __func__);
+      return MIME_FAILURE;
+   }
+
+   priv_mime_delim(m);
+   priv_mime_put(m, MIME_CT_PREFIX, strlen(MIME_CT_PREFIX));
+   priv_mime_put(m, content_type, strlen(content_type));
+
+   return priv_mime_put(m, MIME_CRLF MIME_CRLF, strlen(MIME_CRLF MIME_CRLF));
+}
+
+int ssc_mime_write(ssc_mime_t *m, const void *data, size_t len)
+{
+   if (!m)
+   {
+      SSCError("%s: NULL writer ptr", __func__);
+      return MIME_FAILURE;
+   }
+
+   return priv_mime_put(m, data, len);
+}
+
+int ssc_mime_part(ssc_mime_t *m, const char *content_type, const void *body, size_t len)
+{
+   if (ssc_mime_part_begin(m, content_type) != MIME_SUCCESS)
+   {
+      return MIME_FAILURE;
+   }
+
+   return priv_mime_put(m, body, len);
+}
+
+int ssc_mime_finish(ssc_mime_t *m, sip_payload_t *pl)
+{
+   if (!m || !m->boundary || !pl)
+   {
+      SSCError("%s: NULL writer, boundary or payload ptr", __func__);
+      return MIME_FAILURE;
+   }
+
+   priv_mime_put(m, MIME_CRLF MIME_DASHES, strlen(MIME_CRLF MIME_DASHES));
+   priv_mime_put(m, m->boundary->str, m->boundary->len);
+   priv_mime_put(m, MIME_DASHES MIME_CRLF, strlen(MIME_DASHES MIME_CRLF));
+
+   return ssc_mime_payload(m, pl);
+}
+
+int ssc_mime_payload(ssc_mime_t *m, sip_payload_t *pl)
+{
+   if (!m || !pl)
+   {
+      SSCError("%s: NULL writer or payload ptr", __func__);
+      return MIME_FAILURE;
+   }
+
+   if (m->failed)
+   {
+      SSCError("%s: body did not fit (%zu bytes written, buffer %zu)", __func__, m->len, m->size);
+      return MIME_FAILURE;
+   }
+
+   sip_payload_init(pl);
+   pl->pl_data = m->buf;
+   pl->pl_len = m->len;
+
+   return MIME_SUCCESS;
+}
+
+int ssc_mime_build(ssc_mime_t *m, const ssc_mime_part_t parts[], unsigned n, sip_payload_t *pl)
+{
+   unsigned i;
+
+   if (!m || !m->boundary || (n && !parts))
+   {
+      SSCError("%s: NULL writer, boundary or parts", __func__);
+      return MIME_FAILURE;
+   }
+
+   if (ssc_mime_reserve(m, m->len + ssc_mime_parts_size(m->boundary, parts, n)) != MIME_SUCCESS)
+   {
+      return MIME_FAILURE;
+   }
+
+   for (i=0; i<n; ++i)
+   {
+      const ssc_mime_part_t *p = &parts[i];
+
+      priv_mime_delim(m);
+
+      if (p->headers_len)
+      {
+         priv_mime_put(m, p->headers, p->headers_len);
+         if (!priv_mime_ends_crlf(p->headers, p->headers_len))
+         {
+            priv_mime_put(m, MIME_CRLF, strlen(MIME_CRLF));
+         }
+      }
+
+      priv_mime_put(m, MIME_CRLF, strlen(MIME_CRLF));
+      priv_mime_put(m, p->body, p->body_len);
+   }
+
+   return ssc_mime_finish(m, pl);
+}
+
+int ssc_mime_siprec(ssc_mime_t *m,
+      const char *sdp, size_t sdp_len,
+      const char *metadata, size_t md_len,
+      sip_payload_t *pl)
+{
+   if (!m || !m->boundary || !sdp || !metadata)
+   {
+      SSCError("%s: NULL writer, boundary, sdp or metadata ptr", __func__);
+      return MIME_FAILURE;
+   }
+
+   // the first part has no leading CRLF, hence the -2
+   size_t total = ssc_mime_part_size(m->boundary, MIME_CT_SDP, sdp_len) +
+                  ssc_mime_part_size(m->boundary, MIME_CT_RS_METADATA, md_len) +
+                  ssc_mime_close_size(m->boundary) - strlen(MIME_CRLF);
+
+   if (ssc_mime_reserve(m, m->len + total) != MIME_SUCCESS)
+   {
+      return MIME_FAILURE;
+   }
+
+   ssc_mime_part(m, MIME_CT_SDP, sdp, sdp_len);
+   ssc_mime_part(m, MIME_CT_RS_METADATA, metadata, md_len);
+
+   return ssc_mime_finish(m, pl);
+}
+
+
+/** internal functions follow **/
+
+int priv_mime_put(ssc_mime_t *m, const void *data, size_t len)
+{
+   if (m->failed)
+   {
+      return MIME_FAILURE;
+   }
+
+   if (m->len + len > m->size && priv_mime_grow(m, m->len + len, 0) != MIME_SUCCESS)
+   {
+      m->failed = 1;
+      return MIME_FAILURE;
+   }
+
+   memcpy(m->buf + m->len, data, len);
+   m->len += len;
+
+   return MIME_SUCCESS;
+}
+
+// writes the delimiter line that starts a part
+void priv_mime_delim(ssc_mime_t *m)
+{
+   // the first delimiter has no leading CRLF
+   if (m->parts++ == 0)
+   {
+      priv_mime_put(m, MIME_DASHES, strlen(MIME_DASHES));
+   }
+   else
+   {
+      priv_mime_put(m, MIME_CRLF MIME_DASHES, strlen(MIME_CRLF MIME_DASHES));
+   }
+
+   priv_mime_put(m, m->boundary->str, m->boundary->len);
+   priv_mime_put(m, MIME_CRLF, strlen(MIME_CRLF));
+}
+
+int priv_mime_ends_crlf(const char *s, size_t len)
+{
+   return len >= 2 && s[len-2] == '\r' && s[len-1] == '\n';
+}
+
+int priv_mime_grow(ssc_mime_t *m, size_t need, int exact)
+{
+   if (!m->home)
+   {
+      return MIME_FAILURE;
+   }
+
+   // streamed bodies grow geometrically; reservations are taken as given
+   size_t size = need;
+   if (!exact)
+   {
+      size = m->size ? m->size : 1024;
+      while (size < need)
+      {
+         size *= 2;
+      }
+   }
+
+   char *buf;
+   if (m->owned)
+   {
+      buf = (char *)su_realloc(m->home, m->buf, size);
+   }
+   else
+   {
+      // leaving caller storage; carry over what was written so far
+      buf = (char *)su_alloc(m->home, size);
+      if (buf && m->len)
+      {
+         memcpy(buf, m->buf, m->len);
+      }
+   }
+
+   if (!buf)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, size);
+      return MIME_FAILURE;
+   }
+
+   m->buf = buf;
+   m->size = size;
+   m->owned = 1;
+
+   return MIME_SUCCESS;
+}
@@ -0,0 +1,200 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// builds multipart/mixed bodies directly into one flat buffer.
+///
+/// the sofia msg_multipart_* route copies every part at least three times
+/// (part creation, serialization and the final flattening into a payload).
+/// this writer instead appends the boundary lines, part headers and part
+/// bodies to a single buffer, so each body byte is copied exactly once.
+///
+/// the buffer can be supplied by the caller; it is only replaced by a
+/// buffer from the writer's home if it turns out to be too small.  when
+/// the part sizes are known in advance, ssc_mime_part_size() and
+/// ssc_mime_close_size() give the exact total so the buffer can be sized
+/// (or reserved) once.
+///
+/// a boundary is just a string, so one ssc_mime_boundary_t can be set up
+/// once and reused for any number of bodies.
+
+#include <stddef.h>
+
+#include <sofia-sip/sip.h>
+#include <sofia-sip/su_alloc.h>
+
+/// some simple return codes
+#define MIME_SUCCESS   0
+#define MIME_FAILURE  -1
+
+/// RFC 2046 limits boundaries to 70 characters
+#define SSC_MIME_BOUNDARY_MAX 70
+
+typedef struct ssc_mime_boundary_s
+{
+   char str[SSC_MIME_BOUNDARY_MAX + 1];
+   size_t len;
+} ssc_mime_boundary_t;
+
+/// one part of a multipart body, given by pointer and length.  @p headers
+/// holds the part's header lines separated by CRLF; it may be empty and
+/// does not need a trailing CRLF (the blank line before the body is
+/// always added).
+typedef struct ssc_mime_part_s
+{
+   const char *headers;
+   size_t headers_len;
+   const void *body;
+   size_t body_len;
+} ssc_mime_part_t;
+
+/// multipart writer state.  set up with ssc_mime_init(); the fields are
+/// private to ssc_mime.c.
+typedef struct ssc_mime_s
+{
+   su_home_t *home;                      // home for buffer growth, may be NULL
+   const ssc_mime_boundary_t *boundary;
+   char *buf;
+   size_t len;                           // bytes written so far
+   size_t size;                          // size of buf
+   unsigned parts;                       // number of parts begun
+   unsigned owned : 1;                   // buf was allocated from home
+   unsigned failed : 1;                  // a write did not fit; body is unusable
+} ssc_mime_t;
+
+/// set up a boundary.
+///
+/// @param[in]  b      boundary to set up
+/// @param[in]  str    [optional] boundary string to use. if NULL, a random
+///                    one is generated.  longer strings are truncated to
+///                    SSC_MIME_BOUNDARY_MAX characters.
+void ssc_mime_boundary_init(ssc_mime_boundary_t *b, const char *str);
+
+/// make the multipart/mixed Content-Type header matching a boundary.
+///
+/// @param[in]  home   memory home for the header
+/// @param[in]  b      boundary used for the body
+///
+/// @return the header, or NULL on failure.
+sip_content_type_t *ssc_mime_content_type(su_home_t *home, const ssc_mime_boundary_t *b);
+
+/// returns the number of bytes a part with the given content type and body
+/// length adds to a body, including its delimiter line.  the first part of
+/// a body is 2 bytes shorter (its delimiter has no leading CRLF).
+///
+/// @param[in]  b             boundary used for the body
+/// @param[in]  content_type  part content type
+/// @param[in]  body_len      length of the part body
+size_t ssc_mime_part_size(const ssc_mime_boundary_t *b, const char *content_type, size_t body_len);
+
+/// returns the number of bytes the closing delimiter adds to a body.
+///
+/// @param[in]  b      boundary used for the body
+size_t ssc_mime_close_size(const ssc_mime_boundary_t *b);
+
+/// returns the exact size of a body made of the given parts, including all
+/// delimiters.
+///
+/// @param[in]  b      boundary used for the body
+/// @param[in]  parts  the parts
+/// @param[in]  n      number of entries in @p parts
+size_t ssc_mime_parts_size(const ssc_mime_boundary_t *b, const ssc_mime_part_t parts[], unsigned n);
+
+/// set up a writer.
+///
+/// @param[in]  m        writer to set up
+/// @param[in]  home     [optional] home used if the body outgrows @p storage.
+///                      if NULL, writes that do not fit fail.
+/// @param[in]  b        boundary to use; must outlive the writer
+/// @param[in]  storage  [optional] caller-owned buffer to write into
+/// @param[in]  size     size of @p storage
+void ssc_mime_init(ssc_mime_t *m, su_home_t *home, const ssc_mime_boundary_t *b, char *storage, size_t size);
+
+/// make sure at least @p size bytes in total fit in the writer's buffer.
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE if the buffer could not be grown.
+int ssc_mime_reserve(ssc_mime_t *m, size_t size);
+
+/// start a new part: writes the delimiter line and the part headers.
+///
+/// @param[in]  m             writer to use
+/// @param[in]  content_type  part content type
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE if the data did not fit.
+int ssc_mime_part_begin(ssc_mime_t *m, const char *content_type);
+
+/// append body data to the current part.  may be called any number of
+/// times per part.
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE if the data did not fit.
+int ssc_mime_write(ssc_mime_t *m, const void *data, size_t len);
+
+/// add a complete part; same as ssc_mime_part_begin() plus ssc_mime_write().
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE if the data did not fit.
+int ssc_mime_part(ssc_mime_t *m, const char *content_type, const void *body, size_t len);
+
+/// write the closing delimiter and point @p pl at the finished body.  the
+/// payload borrows the writer's buffer; nothing is copied.
+///
+/// @param[in]  m      writer to finish
+/// @param[out] pl     payload to fill in
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE if any write failed.
+int ssc_mime_finish(ssc_mime_t *m, sip_payload_t *pl);
+
+/// point @p pl at everything written so far, without adding a closing
+/// delimiter.  for bodies written entirely with ssc_mime_write().
+///
+/// @param[in]  m      writer to use
+/// @param[out] pl     payload to fill in
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE if any write failed.
+int ssc_mime_payload(ssc_mime_t *m, sip_payload_t *pl);
+
+/// build a body from any number of parts in one pass.  the exact size is
+/// computed first, so the buffer is sized only once.
+///
+/// @param[in]  m      writer set up with ssc_mime_init()
+/// @param[in]  parts  the parts
+/// @param[in]  n      number of entries in @p parts
+/// @param[out] pl     payload to fill in
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE on failure.
+int ssc_mime_build(ssc_mime_t *m, const ssc_mime_part_t parts[], unsigned n, sip_payload_t *pl);
+
+/// build a SIPREC body (SDP part plus rs-metadata part) in one pass.  the
+/// exact body size is computed first so the buffer is sized only once.
+///
+/// @param[in]  m          writer set up with ssc_mime_init()
+/// @param[in]  sdp        SDP part body
+/// @param[in]  sdp_len    length of @p sdp
+/// @param[in]  metadata   rs-metadata part body
+/// @param[in]  md_len     length of @p metadata
+/// @param[out] pl         payload to fill in
+///
+/// @return MIME_SUCCESS, or MIME_FAILURE on failure.
+int ssc_mime_siprec(ssc_mime_t *m,
+      const char *sdp, size_t sdp_len,
+      const char *metadata, size_t md_len,
+      sip_payload_t *pl);
@@ -58,6 +58,13 @@
 #include "ssc_sip.h"
 #include "ssc_oper.h"
 #include "ssc_oper_container.h"
+#include "ssc_oper_timer.h"
+#include "ssc_group.h"
+#include "ssc_stats.h"
+#include "ssc_probe.h"
+
+static ssc_oper_t *priv_ssc_oper_alloc(ssc_t *ssc);
+static void priv_ssc_oper_pool_init(ssc_oper_t *op);
 
 static ssc_oper_t *priv_ssc_oper_create(
       ssc_t *ssc,
@@ -253,11 +260,131 @@ ssc_oper_t *ssc_oper_create(
          ssc_oper_destroy(ssc, op);
          op = NULL;
       }
+      else
+      {
+         op->op_times.t_created = ssc_clock_us();
+         ssc_tw_touch(ssc, op);
+         SSC_PROBE2(op__create, op, (int)op->op_method);
+      }
    }
 
    return op;
 }
 
+// in the packed layout the container node is carved out of the same
+// allocation as the operation, just past the (pointer aligned) op struct.
+#define SSC_OPER_PACKED_NODE_OFFSET \
+   ((sizeof(ssc_oper_t) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+/**
+ * Allocates a zeroed operation object, using the packed single
+ * allocation layout if the SSC has it enabled.
+ */
+ssc_oper_t *priv_ssc_oper_alloc(ssc_t *ssc)
+{
+  ssc_oper_t *op;
+
+  if ((op = ssc->ssc_op_free)) {
+    ssc->ssc_op_free = op->op_next;
+    ssc->ssc_op_pool_free--;
+    priv_ssc_oper_pool_init(op);
+    op->op_packed = ssc->ssc_op_packed != 0;
+    return op;
+  }
+
+  if (!ssc->ssc_op_packed)
+    return su_zalloc(ssc->ssc_home, sizeof(*op));
+
+  op = su_zalloc(ssc->ssc_home, SSC_OPER_PACKED_NODE_OFFSET + ssc_oc_node_size());
+  if (op) {
+    op->op_packed = 1;
+    op->oc_storage = (char *)op + SSC_OPER_PACKED_NODE_OFFSET;
+  }
+
+  return op;
+}
+
+/* pooled ops always carry container node storage, packed or not */
+#define SSC_OPER_POOL_BLOCK_SIZE \
+  ((SSC_OPER_PACKED_NODE_OFFSET + ssc_oc_node_size() + 7) & ~(size_t)7)
+
+/* every slab starts with a link to the next one so they can be released */
+#define SSC_OPER_POOL_SLAB_HDR \
+  ((sizeof(void *) + 7) & ~(size_t)7)
+
+/**
+ * Resets a block taken from (or returned to) the op pool.
+ */
+void priv_ssc_oper_pool_init(ssc_oper_t *op)
+{
+  memset(op, 0, SSC_OPER_POOL_BLOCK_SIZE);
+  op->op_pooled = 1;
+  op->oc_storage = (char *)op + SSC_OPER_PACKED_NODE_OFFSET;
+}
+
+/**
+ * Pre-allocates room for 'count' more operations in one slab and
+ * puts them on the free list. The slab is zeroed on allocation, so
+ * its pages are faulted in here rather than on the signaling path.
+ */
+int ssc_oper_pool_reserve(ssc_t *ssc, unsigned count)
+{
+  char *slab;
+  unsigned i;
+
+  if (!ssc || !ssc->ssc_home)
+    return -1;
+
+  if (count == 0)
+    return 0;
+
+  slab = su_zalloc(ssc->ssc_home,
+		   SSC_OPER_POOL_SLAB_HDR + (size_t)count * SSC_OPER_POOL_BLOCK_SIZE);
+  if (!slab) {
+    SSCError("%s: cannot pre-allocate %u operations", __func__, count);
+    return -1;
+  }
+
+  *(void **)slab = ssc->ssc_op_slabs;
+  ssc->ssc_op_slabs = slab;
+
+  /* push in reverse so ops are handed out in address order */
+  for (i = count; i > 0; i--) {
+    ssc_oper_t *op = (ssc_oper_t *)(slab + SSC_OPER_POOL_SLAB_HDR +
+				    (size_t)(i - 1) * SSC_OPER_POOL_BLOCK_SIZE);
+    priv_ssc_oper_pool_init(op);
+    op->op_next = ssc->ssc_op_free;
+    ssc->ssc_op_free = op;
+  }
+
+  ssc->ssc_op_pool_size += count;
+  ssc->ssc_op_pool_free += count;
+
+  return 0;
+}
+
+/**
+ * Releases all op pool slabs. Any pooled operation still in use
+ * becomes invalid.
+ */
+void ssc_oper_pool_release(ssc_t *ssc)
+{
+  void *slab, *next;
+
+  if (!ssc)
+    return;
+
+  for (slab = ssc->ssc_op_slabs; slab; slab = next) {
+    next = *(void **)slab;
+    su_free(ssc->ssc_home, slab);
+  }
+
+  ssc->ssc_op_slabs = NULL;
+  ssc->ssc_op_free = NULL;
+  ssc->ssc_op_pool_size = 0;
+  ssc->ssc_op_pool_free = 0;
+}
+
 /**
  * Creates a new operation object and stores it the list of
  * active operations for 'cli'.
@@ -292,7 +419,7 @@ ssc_oper_t *priv_ssc_oper_create(ssc_t *ssc,
       return NULL;
     }
 
-    if (!(op = su_zalloc(ssc->ssc_home, sizeof(*op)))) {
+    if (!(op = priv_ssc_oper_alloc(ssc))) {
       SSCDebugHigh("%s: %s: cannot create handle", ssc->ssc_name, name);
       return NULL;
     }
@@ -311,7 +438,8 @@ ssc_oper_t *priv_ssc_oper_create(ssc_t *ssc,
 
     ta_end(ta);  
      
-    op->op_ident = sip_header_as_string(ssc->ssc_home, (sip_header_t *)to);
+    if (!op->op_packed)
+      op->op_ident = sip_header_as_string(ssc->ssc_home, (sip_header_t *)to);
 
     ssc_oper_assign(op, method, name);
     
@@ -348,13 +476,15 @@ ssc_oper_t *priv_ssc_oper_create_with_handle(ssc_t *ssc,
 
   enter;
 
-  if ((op = su_zalloc(ssc->ssc_home, sizeof(*op)))) {
+  if ((op = priv_ssc_oper_alloc(ssc))) {
     op->op_next = ssc->ssc_operations;
     ssc->ssc_operations = op;      
 
     ssc_oper_assign(op, method, name);
     nua_handle_bind(op->op_handle = nh, op);
-    op->op_ident = sip_header_as_string(ssc->ssc_home, (sip_header_t*)from);
+    op->op_ident_from = 1;
+    if (!op->op_packed)
+      op->op_ident = sip_header_as_string(ssc->ssc_home, (sip_header_t*)from);
     op->op_ssc = ssc;
   }
   else {
@@ -376,7 +506,11 @@ void ssc_oper_destroy(ssc_t *ssc, ssc_oper_t *op)
   if (!op)
     return;
 
+  SSC_PROBE2(op__destroy, op, (int)op->op_method);
+
   ssc_oc_rem_op(ssc, op);
+  ssc_tw_rem_op(ssc, op);
+  ssc_group_rem_op(op);
 
   /* Remove from queue */
   for (prev = &ssc->ssc_operations; 
@@ -401,6 +535,20 @@ void ssc_oper_destroy(ssc_t *ssc, ssc_oper_t *op)
       ssc->ssc_oper_destroyed_cb(op->userData);
    }
 
+  if (op->op_ident)
+    su_free(ssc->ssc_home, (void *)op->op_ident), op->op_ident = NULL;
+
+  if (op->op_fr)
+    su_free(ssc->ssc_home, op->op_fr), op->op_fr = NULL;
+
+  if (op->op_pooled) {
+    /* back to the free list; the block stays warm for the next op */
+    op->op_next = ssc->ssc_op_free;
+    ssc->ssc_op_free = op;
+    ssc->ssc_op_pool_free++;
+    return;
+  }
+
   su_free(ssc->ssc_home, op);
 }
 
@@ -422,6 +570,96 @@ void ssc_oper_assign(ssc_oper_t *op, sip_method_t method, char const *name)
 	op->sip = NULL;
 }
 
+/**
+ * Returns the remote identity of the operation, formatting
+ * it from the handle on first use.
+ */
+const char *ssc_oper_ident(ssc_oper_t *op)
+{
+  if (!op)
+    return "<nil>";
+
+  if ((!op->op_ident || op->op_ident_key) && op->op_handle && op->op_ssc) {
+    sip_to_t const *remote = nua_handle_remote(op->op_handle);
+    if (remote) {
+      if (op->op_ident)
+        su_free(op->op_ssc->ssc_home, (void *)op->op_ident);
+      op->op_ident = sip_header_as_string(op->op_ssc->ssc_home, (sip_header_t *)remote);
+      op->op_ident_key = 0;
+    }
+  }
+
+  /* no dialog yet; fall back to the key the op was stored under */
+  if (!op->op_ident && op->op_ssc) {
+    const char *user, *host;
+    if (ssc_oc_get_uri(op, op->op_ident_from, &user, &host) == OC_SUCCESS) {
+      if (strcmp(user, "<nil>") == 0)
+        op->op_ident = su_sprintf(op->op_ssc->ssc_home, "<sip:%s>", host);
+      else
+        op->op_ident = su_sprintf(op->op_ssc->ssc_home, "<sip:%s@%s>", user, host);
+      op->op_ident_key = op->op_ident != NULL;
+    }
+  }
+
+  return op->op_ident ? op->op_ident : "<nil>";
+}
+
+/**
+ * Appends an event to the flight recorder ring of the operation.
+ */
+void ssc_oper_fr_record(ssc_oper_t *op, int event, int status,
+                        int state_before, int state_after)
+{
+  ssc_fr_rec_t *rec;
+
+  if (!op || !op->op_ssc || !op->op_ssc->ssc_fr_enabled)
+    return;
+
+  if (!op->op_fr) {
+    op->op_fr = su_zalloc(op->op_ssc->ssc_home, SSC_FR_DEPTH * sizeof(ssc_fr_rec_t));
+    if (!op->op_fr)
+      return;
+  }
+
+  rec = &op->op_fr[op->op_fr_count % SSC_FR_DEPTH];
+  rec->fr_ts = ssc_clock_us();
+  rec->fr_event = (int16_t)event;
+  rec->fr_status = (int16_t)status;
+  rec->fr_state_before = (int8_t)state_before;
+  rec->fr_state_after = (int8_t)state_after;
+
+  ++op->op_fr_count;
+}
+
+/**
+ * Logs the flight recorder ring of the operation, oldest first.
+ */
+void ssc_oper_fr_dump(ssc_oper_t *op, const char *reason)
+{
+  uint32_t i, first, n;
+  uint64_t t0;
+
+  if (!op || !op->op_fr)
+    return;
+
+  n = op->op_fr_count < SSC_FR_DEPTH ? op->op_fr_count : SSC_FR_DEPTH;
+  first = op->op_fr_count - n;
+  t0 = n ? op->op_fr[first % SSC_FR_DEPTH].fr_ts : 0;
+
+  SSCWarning("op <%p> %s %s: %s, last %u of %u events:",
+        op, op->op_method_name ? op->op_method_name : "<nil>",
+        ssc_oper_ident(op), reason ? reason : "dump", n, op->op_fr_count);
+
+  for (i = first; i < op->op_fr_count; i++) {
+    ssc_fr_rec_t const *rec = &op->op_fr[i % SSC_FR_DEPTH];
+
+    SSCWarning("  +%8llu us %-20s %03d state %d -> %d",
+          (unsigned long long)(rec->fr_ts - t0),
+          nua_event_name((nua_event_t)rec->fr_event),
+          rec->fr_status, rec->fr_state_before, rec->fr_state_after);
+  }
+}
+
 /**
  * Finds a call operation (an operation that has non-zero
  * op_callstate).
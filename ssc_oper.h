@@ -57,12 +57,32 @@ typedef struct ssc_oper_s ssc_oper_t;
 #define enter (void)0
 #endif
 
+/** Number of events kept in each operation's flight recorder ring */
+#ifndef SSC_FR_DEPTH
+#define SSC_FR_DEPTH 16
+#endif
+
+/** Most ops the pool is grown to on demand (see ssc_invite_group()) */
+#ifndef SSC_OPER_POOL_MAX
+#define SSC_OPER_POOL_MAX 4096
+#endif
+
+/** One flight recorder entry; written without any formatting */
+typedef struct ssc_fr_rec_s {
+  uint64_t      fr_ts;             /**< ssc_clock_us() when the event arrived */
+  int16_t       fr_event;          /**< nua_event_t */
+  int16_t       fr_status;         /**< status code delivered with the event */
+  int8_t        fr_state_before;   /**< NUA call state before the event */
+  int8_t        fr_state_after;    /**< NUA call state after the event */
+} ssc_fr_rec_t;
+
 struct ssc_oper_s {
   ssc_oper_t   *op_next;
 
   /**< Remote end identity
    *
    * Contents of To: when initiating, From: when receiving.
+   * Formatted lazily for packed ops; read it via ssc_oper_ident().
    */
   char const   *op_ident;	
 
@@ -101,10 +121,39 @@ struct ssc_oper_s {
 
   unsigned      op_persistent : 1; /**< Is this handle persistent? */
   unsigned      op_referred : 1;
+  unsigned      op_packed : 1;     /**< Op and container node share one allocation */
+  unsigned      op_fr_dumped : 1;  /**< Flight recorder already dumped on failure */
+  unsigned      op_pooled : 1;     /**< Op block belongs to the SSC op pool */
+  unsigned      op_log_verbose : 1; /**< Selected for verbose logging, see ssc_log_ctx.h */
+  unsigned      op_ident_from : 1; /**< Remote end is the From: key (op bound to a received request) */
+  unsigned      op_ident_key : 1;  /**< op_ident was formatted from the container keys */
   unsigned :0;
 
+  /** Monotonic timestamps (usec, see ssc_clock_us()) of lifecycle
+   *  transitions seen on this operation. 0 until the transition occurs.
+   */
+  struct {
+    uint64_t    t_created;         /**< Operation created */
+    uint64_t    t_req_sent;        /**< Initial INVITE/REGISTER/OPTIONS sent */
+    uint64_t    t_1xx;             /**< First provisional response received */
+    uint64_t    t_2xx;             /**< Final 2xx sent or received */
+    uint64_t    t_ready;           /**< 2xx ACKed, call established */
+  } op_times;
+
+  /** Flight recorder: last SSC_FR_DEPTH events seen on this operation.
+   *  Allocated on the first event, and only when ssc_fr_enabled is set. */
+  ssc_fr_rec_t *op_fr;
+  uint32_t      op_fr_count;       /**< Total events recorded */
+
   void *userData; /* magic for callbacks */
   void *oc_node; /*used by operator container, do not touch! */
+  void *oc_storage; /* inline container node storage for packed ops, do not touch! */
+
+  ssc_oper_t  *tw_next;     /* used by op timer wheel, do not touch! */
+  ssc_oper_t **tw_pprev;    /* used by op timer wheel, do not touch! */
+  uint64_t     tw_deadline; /* used by op timer wheel, do not touch! */
+
+  void        *op_group;    /* used by ssc op groups, do not touch! */
 };
 
 // search the SSC operation list for a matching SIP
@@ -203,6 +252,36 @@ void ssc_oper_destroy(ssc_t *ssc, ssc_oper_t *op);
 
 void ssc_oper_assign(ssc_oper_t *op, sip_method_t method, char const *name);
 
+// pre-allocate @p count operations in a single slab and keep them on the
+// SSC's free list. ops created later are taken from the list before any
+// new allocation is made, and destroyed pooled ops go back on it.
+// pooled ops carry their container node inline like packed ops do.
+// @return 0 on success, -1 on failure.
+int ssc_oper_pool_reserve(ssc_t *ssc, unsigned count);
+
+// release all slabs reserved with ssc_oper_pool_reserve(). pooled ops
+// still in use become invalid, so only call this on teardown.
+void ssc_oper_pool_release(ssc_t *ssc);
+
+// return the remote end identity of the operation as a string.
+// the identity is formatted from the NUA handle on first use and cached
+// in op_ident, so callers that never log it never pay for it.
+// until the handle knows its remote end, the To: (or From: for received
+// requests) key the op was stored under is used instead.
+// @return identity string, or "<nil>" if it cannot be determined.
+const char *ssc_oper_ident(ssc_oper_t *op);
+
+// append an event to the operation's flight recorder ring, overwriting
+// the oldest entry once the ring is full. no formatting is done here.
+// does nothing unless the owning SSC has ssc_fr_enabled set; the ring
+// is allocated on the first event recorded.
+void ssc_oper_fr_record(ssc_oper_t *op, int event, int status,
+                        int state_before, int state_after);
+
+// log the contents of the operation's flight recorder ring, oldest
+// event first.  @p reason is included in the log header.
+void ssc_oper_fr_dump(ssc_oper_t *op, const char *reason);
+
 ssc_oper_t *ssc_oper_find_call(ssc_t *ssc);
 ssc_oper_t *ssc_oper_find_call_in_progress(ssc_t *ssc);
 ssc_oper_t *ssc_oper_find_call_embryonic(ssc_t *ssc);
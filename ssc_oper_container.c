@@ -34,6 +34,8 @@
 #include "ssc_log.h"
 #include "ssc_sip.h"
 #include "ssc_oper.h"
+#include "ssc_probe.h"
+#include "ssc_metrics.h"
 
 #define OC_BUCKETS 4098
 #define OC_NUM_METHODS 15
@@ -45,13 +47,18 @@
 #define OC_METHOD_MATCH_ID  1
 #define OC_METHOD_MATCH_NAME  2
 
+// key strings shorter than this are stored inline in the node rather than
+// in a separate allocation. sized to fit typical user and host parts.
+#define OC_SSO_SIZE 32
+
 struct ssc_op_container_s;
 
 typedef struct ssc_oc_str_s
 {
    unsigned len;
    unsigned hash;
-   char *str;
+   char *str;               // points at sso for short strings
+   char sso[OC_SSO_SIZE];
 } ssc_oc_str_t;
 
 typedef struct ssc_oc_uri_s
@@ -69,6 +76,8 @@ typedef struct ssc_oc_op_s
    unsigned s_index;
    unsigned m_index;
 
+   unsigned embedded : 1;  // node lives in the op's own allocation
+
    ssc_oc_uri_t to;
    ssc_oc_uri_t from;
 
@@ -122,9 +131,50 @@ static void priv_oc_str_free(const ssc_t *ssc, ssc_oc_str_t *s);
 static void priv_oc_op_free(const ssc_t *ssc, ssc_oc_op_t *oc_op);
 static unsigned priv_oc_count_elements(const ssc_oc_op_t *oc_op);
 static int priv_oc_add(ssc_t *ssc, ssc_oper_t *op, const ssc_oc_id_t *id);
+static ssc_op_container_t *priv_oc_create(ssc_t *ssc);
 static ssc_oper_t *priv_oc_find(const ssc_op_container_t *oc, const ssc_oc_find_param_t *findParams);
-static ssc_oper_t *priv_oc_find_any(ssc_oc_op_t *l, const ssc_oc_uri_t *to, const ssc_oc_uri_t *from);
-static ssc_oper_t *priv_oc_find_method_name(ssc_oc_op_t *l, const ssc_oc_uri_t *to, const ssc_oc_uri_t *from, const ssc_oc_str_t *name);
+static ssc_oper_t *priv_oc_find_any(ssc_oc_op_t *l, const ssc_oc_uri_t *to, const ssc_oc_uri_t *from, unsigned *probes);
+static ssc_oper_t *priv_oc_find_method_name(ssc_oc_op_t *l, const ssc_oc_uri_t *to, const ssc_oc_uri_t *from, const ssc_oc_str_t *name, unsigned *probes);
+
+size_t ssc_oc_node_size(void)
+{
+   return sizeof(ssc_oc_op_t);
+}
+
+int ssc_oc_get_uri(const ssc_oper_t *op, int from, const char **user, const char **host)
+{
+   if (!op || !user || !host)
+   {
+      SSCError("%s: NULL ptr arg", __func__);
+      return OC_FAILURE;
+   }
+
+   const ssc_oc_op_t *oc_op = (const ssc_oc_op_t *)op->oc_node;
+   if (!oc_op) { return OC_FAILURE; }
+
+   const ssc_oc_uri_t *uri = from ? &oc_op->from : &oc_op->to;
+   *user = uri->user.str;
+   *host = uri->host.str;
+
+   return OC_SUCCESS;
+}
+
+int ssc_oc_reserve(ssc_t *ssc)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return OC_FAILURE;
+   }
+
+   if (!ssc->ssc_home)
+   {
+      SSCError("%s: NULL ssc home context ptr", __func__);
+      return OC_FAILURE;
+   }
+
+   return priv_oc_create(ssc) ? OC_SUCCESS : OC_FAILURE;
+}
 
 void ssc_oc_free(ssc_t *ssc)
 {
@@ -240,7 +290,10 @@ int ssc_oc_add_op(ssc_t *ssc, ssc_oper_t *op)
    id.from_user = opFromUser;
    id.from_host = opFromHost;
 
-   return priv_oc_add(ssc, op, &id);
+   int rv = priv_oc_add(ssc, op, &id);
+   SSC_PROBE2(oc__add, op, rv);
+
+   return rv;
 }
 
 int ssc_oc_add_op_uri(ssc_t *ssc, ssc_oper_t *op, const sip_to_t *to, const sip_to_t *from)
@@ -266,7 +319,10 @@ int ssc_oc_add_op_uri(ssc_t *ssc, ssc_oper_t *op, const sip_to_t *to, const sip_
    id.from_user = opFromUser;
    id.from_host = opFromHost;
 
-   return priv_oc_add(ssc, op, &id);
+   int rv = priv_oc_add(ssc, op, &id);
+   SSC_PROBE2(oc__add, op, rv);
+
+   return rv;
 }
 
 int ssc_oc_add_op_uri_str(ssc_t *ssc, ssc_oper_t *op, const char *to, const char *from)
@@ -318,6 +374,7 @@ int ssc_oc_add_op_uri_str(ssc_t *ssc, ssc_oper_t *op, const char *to, const char
    id.from_host = opFromHost;
 
    int rv = priv_oc_add(ssc, op, &id);
+   SSC_PROBE2(oc__add, op, rv);
 
    if (toUri)
    {
@@ -374,6 +431,9 @@ void ssc_oc_rem_op(const ssc_t *ssc, ssc_oper_t *op)
    op->oc_node = NULL;
 
    if (oc->count > 0) { --oc->count; }
+   ssc_metrics_op_removed(op);
+
+   SSC_PROBE1(oc__remove, op);
    
    priv_oc_op_free(ssc, oc_op);
 }
@@ -719,19 +779,11 @@ int priv_oc_add(ssc_t *ssc, ssc_oper_t *op, const ssc_oc_id_t *id)
       return OC_FAILURE;
    }
 
-   ssc_op_container_t *oc = ssc->ssc_oc;
-
    // create a new collection object in this SSC context if we need one
+   ssc_op_container_t *oc = priv_oc_create(ssc);
    if (!oc)
    {
-      oc = (ssc_op_container_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_op_container_t));
-      if (!oc)
-      {
-         SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_op_container_t));
-         return OC_FAILURE;
-      }
-
-      ssc->ssc_oc = oc;
+      return OC_FAILURE;
    }
 
    // operation method bounds checks..
@@ -752,12 +804,23 @@ int priv_oc_add(ssc_t *ssc, ssc_oper_t *op, const ssc_oc_id_t *id)
       }
    }
 
-   // create collectable node for the operation
-   ssc_oc_op_t *oc_op = (ssc_oc_op_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_oc_op_t));
-   if (!oc_op)
+   // create collectable node for the operation. packed ops carry room for
+   // the node in their own allocation so no extra alloc is needed.
+   ssc_oc_op_t *oc_op = NULL;
+   if (op->oc_storage)
    {
-      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_oc_op_t));
-      return OC_FAILURE;
+      oc_op = (ssc_oc_op_t *)op->oc_storage;
+      memset(oc_op, 0, sizeof(ssc_oc_op_t));
+      oc_op->embedded = 1;
+   }
+   else
+   {
+      oc_op = (ssc_oc_op_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_oc_op_t));
+      if (!oc_op)
+      {
+         SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_oc_op_t));
+         return OC_FAILURE;
+      }
    }
 
    op->oc_node = oc_op;
@@ -822,13 +885,34 @@ int priv_oc_add(ssc_t *ssc, ssc_oper_t *op, const ssc_oc_id_t *id)
    }
 
    ++oc->count;
+   ssc_metrics_op_added(op);
 
    return OC_SUCCESS;
 }
 
+ssc_op_container_t *priv_oc_create(ssc_t *ssc)
+{
+   ssc_op_container_t *oc = (ssc_op_container_t *)ssc->ssc_oc;
+
+   if (!oc)
+   {
+      oc = (ssc_op_container_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_op_container_t));
+      if (!oc)
+      {
+         SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_op_container_t));
+         return NULL;
+      }
+
+      ssc->ssc_oc = oc;
+   }
+
+   return oc;
+}
+
 ssc_oper_t *priv_oc_find(const ssc_op_container_t *oc, const ssc_oc_find_param_t *findParams)
 {
    ssc_oper_t *op = NULL;
+   unsigned probes = 0;
 
    ssc_oc_uri_t cmpToUri;
    ssc_oc_uri_t cmpFromUri;
@@ -879,27 +963,31 @@ ssc_oper_t *priv_oc_find(const ssc_op_container_t *oc, const ssc_oc_find_param_t
       unsigned m;
       for ( m=0; m < OC_BUCKETS && !op; ++m)
       {
-         op = priv_oc_find_any(oc->slot[sindex].method[m], &cmpToUri, &cmpFromUri);
+         op = priv_oc_find_any(oc->slot[sindex].method[m], &cmpToUri, &cmpFromUri, &probes);
       }
    }
    else if (findParams->match_method == OC_METHOD_MATCH_ID)
    {
-      op = priv_oc_find_any(oc->slot[sindex].method[findParams->m_index], &cmpToUri, &cmpFromUri);
+      op = priv_oc_find_any(oc->slot[sindex].method[findParams->m_index], &cmpToUri, &cmpFromUri, &probes);
    }
    else
    {
-      op = priv_oc_find_method_name(oc->slot[sindex].method[0], &cmpToUri, &cmpFromUri, &cmpMethodName);
+      op = priv_oc_find_method_name(oc->slot[sindex].method[0], &cmpToUri, &cmpFromUri, &cmpMethodName, &probes);
    }
 
+   SSC_PROBE2(oc__find, op, probes);
+
    return op;
 }
 
-ssc_oper_t *priv_oc_find_any(ssc_oc_op_t *opList, const ssc_oc_uri_t *cmpTo, const ssc_oc_uri_t *cmpFrom)
+ssc_oper_t *priv_oc_find_any(ssc_oc_op_t *opList, const ssc_oc_uri_t *cmpTo, const ssc_oc_uri_t *cmpFrom, unsigned *probes)
 {
    ssc_oper_t *op = NULL;
 
    for (;opList && !op; opList = opList->next)
    {
+      ++*probes;
+
       if (opList->to.user.len != cmpTo->user.len) continue;
       if (opList->to.user.hash != cmpTo->user.hash) continue;
       if (opList->to.host.len != cmpTo->host.len) continue;
@@ -917,12 +1005,14 @@ ssc_oper_t *priv_oc_find_any(ssc_oc_op_t *opList, const ssc_oc_uri_t *cmpTo, con
    return op;
 }
 
-ssc_oper_t *priv_oc_find_method_name(ssc_oc_op_t *opList, const ssc_oc_uri_t *cmpTo, const ssc_oc_uri_t *cmpFrom, const ssc_oc_str_t *cmpName)
+ssc_oper_t *priv_oc_find_method_name(ssc_oc_op_t *opList, const ssc_oc_uri_t *cmpTo, const ssc_oc_uri_t *cmpFrom, const ssc_oc_str_t *cmpName, unsigned *probes)
 {
    ssc_oper_t *op = NULL;
 
    for (;opList && !op; opList = opList->next)
    {
+      ++*probes;
+
       if (opList->to.user.len != cmpTo->user.len) continue;
       if (opList->to.user.hash != cmpTo->user.hash) continue;
       if (opList->to.host.len != cmpTo->host.len) continue;
@@ -949,11 +1039,12 @@ void priv_oc_str_free(const ssc_t *ssc, ssc_oc_str_t *s)
 {
    if (!s) { return; }
 
-   if (s->str)
+   if (s->str && s->str != s->sso)
    {
       su_free(ssc->ssc_home, s->str);
    }
 
+   s->str = NULL;
 }
 
 void priv_oc_op_free(const ssc_t *ssc, ssc_oc_op_t *oc_op)
@@ -968,6 +1059,11 @@ void priv_oc_op_free(const ssc_t *ssc, ssc_oc_op_t *oc_op)
    priv_oc_str_free(ssc, &oc_op->from.host);
 
    priv_oc_str_free(ssc, &oc_op->method_name);
+
+   if (!oc_op->embedded)
+   {
+      su_free(ssc->ssc_home, oc_op);
+   }
 }
 
 void priv_oc_free(ssc_t *ssc, int opDestroy)
@@ -1004,6 +1100,7 @@ void priv_oc_free(ssc_t *ssc, int opDestroy)
             n = oc_op->next;
             op = oc_op->op;
 
+            ssc_metrics_op_removed(op);
             priv_oc_op_free(ssc, oc_op);
 
             if (opDestroy == OC_OP_DESTROY)
@@ -1028,7 +1125,15 @@ int priv_oc_hash_str_cpy(const ssc_t *ssc, const char *str, ssc_oc_str_t *hash_s
 
    if (hash_str->len > 0)
    {
-      hash_str->str = (char *)su_alloc(ssc->ssc_home, hash_str->len+1);
+      if (hash_str->len < OC_SSO_SIZE)
+      {
+         hash_str->str = hash_str->sso;
+      }
+      else
+      {
+         hash_str->str = (char *)su_alloc(ssc->ssc_home, hash_str->len+1);
+      }
+
       if (!hash_str->str)
       {
          SSCError("%s: alloc fail len - %u bytes", __func__, hash_str->len+1);
@@ -50,6 +50,41 @@
 #define OC_SUCCESS   0
 #define OC_FAILURE  -1
 
+/// returns the number of bytes needed to hold a collection node.
+///
+/// used by the packed operation layout, which reserves room for the node
+/// in the same allocation as the operation itself (see ssc_oper_t
+/// oc_storage). when an operation carries node storage, adding it to the
+/// collection will use that storage instead of allocating a new node.
+///
+/// @return size of a collection node in bytes
+size_t ssc_oc_node_size(void);
+
+/// get the to-uri or from-uri key an operation was stored under.
+///
+/// parts that were missing when the operation was added are returned as
+/// "<nil>".  the strings belong to the collection and stay valid until the
+/// operation is removed.
+///
+/// @param[in]  op     ptr to the SSC operation
+/// @param[in]  from   non-zero for the from-uri key, zero for the to-uri key
+/// @param[out] user   user part of the key
+/// @param[out] host   host part of the key
+///
+/// @return OC_SUCCESS, or OC_FAILURE if the operation is not in a collection.
+int ssc_oc_get_uri(const ssc_oper_t *op, int from, const char **user, const char **host);
+
+/// create the collection for the indicated SSC context up front instead of
+/// on the first add, so that the (large) bucket table is allocated and
+/// faulted in before traffic arrives.
+///
+/// if the collection already exists then nothing is done.
+///
+/// @param[in]  ssc    ptr to SSC context to use
+///
+/// @return OC_SUCCESS if the collection exists on return, OC_FAILURE otherwise.
+int ssc_oc_reserve(ssc_t *ssc);
+
 /// destruct the collection associated with the indicated SSC context and
 /// destroy the collection's contents.
 ///
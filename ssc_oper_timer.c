@@ -0,0 +1,398 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_oper_timer.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <sofia-sip/su.h>
+#include <sofia-sip/su_wait.h>
+
+#include "ssc_log.h"
+#include "ssc_sip.h"
+#include "ssc_oper.h"
+
+#define TW_LEVELS 3
+#define TW_SLOT_BITS 8
+#define TW_SLOTS (1u << TW_SLOT_BITS)
+#define TW_SLOT_MASK (TW_SLOTS - 1)
+
+// longest delta the wheel can hold; later deadlines are clamped to this
+#define TW_MAX_DELTA ((1ull << (TW_SLOT_BITS * TW_LEVELS)) - 1)
+
+// same range as the op container's per-method lists
+#define TW_NUM_METHODS 15
+
+#define TW_DEFAULT_TICK_MS 100
+#define TW_DEFAULT_BATCH 64
+
+// the reap batch is collected on the stack; keep it well within a frame
+#define TW_MAX_BATCH 1024
+
+typedef struct ssc_tw_s
+{
+   su_timer_t *timer;
+
+   unsigned tick_ms;
+   unsigned batch_max;
+   ssc_oper_reaped_cb reaped_cb;
+
+   uint64_t start_ms;   // monotonic time of tick 0
+   uint64_t now;        // current tick
+
+   unsigned count;
+
+   unsigned idle_ms[TW_NUM_METHODS];
+
+   ssc_oper_t *slot[TW_LEVELS][TW_SLOTS];
+} ssc_tw_t;
+
+static uint64_t priv_tw_clock_ms(void);
+static int priv_tw_method_index(sip_method_t method);
+static void priv_tw_link(ssc_tw_t *tw, ssc_oper_t *op, uint64_t deadline);
+static void priv_tw_unlink(ssc_tw_t *tw, ssc_oper_t *op);
+static void priv_tw_cascade(ssc_tw_t *tw, unsigned level);
+static void priv_tw_advance(ssc_t *ssc, ssc_tw_t *tw, uint64_t target);
+static void priv_tw_tick(su_root_magic_t *magic, su_timer_t *t, su_timer_arg_t *arg);
+
+int ssc_tw_start(ssc_t *ssc, unsigned tick_ms, unsigned batch_max, ssc_oper_reaped_cb cb)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return TW_FAILURE;
+   }
+
+   if (!ssc->ssc_home || !ssc->ssc_root)
+   {
+      SSCError("%s: ssc context has no home or root", __func__);
+      return TW_FAILURE;
+   }
+
+   if (ssc->ssc_tw)
+   {
+      SSCError("%s: timer wheel already running", __func__);
+      return TW_FAILURE;
+   }
+
+   ssc_tw_t *tw = (ssc_tw_t *)su_zalloc(ssc->ssc_home, sizeof(ssc_tw_t));
+   if (!tw)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_tw_t));
+      return TW_FAILURE;
+   }
+
+   tw->tick_ms = tick_ms ? tick_ms : TW_DEFAULT_TICK_MS;
+   tw->batch_max = batch_max ? batch_max : TW_DEFAULT_BATCH;
+   if (tw->batch_max > TW_MAX_BATCH)
+   {
+      SSCWarning("%s: batch_max %u clamped to %u", __func__, tw->batch_max, TW_MAX_BATCH);
+      tw->batch_max = TW_MAX_BATCH;
+   }
+   tw->reaped_cb = cb;
+   tw->start_ms = priv_tw_clock_ms();
+
+   tw->timer = su_timer_create(su_root_task(ssc->ssc_root), tw->tick_ms);
+   if (!tw->timer)
+   {
+      SSCError("%s: failed to create su_timer", __func__);
+      su_free(ssc->ssc_home, tw);
+      return TW_FAILURE;
+   }
+
+   ssc->ssc_tw = tw;
+
+   if (su_timer_set_for_ever(tw->timer, priv_tw_tick, (su_timer_arg_t *)ssc) < 0)
+   {
+      SSCError("%s: failed to start su_timer", __func__);
+      ssc_tw_stop(ssc);
+      return TW_FAILURE;
+   }
+
+   return TW_SUCCESS;
+}
+
+void ssc_tw_stop(ssc_t *ssc)
+{
+   if (!ssc) { return; }
+   if (!ssc->ssc_tw) { return; }
+
+   ssc_tw_t *tw = (ssc_tw_t *)ssc->ssc_tw;
+   ssc->ssc_tw = NULL;
+
+   if (tw->timer)
+   {
+      su_timer_destroy(tw->timer);
+   }
+
+   // detach any ops still armed so they do not point into freed slots
+   unsigned l, s;
+   for (l=0; l<TW_LEVELS; ++l)
+   {
+      for (s=0; s<TW_SLOTS; ++s)
+      {
+         ssc_oper_t *op = tw->slot[l][s];
+         while (op)
+         {
+            ssc_oper_t *n = op->tw_next;
+            op->tw_next = NULL;
+            op->tw_pprev = NULL;
+            op = n;
+         }
+      }
+   }
+
+   su_free(ssc->ssc_home, tw);
+}
+
+int ssc_tw_set_idle(ssc_t *ssc, sip_method_t method, unsigned idle_ms)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return TW_FAILURE;
+   }
+
+   ssc_tw_t *tw = (ssc_tw_t *)ssc->ssc_tw;
+   if (!tw)
+   {
+      SSCError("%s: timer wheel not running", __func__);
+      return TW_FAILURE;
+   }
+
+   int mindex = priv_tw_method_index(method);
+   if (mindex < 0)
+   {
+      SSCError("%s: method out of range (val: %d)", __func__, method);
+      return TW_FAILURE;
+   }
+
+   tw->idle_ms[mindex] = idle_ms;
+
+   return TW_SUCCESS;
+}
+
+void ssc_tw_touch(ssc_t *ssc, ssc_oper_t *op)
+{
+   if (!ssc || !op) { return; }
+
+   ssc_tw_t *tw = (ssc_tw_t *)ssc->ssc_tw;
+   if (!tw) { return; }
+
+   priv_tw_unlink(tw, op);
+
+   int mindex = priv_tw_method_index(op->op_method);
+   if (mindex < 0 || tw->idle_ms[mindex] == 0)
+   {
+      return;
+   }
+
+   // round up so an op never expires early
+   uint64_t ticks = (tw->idle_ms[mindex] + tw->tick_ms - 1) / tw->tick_ms;
+   priv_tw_link(tw, op, tw->now + (ticks ? ticks : 1));
+}
+
+void ssc_tw_rem_op(ssc_t *ssc, ssc_oper_t *op)
+{
+   if (!ssc || !op) { return; }
+
+   ssc_tw_t *tw = (ssc_tw_t *)ssc->ssc_tw;
+   if (!tw) { return; }
+
+   priv_tw_unlink(tw, op);
+}
+
+unsigned ssc_tw_size(const ssc_t *ssc)
+{
+   if (!ssc)
+   {
+      SSCError("%s: NULL ssc context ptr", __func__);
+      return 0;
+   }
+
+   const ssc_tw_t *tw = (const ssc_tw_t *)ssc->ssc_tw;
+
+   return tw ? tw->count : 0;
+}
+
+
+/** internal functions follow **/
+
+uint64_t priv_tw_clock_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+int priv_tw_method_index(sip_method_t method)
+{
+   if (method < sip_method_unknown || (unsigned)method >= TW_NUM_METHODS)
+   {
+      return -1;
+   }
+
+   return (int)method;
+}
+
+void priv_tw_link(ssc_tw_t *tw, ssc_oper_t *op, uint64_t deadline)
+{
+   uint64_t delta = deadline > tw->now ? deadline - tw->now : 1;
+   if (delta > TW_MAX_DELTA)
+   {
+      delta = TW_MAX_DELTA;
+   }
+   deadline = tw->now + delta;
+
+   // pick the lowest level whose span covers the delta
+   unsigned level = 0;
+   while (level < TW_LEVELS-1 && delta >= (1ull << (TW_SLOT_BITS * (level+1))))
+   {
+      ++level;
+   }
+
+   unsigned s = (unsigned)(deadline >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK;
+
+   op->tw_deadline = deadline;
+   op->tw_next = tw->slot[level][s];
+   op->tw_pprev = &tw->slot[level][s];
+   if (op->tw_next)
+   {
+      op->tw_next->tw_pprev = &op->tw_next;
+   }
+   tw->slot[level][s] = op;
+
+   ++tw->count;
+}
+
+void priv_tw_unlink(ssc_tw_t *tw, ssc_oper_t *op)
+{
+   if (!op->tw_pprev) { return; }
+
+   *op->tw_pprev = op->tw_next;
+   if (op->tw_next)
+   {
+      op->tw_next->tw_pprev = op->tw_pprev;
+   }
+
+   op->tw_next = NULL;
+   op->tw_pprev = NULL;
+
+   if (tw->count > 0) { --tw->count; }
+}
+
+void priv_tw_cascade(ssc_tw_t *tw, unsigned level)
+{
+   unsigned s = (unsigned)(tw->now >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK;
+
+   ssc_oper_t *op = tw->slot[level][s];
+   tw->slot[level][s] = NULL;
+
+   // re-file every op of this slot into a lower level
+   while (op)
+   {
+      ssc_oper_t *n = op->tw_next;
+      op->tw_next = NULL;
+      op->tw_pprev = NULL;
+      if (tw->count > 0) { --tw->count; }
+
+      priv_tw_link(tw, op, op->tw_deadline);
+      op = n;
+   }
+}
+
+void priv_tw_advance(ssc_t *ssc, ssc_tw_t *tw, uint64_t target)
+{
+   ssc_oper_t *batch[tw->batch_max];
+   unsigned n = 0;
+
+   while (tw->now < target && n < tw->batch_max)
+   {
+      ++tw->now;
+
+      // when a level wraps, pull the next slot of the level above down
+      if ((tw->now & TW_SLOT_MASK) == 0)
+      {
+         if (((tw->now >> TW_SLOT_BITS) & TW_SLOT_MASK) == 0)
+         {
+            priv_tw_cascade(tw, 2);
+         }
+         priv_tw_cascade(tw, 1);
+      }
+
+      unsigned s = (unsigned)tw->now & TW_SLOT_MASK;
+      ssc_oper_t *op = tw->slot[0][s];
+      while (op)
+      {
+         ssc_oper_t *next = op->tw_next;
+         priv_tw_unlink(tw, op);
+
+         if (op->op_prev_state == nua_callstate_ready)
+         {
+            // established call; keep it around
+            ssc_tw_touch(ssc, op);
+         }
+         else if (n < tw->batch_max)
+         {
+            batch[n++] = op;
+         }
+         else
+         {
+            // batch is full; retry on the next tick
+            priv_tw_link(tw, op, tw->now + 1);
+         }
+
+         op = next;
+      }
+   }
+
+   if (n == 0) { return; }
+
+   SSCDebugMed("%s: reaping %u idle operation(s)", __func__, n);
+
+   if (tw->reaped_cb)
+   {
+      tw->reaped_cb(ssc, batch, n, ssc->userData);
+   }
+
+   unsigned i;
+   for (i=0; i<n; ++i)
+   {
+      ssc_oper_destroy(ssc, batch[i]);
+   }
+}
+
+void priv_tw_tick(su_root_magic_t *magic, su_timer_t *t, su_timer_arg_t *arg)
+{
+   ssc_t *ssc = (ssc_t *)arg;
+   if (!ssc || !ssc->ssc_tw) { return; }
+
+   ssc_tw_t *tw = (ssc_tw_t *)ssc->ssc_tw;
+
+   // catch up on ticks the su_timer may have fired late for
+   uint64_t target = (priv_tw_clock_ms() - tw->start_ms) / tw->tick_ms;
+   priv_tw_advance(ssc, tw, target);
+}
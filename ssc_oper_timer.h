@@ -0,0 +1,110 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// provides idle expiry of SSC operations.  Several kinds of operations
+/// (received MESSAGEs, OPTIONS kept after a 2xx, failed INVITEs, ...) are
+/// never explicitly destroyed by the stack, so they would otherwise sit in
+/// the operation container forever.
+///
+/// when enabled, every operation gets an idle deadline based on its SIP
+/// method. the deadline is pushed out each time the stack delivers an event
+/// for the operation.  a hierarchical timer wheel driven by a su_timer finds
+/// the operations whose deadline passed; they are handed to the application
+/// in batches and then destroyed.
+///
+/// the wheel is optional. if ssc_tw_start() is never called, the touch and
+/// remove calls below are no-ops.
+///
+/// established calls (NUA call state 'ready') are never reaped; their
+/// deadline is simply renewed when it passes.
+
+#include "ssc_sip.h"
+#include "ssc_oper.h"
+
+/// some simple return codes
+#define TW_SUCCESS   0
+#define TW_FAILURE  -1
+
+/// called with a batch of operations that passed their idle deadline.
+/// the operations are destroyed by the library right after the callback
+/// returns (ssc_oper_destroyed_cb is still called for each one), so the
+/// callback must not destroy them itself.
+///
+/// @param[in]  ssc      ptr to SSC context owning the operations
+/// @param[in]  ops      array of expired operations
+/// @param[in]  count    number of entries in @p ops
+/// @param[in]  context  SSC userData
+typedef void (*ssc_oper_reaped_cb)(ssc_t *ssc, ssc_oper_t *ops[], unsigned count, void *context);
+
+/// create the timer wheel for the indicated SSC context and start its
+/// su_timer on the SSC root.
+///
+/// all method idle times start out as 0 (never expire); use
+/// ssc_tw_set_idle() to enable expiry for the methods of interest.
+///
+/// @param[in]  ssc        ptr to SSC context to use
+/// @param[in]  tick_ms    wheel resolution in milliseconds (0 == 100ms)
+/// @param[in]  batch_max  max number of ops reaped per tick (0 == 64, values
+///                        above 1024 are clamped). ops beyond this are
+///                        carried over to the next tick.
+/// @param[in]  cb         optional callback for reaped batches
+///
+/// @return TW_SUCCESS, or TW_FAILURE if the wheel could not be created.
+int ssc_tw_start(ssc_t *ssc, unsigned tick_ms, unsigned batch_max, ssc_oper_reaped_cb cb);
+
+/// stop the timer and release the wheel.  operations are not destroyed.
+///
+/// @param[in]  ssc    ptr to SSC context to use
+void ssc_tw_stop(ssc_t *ssc);
+
+/// set the idle time after which operations of the given method expire.
+/// operations already in the wheel pick up the new value on their next
+/// event.
+///
+/// @param[in]  ssc      ptr to SSC context to use
+/// @param[in]  method   SIP method (sip_method_unknown for unknown methods)
+/// @param[in]  idle_ms  idle time in milliseconds. 0 == never expire.
+///
+/// @return TW_SUCCESS, or TW_FAILURE on bad args or if the wheel is not running.
+int ssc_tw_set_idle(ssc_t *ssc, sip_method_t method, unsigned idle_ms);
+
+/// (re)arm the idle deadline of an operation.  called by the library on
+/// op creation and for every NUA event delivered for the operation.
+///
+/// @param[in]  ssc    ptr to SSC context to use
+/// @param[in]  op     operation to arm
+void ssc_tw_touch(ssc_t *ssc, ssc_oper_t *op);
+
+/// remove an operation from the wheel.  called by ssc_oper_destroy().
+///
+/// @param[in]  ssc    ptr to SSC context to use
+/// @param[in]  op     operation to disarm
+void ssc_tw_rem_op(ssc_t *ssc, ssc_oper_t *op);
+
+/// returns the number of operations currently armed in the wheel.
+///
+/// @param[in]  ssc    ptr to SSC context to use
+///
+/// @return number of armed operations
+unsigned ssc_tw_size(const ssc_t *ssc);
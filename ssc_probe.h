@@ -0,0 +1,62 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// USDT static tracepoints, provider "libssc".
+///
+/// built in with -D SSC_ENABLE_USDT (needs <sys/sdt.h>, e.g. from
+/// systemtap-sdt-dev).  each probe compiles to a single nop until a tracer
+/// attaches, e.g.
+///
+///   bpftrace -e 'usdt:./libssc.so:libssc:callback__entry { @[arg0] = count(); }'
+///
+/// probes and arguments:
+///   callback__entry    (event, status, op)     priv_callback() dispatch starts
+///   callback__return   (event, status, op)     priv_callback() dispatch ends
+///   invite__send       (op, call-id)           nua_invite() about to be called
+///   register__send     (op, call-id)           nua_register() about to be called
+///   answer__send       (op, status)            nua_respond() from priv_answer()
+///   oc__add            (op, result)            op added to the container
+///   oc__find           (op or NULL, probes)    container lookup; probes is the
+///                                              number of nodes compared
+///   oc__remove         (op)                    op removed from the container
+///   op__create         (op, method)            ssc_oper_create() succeeded
+///   op__destroy        (op, method)            ssc_oper_destroy() called
+///
+/// without SSC_ENABLE_USDT the probes expand to nothing.
+
+#ifdef SSC_ENABLE_USDT
+
+#include <sys/sdt.h>
+
+#define SSC_PROBE1(name, a)          DTRACE_PROBE1(libssc, name, a)
+#define SSC_PROBE2(name, a, b)       DTRACE_PROBE2(libssc, name, a, b)
+#define SSC_PROBE3(name, a, b, c)    DTRACE_PROBE3(libssc, name, a, b, c)
+
+#else
+
+#define SSC_PROBE1(name, a)          do { } while (0)
+#define SSC_PROBE2(name, a, b)       do { } while (0)
+#define SSC_PROBE3(name, a, b, c)    do { } while (0)
+
+#endif
@@ -0,0 +1,269 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_profile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sofia-sip/su_alloc.h>
+
+#include "ssc_log.h"
+
+struct ssc_profile_s
+{
+   su_home_t home[1];   // must be first; the profile is its own home
+
+   const char *field[SSC_F_COUNT];
+
+   unsigned short postProcessContactUri;
+   unsigned char callType;
+   unsigned char headerFormat;
+};
+
+// offsets of the fixed size string members of ssc_config_t, by field id.
+// pointer members (groupName, paidDisplay, paidSipUri) are handled apart.
+static const size_t priv_config_offset[SSC_F_COUNT] =
+{
+   [SSC_F_TARGET_ADDRESS]        = offsetof(ssc_config_t, targetAddress),
+   [SSC_F_REQUEST_URI]           = offsetof(ssc_config_t, requestUri),
+   [SSC_F_TO_URI]                = offsetof(ssc_config_t, toUri),
+   [SSC_F_FROM_URI]              = offsetof(ssc_config_t, fromUri),
+   [SSC_F_CALL_ID]               = offsetof(ssc_config_t, callId),
+   [SSC_F_ACCEPT]                = offsetof(ssc_config_t, accept),
+   [SSC_F_ALLOW]                 = offsetof(ssc_config_t, allow),
+   [SSC_F_VIA]                   = offsetof(ssc_config_t, via),
+   [SSC_F_EXPIRES]               = offsetof(ssc_config_t, expires),
+   [SSC_F_CONTACT_URI]           = offsetof(ssc_config_t, contactUri),
+   [SSC_F_CONTACT_URI_FEATURES]  = offsetof(ssc_config_t, contactUriFeatures),
+   [SSC_F_CONTACT_FEATURES]      = offsetof(ssc_config_t, contactFeatures),
+   [SSC_F_ACCEPT_CONTACT]        = offsetof(ssc_config_t, acceptContact),
+   [SSC_F_REQUIRE]               = offsetof(ssc_config_t, require),
+   [SSC_F_ROUTE]                 = offsetof(ssc_config_t, route),
+   [SSC_F_PRIORITY]              = offsetof(ssc_config_t, priority),
+   [SSC_F_TALKER_LOCATION]       = offsetof(ssc_config_t, talkerLocation),
+   [SSC_F_CUSTOMER_NAME]         = offsetof(ssc_config_t, customerName),
+   [SSC_F_CUSTOMER_ID]           = offsetof(ssc_config_t, customerId),
+   [SSC_F_DEPARTMENT_ID]         = offsetof(ssc_config_t, departmentId),
+   [SSC_F_CONTENT_TYPE]          = offsetof(ssc_config_t, contentTypeStr),
+   [SSC_F_CONTENT_LENGTH]        = offsetof(ssc_config_t, contentLength),
+};
+
+static int priv_profile_set(ssc_profile_t *profile, ssc_field_t field, const char *value);
+
+ssc_profile_t *ssc_profile_create(const ssc_config_t *config)
+{
+   if (!config)
+   {
+      SSCError("%s: NULL config ptr", __func__);
+      return NULL;
+   }
+
+   ssc_profile_t *profile = su_home_new(sizeof(*profile));
+   if (!profile)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(*profile));
+      return NULL;
+   }
+
+   int rv = SSC_REQ_SUCCESS;
+
+   unsigned f;
+   for (f=0; f<SSC_F_COUNT && rv == SSC_REQ_SUCCESS; ++f)
+   {
+      if (f == SSC_F_GROUP_NAME || f == SSC_F_PAID_DISPLAY || f == SSC_F_PAID_SIP_URI)
+      {
+         continue;
+      }
+
+      rv = priv_profile_set(profile, (ssc_field_t)f, (const char *)config + priv_config_offset[f]);
+   }
+
+   if (rv == SSC_REQ_SUCCESS) { rv = priv_profile_set(profile, SSC_F_GROUP_NAME, config->groupName); }
+   if (rv == SSC_REQ_SUCCESS) { rv = priv_profile_set(profile, SSC_F_PAID_DISPLAY, config->paidDisplay); }
+   if (rv == SSC_REQ_SUCCESS) { rv = priv_profile_set(profile, SSC_F_PAID_SIP_URI, config->paidSipUri); }
+
+   if (rv != SSC_REQ_SUCCESS)
+   {
+      SSCError("%s: failed to copy profile fields", __func__);
+      su_home_unref(profile->home);
+      return NULL;
+   }
+
+   profile->postProcessContactUri = config->postProcessContactUri;
+   profile->callType = config->callType;
+   profile->headerFormat = config->headerFormat;
+
+   return profile;
+}
+
+ssc_profile_t *ssc_profile_ref(ssc_profile_t *profile)
+{
+   if (profile)
+   {
+      su_home_ref(profile->home);
+   }
+
+   return profile;
+}
+
+void ssc_profile_unref(ssc_profile_t *profile)
+{
+   if (profile)
+   {
+      su_home_unref(profile->home);
+   }
+}
+
+const char *ssc_profile_get(const ssc_profile_t *profile, ssc_field_t field)
+{
+   if (!profile || (unsigned)field >= SSC_F_COUNT)
+   {
+      return NULL;
+   }
+
+   return profile->field[field];
+}
+
+unsigned short ssc_profile_post_process_contact_uri(const ssc_profile_t *profile)
+{
+   // same default as setSscDefaults()
+   return profile ? profile->postProcessContactUri : 1;
+}
+
+unsigned char ssc_profile_call_type(const ssc_profile_t *profile)
+{
+   return profile ? profile->callType : SIP_CALL_TYPE_NONE;
+}
+
+unsigned char ssc_profile_header_format(const ssc_profile_t *profile)
+{
+   return profile ? profile->headerFormat : SIP_HEADER_FORMAT_ESCHAT_CALL;
+}
+
+void ssc_req_init(ssc_req_t *req, const ssc_profile_t *profile)
+{
+   if (!req) { return; }
+
+   req->profile = profile;
+   req->count = 0;
+   req->callType = -1;
+   req->body.data = NULL;
+   req->body.len = 0;
+   req->payload = NULL;
+   req->contentType = NULL;
+   req->parts = NULL;
+   req->numParts = 0;
+   req->boundary = NULL;
+}
+
+int ssc_req_set(ssc_req_t *req, ssc_field_t field, const char *value)
+{
+   if (!req || (unsigned)field >= SSC_F_COUNT)
+   {
+      SSCError("%s: bad args", __func__);
+      return SSC_REQ_FAILURE;
+   }
+
+   unsigned i;
+   for (i=0; i<req->count; ++i)
+   {
+      if (req->ov[i].field == field)
+      {
+         req->ov[i].value = value;
+         return SSC_REQ_SUCCESS;
+      }
+   }
+
+   if (req->count >= SSC_REQ_MAX_FIELDS)
+   {
+      SSCError("%s: too many overrides (max: %u)", __func__, SSC_REQ_MAX_FIELDS);
+      return SSC_REQ_FAILURE;
+   }
+
+   req->ov[req->count].field = field;
+   req->ov[req->count].value = value;
+   ++req->count;
+
+   return SSC_REQ_SUCCESS;
+}
+
+void ssc_req_set_body(ssc_req_t *req, const char *data, size_t len)
+{
+   if (!req) { return; }
+
+   req->body.data = data;
+   req->body.len = data ? len : 0;
+}
+
+int ssc_req_has(const ssc_req_t *req, ssc_field_t field)
+{
+   if (!req) { return 0; }
+
+   unsigned i;
+   for (i=0; i<req->count; ++i)
+   {
+      if (req->ov[i].field == field)
+      {
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+const char *ssc_req_get(const ssc_req_t *req, ssc_field_t field)
+{
+   if (!req || (unsigned)field >= SSC_F_COUNT)
+   {
+      return NULL;
+   }
+
+   unsigned i;
+   for (i=0; i<req->count; ++i)
+   {
+      if (req->ov[i].field == field)
+      {
+         return req->ov[i].value;
+      }
+   }
+
+   return ssc_profile_get(req->profile, field);
+}
+
+
+/** internal functions follow **/
+
+int priv_profile_set(ssc_profile_t *profile, ssc_field_t field, const char *value)
+{
+   if (value && value[0] != '\0')
+   {
+      profile->field[field] = su_strdup(profile->home, value);
+      if (!profile->field[field])
+      {
+         return SSC_REQ_FAILURE;
+      }
+   }
+
+   return SSC_REQ_SUCCESS;
+}
@@ -0,0 +1,197 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// provides a layered alternative to passing a full ssc_config_t with every
+/// request.
+///
+/// a profile holds the fields that are constant for a trunk or peer (proxy,
+/// Allow, Accept, contact features, ...).  it is built once, lives on its
+/// own reference counted home and is never modified afterwards, so any
+/// number of requests (and threads) can share it.
+///
+/// a request (ssc_req_t) is a small struct, normally on the caller's stack,
+/// that points at a profile and carries only the fields that differ for
+/// this request (To, Call-ID, ...) plus the message body.  all strings and
+/// the body are borrowed; they only need to stay valid for the duration of
+/// the ssc_*_req() call that uses them.
+///
+/// field lookup order is: request override, then profile, then "not set".
+
+#include <stddef.h>
+
+#include <sofia-sip/sip.h>
+
+#include "ssc_types.h"
+#include "ssc_mime.h"
+
+/// some simple return codes
+#define SSC_REQ_SUCCESS   0
+#define SSC_REQ_FAILURE  -1
+
+/// max number of per-request field overrides
+#define SSC_REQ_MAX_FIELDS 12
+
+/// string fields that can be set in a profile or overridden per request.
+/// names match the ssc_config_t members they correspond to.
+typedef enum ssc_field_e
+{
+   SSC_F_TARGET_ADDRESS = 0,
+   SSC_F_REQUEST_URI,
+   SSC_F_TO_URI,
+   SSC_F_FROM_URI,
+   SSC_F_CALL_ID,
+   SSC_F_ACCEPT,
+   SSC_F_ALLOW,
+   SSC_F_VIA,
+   SSC_F_EXPIRES,
+   SSC_F_CONTACT_URI,
+   SSC_F_CONTACT_URI_FEATURES,
+   SSC_F_CONTACT_FEATURES,
+   SSC_F_ACCEPT_CONTACT,
+   SSC_F_REQUIRE,
+   SSC_F_ROUTE,
+   SSC_F_PRIORITY,
+   SSC_F_TALKER_LOCATION,
+   SSC_F_CUSTOMER_NAME,
+   SSC_F_CUSTOMER_ID,
+   SSC_F_DEPARTMENT_ID,
+   SSC_F_CONTENT_TYPE,
+   SSC_F_CONTENT_LENGTH,
+   SSC_F_GROUP_NAME,
+   SSC_F_PAID_DISPLAY,
+   SSC_F_PAID_SIP_URI,
+   SSC_F_COUNT
+} ssc_field_t;
+
+typedef struct ssc_profile_s ssc_profile_t;
+
+/// borrowed message body. @p data does not need to be NUL terminated.
+typedef struct ssc_body_s
+{
+   const char *data;
+   size_t len;
+} ssc_body_t;
+
+/// per-request settings layered on top of a profile.
+/// initialise with ssc_req_init() before use.
+typedef struct ssc_req_s
+{
+   const ssc_profile_t *profile;   // may be NULL
+
+   unsigned count;
+   struct
+   {
+      ssc_field_t field;
+      const char *value;
+   } ov[SSC_REQ_MAX_FIELDS];
+
+   // <0 -> use profile value
+   short callType;
+
+   // body; a pre-built payload object takes precedence over the
+   // borrowed data.
+   ssc_body_t body;
+   sip_payload_t *payload;
+   sip_content_type_t *contentType;
+
+   // multipart body, used when neither body nor payload is set.
+   // boundary may be NULL for a generated one.
+   const ssc_mime_part_t *parts;
+   unsigned numParts;
+   const char *boundary;
+} ssc_req_t;
+
+/// create a profile from the non-empty fields of a config struct.
+/// message body fields and sofia objects (payload, contentType) are not
+/// part of a profile and are ignored.
+///
+/// @param[in]  config   config to copy from
+///
+/// @return new profile holding one reference, or NULL on failure.
+ssc_profile_t *ssc_profile_create(const ssc_config_t *config);
+
+/// take an additional reference to a profile.
+///
+/// @param[in]  profile  profile to reference
+///
+/// @return @p profile
+ssc_profile_t *ssc_profile_ref(ssc_profile_t *profile);
+
+/// drop a reference to a profile. the profile is released with the last
+/// reference.
+///
+/// @param[in]  profile  profile to release (NULL is ignored)
+void ssc_profile_unref(ssc_profile_t *profile);
+
+/// returns the value of a profile field, or NULL if it is not set.
+///
+/// @param[in]  profile  profile to query
+/// @param[in]  field    field to read
+const char *ssc_profile_get(const ssc_profile_t *profile, ssc_field_t field);
+
+/// returns the profile's flags that have no string form.
+/// @return value as defined for the ssc_config_t member of the same name.
+unsigned short ssc_profile_post_process_contact_uri(const ssc_profile_t *profile);
+unsigned char ssc_profile_call_type(const ssc_profile_t *profile);
+unsigned char ssc_profile_header_format(const ssc_profile_t *profile);
+
+/// reset a request and bind it to a profile.
+///
+/// @param[in]  req      request to initialise
+/// @param[in]  profile  base profile (may be NULL). the request does not
+///                      take a reference; the caller must keep the profile
+///                      alive while the request is in use.
+void ssc_req_init(ssc_req_t *req, const ssc_profile_t *profile);
+
+/// override one field for this request.  the string is borrowed.
+/// setting a field twice replaces the earlier value; an empty string
+/// suppresses the profile value.
+///
+/// @param[in]  req      request to update
+/// @param[in]  field    field to override
+/// @param[in]  value    new value (borrowed)
+///
+/// @return SSC_REQ_SUCCESS, or SSC_REQ_FAILURE on bad args or if
+///         SSC_REQ_MAX_FIELDS are already set.
+int ssc_req_set(ssc_req_t *req, ssc_field_t field, const char *value);
+
+/// set the borrowed message body for this request.
+///
+/// @param[in]  req      request to update
+/// @param[in]  data     body data (borrowed, not necessarily terminated)
+/// @param[in]  len      body length in bytes
+void ssc_req_set_body(ssc_req_t *req, const char *data, size_t len);
+
+/// returns non-zero if the request overrides the indicated field.
+///
+/// @param[in]  req      request to query
+/// @param[in]  field    field to check
+int ssc_req_has(const ssc_req_t *req, ssc_field_t field);
+
+/// returns the effective value of a field: the request override if set,
+/// otherwise the profile value, otherwise NULL.
+///
+/// @param[in]  req      request to query
+/// @param[in]  field    field to read
+const char *ssc_req_get(const ssc_req_t *req, ssc_field_t field);
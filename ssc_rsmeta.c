@@ -0,0 +1,300 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_rsmeta.h"
+
+#include <string.h>
+
+#include "ssc_log.h"
+
+#define RSMETA_CONTENT_TYPE "application/rs-metadata+xml"
+
+static void priv_rsmeta_put(ssc_rsmeta_t *md, const char *str);
+static void priv_rsmeta_put_escaped(ssc_rsmeta_t *md, const char *str);
+static void priv_rsmeta_attr(ssc_rsmeta_t *md, const char *name, const char *value);
+
+int ssc_rsmeta_begin(ssc_rsmeta_t *md, ssc_mime_t *mime, ssc_rsmeta_mode_t mode,
+      const char *session_id, const char *sip_session_id)
+{
+   if (!md || !mime || !session_id)
+   {
+      SSCError("%s: NULL writer, mime or session id", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   md->mime = mime;
+   md->session_id = session_id;
+   md->open = 1;
+   md->failed = 0;
+
+   if (ssc_mime_part_begin(mime, RSMETA_CONTENT_TYPE) != MIME_SUCCESS)
+   {
+      md->failed = 1;
+      return RSMETA_FAILURE;
+   }
+
+   priv_rsmeta_put(md,
+         "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+         "<recording xmlns=\"urn:ietf:params:xml:ns:recording:1\">\r\n"
+         "<datamode>");
+   priv_rsmeta_put(md, mode == SSC_RSMETA_PARTIAL ? "partial" : "complete");
+   priv_rsmeta_put(md, "</datamode>\r\n<session");
+   priv_rsmeta_attr(md, "session_id", session_id);
+
+   if (sip_session_id && sip_session_id[0] != '\0')
+   {
+      priv_rsmeta_put(md, ">\r\n<sipSessionID>");
+      priv_rsmeta_put_escaped(md, sip_session_id);
+      priv_rsmeta_put(md, "</sipSessionID>\r\n</session>\r\n");
+   }
+   else
+   {
+      priv_rsmeta_put(md, "/>\r\n");
+   }
+
+   return md->failed ? RSMETA_FAILURE : RSMETA_SUCCESS;
+}
+
+int ssc_rsmeta_participant(ssc_rsmeta_t *md, const char *participant_id,
+      const char *aor, const char *name)
+{
+   if (!md || !md->open || !participant_id || !aor)
+   {
+      SSCError("%s: writer not open, or NULL participant id or aor", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   priv_rsmeta_put(md, "<participant");
+   priv_rsmeta_attr(md, "participant_id", participant_id);
+   priv_rsmeta_put(md, ">\r\n<nameID");
+   priv_rsmeta_attr(md, "aor", aor);
+
+   if (name && name[0] != '\0')
+   {
+      priv_rsmeta_put(md, ">\r\n<name>");
+      priv_rsmeta_put_escaped(md, name);
+      priv_rsmeta_put(md, "</name>\r\n</nameID>\r\n");
+   }
+   else
+   {
+      priv_rsmeta_put(md, "/>\r\n");
+   }
+
+   priv_rsmeta_put(md, "</participant>\r\n<participantsessionassoc");
+   priv_rsmeta_attr(md, "participant_id", participant_id);
+   priv_rsmeta_attr(md, "session_id", md->session_id);
+   priv_rsmeta_put(md, "/>\r\n");
+
+   return md->failed ? RSMETA_FAILURE : RSMETA_SUCCESS;
+}
+
+int ssc_rsmeta_stream(ssc_rsmeta_t *md, const char *stream_id,
+      const char *label, const char *sender_id)
+{
+   if (!md || !md->open || !stream_id || !label)
+   {
+      SSCError("%s: writer not open, or NULL stream id or label", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   priv_rsmeta_put(md, "<stream");
+   priv_rsmeta_attr(md, "stream_id", stream_id);
+   priv_rsmeta_attr(md, "session_id", md->session_id);
+   priv_rsmeta_put(md, ">\r\n<label>");
+   priv_rsmeta_put_escaped(md, label);
+   priv_rsmeta_put(md, "</label>\r\n</stream>\r\n");
+
+   if (sender_id && sender_id[0] != '\0')
+   {
+      priv_rsmeta_put(md, "<participantstreamassoc");
+      priv_rsmeta_attr(md, "participant_id", sender_id);
+      priv_rsmeta_put(md, ">\r\n<send>");
+      priv_rsmeta_put_escaped(md, stream_id);
+      priv_rsmeta_put(md, "</send>\r\n</participantstreamassoc>\r\n");
+   }
+
+   return md->failed ? RSMETA_FAILURE : RSMETA_SUCCESS;
+}
+
+int ssc_rsmeta_participant_leave(ssc_rsmeta_t *md, const char *participant_id, time_t when)
+{
+   char ts[sizeof("YYYY-MM-DDThh:mm:ssZ")];
+   struct tm tm;
+
+   if (!md || !md->open || !participant_id)
+   {
+      SSCError("%s: writer not open, or NULL participant id", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   if (when == 0)
+   {
+      when = time(NULL);
+   }
+   gmtime_r(&when, &tm);
+   strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+   priv_rsmeta_put(md, "<participantsessionassoc");
+   priv_rsmeta_attr(md, "participant_id", participant_id);
+   priv_rsmeta_attr(md, "session_id", md->session_id);
+   priv_rsmeta_put(md, ">\r\n<disassociate-time>");
+   priv_rsmeta_put(md, ts);
+   priv_rsmeta_put(md, "</disassociate-time>\r\n</participantsessionassoc>\r\n");
+
+   return md->failed ? RSMETA_FAILURE : RSMETA_SUCCESS;
+}
+
+int ssc_rsmeta_stream_assoc(ssc_rsmeta_t *md, const char *participant_id,
+      const char *const send_ids[], unsigned n)
+{
+   if (!md || !md->open || !participant_id || (n && !send_ids))
+   {
+      SSCError("%s: writer not open, or NULL participant id or stream ids", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   ssc_rsmeta_stream_assoc_begin(md, participant_id);
+
+   unsigned i;
+   for (i=0; i<n; ++i)
+   {
+      ssc_rsmeta_stream_assoc_send(md, send_ids[i]);
+   }
+
+   return ssc_rsmeta_stream_assoc_end(md);
+}
+
+int ssc_rsmeta_stream_assoc_begin(ssc_rsmeta_t *md, const char *participant_id)
+{
+   if (!md || !md->open || !participant_id)
+   {
+      SSCError("%s: writer not open, or NULL participant id", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   priv_rsmeta_put(md, "<participantstreamassoc");
+   priv_rsmeta_attr(md, "participant_id", participant_id);
+   priv_rsmeta_put(md, ">\r\n");
+
+   return md->failed ? RSMETA_FAILURE : RSMETA_SUCCESS;
+}
+
+int ssc_rsmeta_stream_assoc_send(ssc_rsmeta_t *md, const char *stream_id)
+{
+   if (!md || !md->open || !stream_id)
+   {
+      SSCError("%s: writer not open, or NULL stream id", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   priv_rsmeta_put(md, "<send>");
+   priv_rsmeta_put_escaped(md, stream_id);
+   priv_rsmeta_put(md, "</send>\r\n");
+
+   return md->failed ? RSMETA_FAILURE : RSMETA_SUCCESS;
+}
+
+int ssc_rsmeta_stream_assoc_end(ssc_rsmeta_t *md)
+{
+   if (!md || !md->open)
+   {
+      SSCError("%s: writer not open", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   priv_rsmeta_put(md, "</participantstreamassoc>\r\n");
+
+   return md->failed ? RSMETA_FAILURE : RSMETA_SUCCESS;
+}
+
+int ssc_rsmeta_end(ssc_rsmeta_t *md)
+{
+   if (!md || !md->open)
+   {
+      SSCError("%s: writer not open", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   priv_rsmeta_put(md, "</recording>\r\n");
+   md->open = 0;
+
+   if (md->failed)
+   {
+      SSCError("%s: metadata could not be written", __func__);
+      return RSMETA_FAILURE;
+   }
+
+   return RSMETA_SUCCESS;
+}
+
+
+/** internal functions follow **/
+
+void priv_rsmeta_put(ssc_rsmeta_t *md, const char *str)
+{
+   if (md->failed) { return; }
+
+   if (ssc_mime_write(md->mime, str, strlen(str)) != MIME_SUCCESS)
+   {
+      md->failed = 1;
+   }
+}
+
+void priv_rsmeta_put_escaped(ssc_rsmeta_t *md, const char *str)
+{
+   // write runs of plain characters in one go, entities in between
+   while (!md->failed && *str)
+   {
+      size_t run = strcspn(str, "&<>\"'");
+      if (run > 0 && ssc_mime_write(md->mime, str, run) != MIME_SUCCESS)
+      {
+         md->failed = 1;
+         return;
+      }
+
+      str += run;
+
+      const char *ent = NULL;
+      switch (*str)
+      {
+         case '&':  ent = "&amp;";  break;
+         case '<':  ent = "&lt;";   break;
+         case '>':  ent = "&gt;";   break;
+         case '"':  ent = "&quot;"; break;
+         case '\'': ent = "&apos;"; break;
+         default:   return;   // end of string
+      }
+
+      priv_rsmeta_put(md, ent);
+      ++str;
+   }
+}
+
+void priv_rsmeta_attr(ssc_rsmeta_t *md, const char *name, const char *value)
+{
+   priv_rsmeta_put(md, " ");
+   priv_rsmeta_put(md, name);
+   priv_rsmeta_put(md, "=\"");
+   priv_rsmeta_put_escaped(md, value);
+   priv_rsmeta_put(md, "\"");
+}
@@ -0,0 +1,143 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// streams SIPREC recording metadata (RFC 7865, application/rs-metadata+xml)
+/// straight into a multipart body built with the ssc_mime.h writer.
+///
+/// the document is produced element by element as the application walks
+/// its own participant and stream lists, so it never has to be rendered
+/// into an intermediate buffer first and is not limited in size.
+///
+/// typical use:
+///
+///    ssc_mime_init(&mime, home, &boundary, NULL, 0);
+///    ssc_mime_part(&mime, "application/sdp", sdp, sdpLen);
+///    ssc_rsmeta_begin(&md, &mime, SSC_RSMETA_COMPLETE, sessionId, callId);
+///    for each member:  ssc_rsmeta_participant(&md, partId, aor, name);
+///    for each stream:  ssc_rsmeta_stream(&md, streamId, label, senderId);
+///    ssc_rsmeta_end(&md);
+///    ssc_mime_finish(&mime, &payload);
+///
+/// attribute and text values are XML-escaped as they are written.
+
+#include <time.h>
+
+#include "ssc_mime.h"
+
+/// some simple return codes
+#define RSMETA_SUCCESS   0
+#define RSMETA_FAILURE  -1
+
+/// value of the <datamode> element
+typedef enum ssc_rsmeta_mode_e
+{
+   SSC_RSMETA_COMPLETE = 0,   // full snapshot of the recording session
+   SSC_RSMETA_PARTIAL         // update relative to earlier metadata
+} ssc_rsmeta_mode_t;
+
+/// metadata writer state; the fields are private to ssc_rsmeta.c.
+typedef struct ssc_rsmeta_s
+{
+   ssc_mime_t *mime;
+   const char *session_id;   // borrowed; must stay valid until ssc_rsmeta_end()
+   unsigned open : 1;
+   unsigned failed : 1;
+} ssc_rsmeta_t;
+
+/// begin the metadata part: writes the part delimiter and headers, the XML
+/// prolog, <datamode> and the <session> element.
+///
+/// @param[in]  md              writer to set up
+/// @param[in]  mime            multipart writer to stream into
+/// @param[in]  mode            complete or partial metadata
+/// @param[in]  session_id      recording session id (RFC 7865 session_id)
+/// @param[in]  sip_session_id  [optional] Session-ID of the recorded call
+///
+/// @return RSMETA_SUCCESS, or RSMETA_FAILURE on bad args or write failure.
+int ssc_rsmeta_begin(ssc_rsmeta_t *md, ssc_mime_t *mime, ssc_rsmeta_mode_t mode,
+      const char *session_id, const char *sip_session_id);
+
+/// add a <participant> plus its participant/session association.
+///
+/// @param[in]  md              writer to use
+/// @param[in]  participant_id  participant id
+/// @param[in]  aor             participant address of record
+/// @param[in]  name            [optional] display name
+///
+/// @return RSMETA_SUCCESS, or RSMETA_FAILURE on bad args or write failure.
+int ssc_rsmeta_participant(ssc_rsmeta_t *md, const char *participant_id,
+      const char *aor, const char *name);
+
+/// add a <stream> and, if @p sender_id is given, the association of the
+/// stream with the participant sending it.
+///
+/// @param[in]  md          writer to use
+/// @param[in]  stream_id   stream id
+/// @param[in]  label       SDP a=label of the stream's media line
+/// @param[in]  sender_id   [optional] participant id of the sender
+///
+/// @return RSMETA_SUCCESS, or RSMETA_FAILURE on bad args or write failure.
+int ssc_rsmeta_stream(ssc_rsmeta_t *md, const char *stream_id,
+      const char *label, const char *sender_id);
+
+/// record that a participant left the session (partial metadata): writes a
+/// participant/session association carrying a <disassociate-time>.
+///
+/// @param[in]  md              writer to use
+/// @param[in]  participant_id  participant id
+/// @param[in]  when            time the participant left (time(NULL) if 0)
+///
+/// @return RSMETA_SUCCESS, or RSMETA_FAILURE on bad args or write failure.
+int ssc_rsmeta_participant_leave(ssc_rsmeta_t *md, const char *participant_id, time_t when);
+
+/// write the full set of streams a participant currently sends.  in
+/// partial metadata this replaces the participant's earlier association,
+/// so an empty set disassociates all of its streams.
+///
+/// @param[in]  md              writer to use
+/// @param[in]  participant_id  participant id
+/// @param[in]  send_ids        stream ids sent by the participant
+/// @param[in]  n               number of entries in @p send_ids
+///
+/// @return RSMETA_SUCCESS, or RSMETA_FAILURE on bad args or write failure.
+int ssc_rsmeta_stream_assoc(ssc_rsmeta_t *md, const char *participant_id,
+      const char *const send_ids[], unsigned n);
+
+/// same as ssc_rsmeta_stream_assoc(), but streamed: open the association
+/// with ssc_rsmeta_stream_assoc_begin(), add each stream the participant
+/// sends with ssc_rsmeta_stream_assoc_send() and close it with
+/// ssc_rsmeta_stream_assoc_end().  nothing else may be written in between.
+///
+/// @return RSMETA_SUCCESS, or RSMETA_FAILURE on bad args or write failure.
+int ssc_rsmeta_stream_assoc_begin(ssc_rsmeta_t *md, const char *participant_id);
+int ssc_rsmeta_stream_assoc_send(ssc_rsmeta_t *md, const char *stream_id);
+int ssc_rsmeta_stream_assoc_end(ssc_rsmeta_t *md);
+
+/// close the document.  the multipart body still has to be finished with
+/// ssc_mime_finish().
+///
+/// @param[in]  md     writer to close
+///
+/// @return RSMETA_SUCCESS, or RSMETA_FAILURE if any write failed.
+int ssc_rsmeta_end(ssc_rsmeta_t *md);
@@ -59,6 +59,109 @@
 #include "ssc_sip.h"
 #include "ssc_oper.h"
 #include "ssc_oper_container.h"
+#include "ssc_oper_timer.h"
+#include "ssc_group.h"
+#include "ssc_profile.h"
+#include "ssc_template.h"
+#include "ssc_mime.h"
+#include "ssc_issi.h"
+#include "ssc_log_ctx.h"
+#include "ssc_loop_mon.h"
+#include "ssc_metrics.h"
+#include "ssc_probe.h"
+
+/* Resolved settings for one outgoing request or response, built either
+ * from a full ssc_config_t or from a profile plus per-request overrides.
+ * Strings are borrowed and never NULL ("" == not set), except groupName,
+ * paidDisplay and paidSipUri which keep the ssc_config_t meaning of
+ * NULL == not set.
+ */
+typedef struct priv_req_view_s {
+  const char   *targetAddress;
+  const char   *requestUri;
+  const char   *toUri;
+  const char   *fromUri;
+  const char   *callId;
+  const char   *accept;
+  const char   *allow;
+  const char   *via;
+  const char   *expires;
+  const char   *contactUri;
+  const char   *contactUriFeatures;
+  const char   *contactFeatures;
+  const char   *acceptContact;
+  const char   *require;
+  const char   *route;
+  const char   *priority;
+  const char   *talkerLocation;
+  const char   *customerName;
+  const char   *customerId;
+  const char   *departmentId;
+  const char   *contentTypeStr;
+  const char   *contentLength;
+  const char   *sdp;
+  const char   *payloadStr;
+
+  const char   *groupName;
+  const char   *paidDisplay;
+  const char   *paidSipUri;
+
+  unsigned short postProcessContactUri;
+  unsigned char callType;
+  unsigned char headerFormat;
+
+  sip_content_type_t *contentType;
+  sip_payload_t *payload;
+  sip_payload_t pl[1];          /**< Wraps a borrowed request body */
+
+  /* multipart body parts (config content parts or ssc_req_t parts) */
+  const ssc_mime_part_t *parts;
+  unsigned numParts;
+  const char *boundary;
+  ssc_mime_part_t partv[MAX_CONTENT_PARTS];
+
+  /* P25 ISSI multipart INVITE (config only) */
+  unsigned char p25InviteUseMultipart;
+  ssc_config_issi_t issi;
+
+  /* pre-parsed headers from a template; when set they are sent in
+   * place of the matching string field */
+  url_t const                *h_proxy;
+  sip_from_t const           *h_from;
+  sip_accept_t const         *h_accept;
+  sip_allow_t const          *h_allow;
+  sip_route_t const          *h_route;
+  sip_require_t const        *h_require;
+  sip_accept_contact_t const *h_accept_contact;
+  sip_contact_t const        *h_contact;
+  sip_priority_t const       *h_priority;
+  sip_expires_t const        *h_expires;
+} priv_req_view_t;
+
+/**
+ * Extra INVITE header lines derived from a request view. They depend only
+ * on fields shared by every leg of a group call, so ssc_invite_group()
+ * formats them once for all legs.
+ */
+typedef struct {
+  char contact[1024];
+  char eschat[1024];            /**< ESChat-Call / X-ESChat-Call */
+  char talkerLocation[1024];
+  char organization[1024];
+} priv_invite_hdrs_t;
+
+/**
+ * Multipart body built for one request from the view's parts. The
+ * stack buffer covers the config-sized parts; larger bodies spill to
+ * the SSC home.
+ */
+typedef struct {
+  ssc_mime_boundary_t boundary;
+  ssc_mime_t mime;
+  sip_payload_t pl[1];
+  sip_content_type_t *ct;
+  char buf[2048];
+} priv_multipart_t;
 
 /* Function prototypes
  * ------------------- */
@@ -192,6 +295,24 @@ static void priv_destroy_oper_with_disconnect (ssc_t * self,
 
 static void parseSipContacts (ssc_t *ssc, const sip_t *sip, uint8_t *numContacts, SscSipContact contacts[], uint8_t max);
 static void parseSipAccept (ssc_t *ssc, const sip_t *sip, uint8_t *numAccept, SscSipAccept accept[]);
+static void priv_latency_record (ssc_t *ssc, ssc_latency_t kind, uint64_t start, uint64_t end);
+static void priv_event_time_record (ssc_t *ssc, nua_event_t event, int status, uint64_t elapsed);
+
+static void priv_req_view_from_config (priv_req_view_t *v, const ssc_config_t *config);
+static void priv_req_view_from_req (priv_req_view_t *v, const ssc_req_t *req);
+static void priv_req_view_from_tmpl (priv_req_view_t *v, const ssc_template_t *tmpl, const ssc_req_t *req);
+static void priv_req_view_clear_hdrs (priv_req_view_t *v);
+static int priv_multipart_build (ssc_t *ssc, priv_req_view_t *v, priv_multipart_t *mp);
+static void priv_multipart_release (ssc_t *ssc, priv_multipart_t *mp);
+#ifdef _ISSI
+static int priv_issi_build (ssc_t *ssc, priv_req_view_t *v, priv_multipart_t *mp);
+#endif
+
+static void priv_invite_hdrs (const priv_req_view_t *v, priv_invite_hdrs_t *h);
+static ssc_oper_t *priv_invite (ssc_t *ssc, const priv_req_view_t *view, const priv_invite_hdrs_t *hdrs);
+static ssc_oper_t *priv_register_op (ssc_t *ssc, const priv_req_view_t *view, ssc_oper_t *op);
+static void priv_answer (ssc_oper_t *op, int status, char const *phrase, const priv_req_view_t *view);
+static void priv_bye (ssc_oper_t *op, const priv_req_view_t *v);
 
 /* Function definitions
  * -------------------- */
@@ -382,6 +503,22 @@ ssc_t * ssc_create (su_home_t * home, su_root_t * root, const ssc_conf_t * conf)
 
    ssc->cb_i_invite_extra = NULL;
 
+   ssc->ssc_op_packed = conf->ssc_op_packed;
+   ssc->ssc_fr_enabled = conf->ssc_flight_recorder;
+
+   /* step: warm up the op pool and container for the expected load */
+   {
+      unsigned expected = conf->ssc_expect_register + conf->ssc_expect_invite +
+                          conf->ssc_expect_options + conf->ssc_expect_other;
+      if (expected)
+      {
+         if (ssc_oc_reserve(ssc) != OC_SUCCESS)
+            SSCWarning("%s: failed to reserve op container", __func__);
+         if (ssc_oper_pool_reserve(ssc, expected) != 0)
+            SSCWarning("%s: failed to reserve %u ops", __func__, expected);
+      }
+   }
+
    /* step: find out the home domain of the account */
    if (conf->ssc_aor)
       userdomain = priv_parse_domain (home, conf->ssc_aor);
@@ -489,6 +626,13 @@ void ssc_destroy (ssc_t * self)
 
    home = self->ssc_home;
 
+   ssc_tw_stop(self);
+   ssc_lm_stop(self);
+   ssc_oper_pool_release(self);
+
+   if (self->ssc_ev_lat)
+      su_free (home, self->ssc_ev_lat);
+
    if (self->ssc_address)
       su_free (home, self->ssc_address);
 
@@ -603,15 +747,79 @@ static void priv_callback (nua_event_t event,
       nua_handle_t * nh, ssc_oper_t * op, sip_t const *sip,
       tagi_t tags[])
 {
+   // log at the level of the call being handled, tagged with its fields
+   int logSaved = ssc_log_ctx_enter(ssc, op && op->op_log_verbose);
+   ssc_log_kv_t logKv = {
+      op,
+      op ? op->op_method_name : NULL,
+      status,
+      (sip && sip->sip_call_id) ? sip->sip_call_id->i_id : NULL };
+   const ssc_log_kv_t *logKvSaved = sscLogKvPush(&logKv);
+
+   SSC_PROBE3(callback__entry, (int)event, status, op);
+   uint64_t dispatchStart = ssc_clock_ns();
+
    SSCDebugHigh("SSC priv_callback: EVENT: %s [%d]", nua_event_name(event), event);
 	SSCDebugHigh("op <%p> -> userData <%p>", op, (op!=NULL?op->userData:NULL));
 
    if (!ssc)
    {
       SSCError("NULL SSC context ptr!");
+      SSC_PROBE3(callback__return, (int)event, status, op);
+      sscLogKvPop(logKvSaved);
+      ssc_log_ctx_leave(logSaved);
       return;
    }
 
+   // any event counts as activity; push out the idle deadline
+   ssc_tw_touch(ssc, op);
+
+   if (op)
+   {
+      int state_before = op->op_prev_state;
+      int state_after = state_before;
+
+      if (event == nua_i_state)
+      {
+         tl_gets(tags, NUTAG_CALLSTATE_REF(state_after), TAG_END());
+      }
+
+      ssc_oper_fr_record(op, event, status, state_before, state_after);
+
+      // dump before dispatch; the handlers may destroy the operation
+      if (op->op_fr && !op->op_fr_dumped)
+      {
+         if (status >= 300)
+         {
+            op->op_fr_dumped = 1;
+            ssc_oper_fr_dump(op, "failure status");
+         }
+         else if (state_after == nua_callstate_terminated &&
+                  state_before != nua_callstate_terminated &&
+                  op->op_times.t_ready == 0)
+         {
+            op->op_fr_dumped = 1;
+            ssc_oper_fr_dump(op, "terminated before ACK");
+         }
+      }
+   }
+
+   ssc_metrics_event(event);
+
+   // state events carry the message already reported by its own event
+   if (sip && event != nua_i_state && event != nua_i_active && event != nua_i_terminated)
+   {
+      if (sip->sip_request)
+      {
+         ssc_metrics_request(SSC_METRICS_RX, sip->sip_request->rq_method);
+      }
+      else if (sip->sip_status && sip->sip_cseq)
+      {
+         ssc_metrics_response(SSC_METRICS_RX, (sip_method_t)sip->sip_cseq->cs_method,
+               sip->sip_status->st_status);
+      }
+   }
+
    switch (event)
    {
       case nua_r_shutdown:
@@ -754,6 +962,13 @@ static void priv_callback (nua_event_t event,
 
    if (ssc->ssc_event_cb)
       ssc->ssc_event_cb (ssc, (int) event, ssc->userData);
+
+   priv_event_time_record(ssc, event, status, ssc_clock_ns() - dispatchStart);
+
+   SSC_PROBE3(callback__return, (int)event, status, op);
+
+   sscLogKvPop(logKvSaved);
+   ssc_log_ctx_leave(logSaved);
 }
 
 /* ====================================================================== */
@@ -796,12 +1011,9 @@ void ssc_list (ssc_t * ssc)
    SSCDebugHigh ("%s: listing active handles", ssc?ssc->ssc_name:"");
    for (op = ssc->ssc_operations; op; op = op->op_next)
    {
-      if (op->op_ident)
-      {
-         SSCDebugHigh ("\t%s to %s",
-               sip_method_name (op->op_method, op->op_method_name),
-               op->op_ident);
-      }
+      SSCDebugHigh ("\t%s to %s",
+            sip_method_name (op->op_method, op->op_method_name),
+            ssc_oper_ident (op));
    }
 }
 
@@ -818,9 +1030,13 @@ int ssc_create_siprec_mime(
       sip_payload_t **payloadOut,
       sip_content_type_t **contentTypeOut)
 {
-   msg_header_t *header = NULL;
-   char *ptr;
-   size_t len, offset;
+   ssc_mime_boundary_t boundary;
+   ssc_mime_t mime;
+
+   if (!sdp || !metadata)
+   {
+      return -2;
+   }
 
    // Create the msg.
    msg_t *msg = msg_create(sip_default_mclass(), 0);
@@ -832,66 +1048,27 @@ int ssc_create_siprec_mime(
    // Use the msg home.
    su_home_t *home = msg_home(msg);
 
+   ssc_mime_boundary_init(&boundary, NULL);
 
-   // The contentType header.
-   sip_content_type_t *contentType = NULL;
-   contentType = sip_content_type_make(home, "multipart/mixed");
-
-   // The sub parts.
-   msg_multipart_t *multipart = NULL;
-   msg_multipart_t *multipart2 = NULL;
-   multipart = msg_multipart_create(
-         home, "application/sdp", sdp, strlen(sdp));
-   multipart2 = msg_multipart_create(
-         home, 
-         "application/rs-metadata+xml", 
-         metadata, strlen(metadata));
+   // The contentType header, with the boundary parameter.
+   sip_content_type_t *contentType = ssc_mime_content_type(home, &boundary);
+   sip_payload_t *pl = (sip_payload_t *)su_zalloc(home, sizeof(sip_payload_t));
 
    // check memory allocs
-   if (!contentType || !multipart || !multipart2)
+   if (!contentType || !pl)
    {
       msg_destroy(msg);
       return -2;
    }
 
-   multipart->mp_next = multipart2;
-
-   // Add delimiters to multipart, and boundary parameter to content-type
-   if (msg_multipart_complete(home, contentType, multipart) < 0)
-   {
-      msg_destroy(msg);
-      return -3;         // Error
-   }
-
-   // Combine multipart components into the chain
-   header = NULL;
-   if (msg_multipart_serialize(&header, multipart) < 0)
-   {
-      msg_destroy(msg);
-      return -4;         // Error
-   }
-
-   // Encode all multipart components
-   len = msg_multipart_prepare(msg, multipart, 0);
-   if (len < 0)
+   // Write both parts straight into one buffer sized up front
+   ssc_mime_init(&mime, home, &boundary, NULL, 0);
+   if (ssc_mime_siprec(&mime, sdp, strlen(sdp), metadata, strlen(metadata), pl) != MIME_SUCCESS)
    {
       msg_destroy(msg);
       return -5;         // Error
    }
 
-   sip_payload_t *pl = sip_payload_create(home, NULL, len);
-
-   // Copy each element from multipart to pl_data
-   if (pl && pl->pl_data)
-   {
-      ptr = pl->pl_data;
-      for (offset = 0, header = (msg_header_t *)multipart; offset < len; header = header->sh_succ) 
-      {
-         memcpy(ptr + offset, header->sh_data, header->sh_len);
-         offset += header->sh_len;
-      }
-   }
-
    // The msg is the memory home...  msg_destroy(msg) to free it all.
    *mimeMsgOut = msg;
    *payloadOut = pl;
@@ -900,6 +1077,204 @@ int ssc_create_siprec_mime(
    return 0;
 }
 
+/**
+ * Fills a request view from a full config struct. No copies are made.
+ */
+static void priv_req_view_from_config (priv_req_view_t *v, const ssc_config_t *config)
+{
+   unsigned i;
+
+   v->targetAddress = config->targetAddress;
+   v->requestUri = config->requestUri;
+   v->toUri = config->toUri;
+   v->fromUri = config->fromUri;
+   v->callId = config->callId;
+   v->accept = config->accept;
+   v->allow = config->allow;
+   v->via = config->via;
+   v->expires = config->expires;
+   v->contactUri = config->contactUri;
+   v->contactUriFeatures = config->contactUriFeatures;
+   v->contactFeatures = config->contactFeatures;
+   v->acceptContact = config->acceptContact;
+   v->require = config->require;
+   v->route = config->route;
+   v->priority = config->priority;
+   v->talkerLocation = config->talkerLocation;
+   v->customerName = config->customerName;
+   v->customerId = config->customerId;
+   v->departmentId = config->departmentId;
+   v->contentTypeStr = config->contentTypeStr;
+   v->contentLength = config->contentLength;
+   v->sdp = config->sdp;
+   v->payloadStr = config->payloadStr;
+
+   v->groupName = config->groupName;
+   v->paidDisplay = config->paidDisplay;
+   v->paidSipUri = config->paidSipUri;
+
+   v->postProcessContactUri = config->postProcessContactUri;
+   v->callType = config->callType;
+   v->headerFormat = config->headerFormat;
+
+   v->contentType = config->contentType;
+   v->payload = config->payload;
+
+   v->numParts = config->numContentParts;
+   if (v->numParts > MAX_CONTENT_PARTS)
+   {
+      v->numParts = MAX_CONTENT_PARTS;
+   }
+   for (i=0; i<v->numParts; ++i)
+   {
+      v->partv[i].headers = config->headerParts[i];
+      v->partv[i].headers_len = strnlen(config->headerParts[i], MAX_HEADER_AREA_SIZE);
+      v->partv[i].body = config->contentParts[i];
+      v->partv[i].body_len = strnlen(config->contentParts[i], MAX_CONTENT_AREA_SIZE);
+   }
+   v->parts = v->partv;
+   v->boundary = config->contentBoundary;
+
+   v->p25InviteUseMultipart = config->p25InviteUseMultipart;
+   v->issi = config->issi;
+
+   priv_req_view_clear_hdrs(v);
+}
+
+/* effective request value, "" if not set anywhere */
+static const char *priv_req_str (const ssc_req_t *req, ssc_field_t field)
+{
+   const char *s = ssc_req_get(req, field);
+   return s ? s : "";
+}
+
+/* effective request value, NULL if not set anywhere */
+static const char *priv_req_ptr (const ssc_req_t *req, ssc_field_t field)
+{
+   const char *s = ssc_req_get(req, field);
+   return (s && s[0] != '\0') ? s : NULL;
+}
+
+/**
+ * Fills a request view from a profile and its per-request overrides.
+ * No copies are made; the body is wrapped, not duplicated.
+ */
+static void priv_req_view_from_req (priv_req_view_t *v, const ssc_req_t *req)
+{
+   v->targetAddress = priv_req_str(req, SSC_F_TARGET_ADDRESS);
+   v->requestUri = priv_req_str(req, SSC_F_REQUEST_URI);
+   v->toUri = priv_req_str(req, SSC_F_TO_URI);
+   v->fromUri = priv_req_str(req, SSC_F_FROM_URI);
+   v->callId = priv_req_str(req, SSC_F_CALL_ID);
+   v->accept = priv_req_str(req, SSC_F_ACCEPT);
+   v->allow = priv_req_str(req, SSC_F_ALLOW);
+   v->via = priv_req_str(req, SSC_F_VIA);
+   v->expires = priv_req_str(req, SSC_F_EXPIRES);
+   v->contactUri = priv_req_str(req, SSC_F_CONTACT_URI);
+   v->contactUriFeatures = priv_req_str(req, SSC_F_CONTACT_URI_FEATURES);
+   v->contactFeatures = priv_req_str(req, SSC_F_CONTACT_FEATURES);
+   v->acceptContact = priv_req_str(req, SSC_F_ACCEPT_CONTACT);
+   v->require = priv_req_str(req, SSC_F_REQUIRE);
+   v->route = priv_req_str(req, SSC_F_ROUTE);
+   v->priority = priv_req_str(req, SSC_F_PRIORITY);
+   v->talkerLocation = priv_req_str(req, SSC_F_TALKER_LOCATION);
+   v->customerName = priv_req_str(req, SSC_F_CUSTOMER_NAME);
+   v->customerId = priv_req_str(req, SSC_F_CUSTOMER_ID);
+   v->departmentId = priv_req_str(req, SSC_F_DEPARTMENT_ID);
+   v->contentTypeStr = priv_req_str(req, SSC_F_CONTENT_TYPE);
+   v->contentLength = priv_req_str(req, SSC_F_CONTENT_LENGTH);
+   v->sdp = "";
+   v->payloadStr = "";
+
+   v->groupName = priv_req_ptr(req, SSC_F_GROUP_NAME);
+   v->paidDisplay = priv_req_ptr(req, SSC_F_PAID_DISPLAY);
+   v->paidSipUri = priv_req_ptr(req, SSC_F_PAID_SIP_URI);
+
+   v->postProcessContactUri = ssc_profile_post_process_contact_uri(req->profile);
+   v->callType = req->callType >= 0 ?
+      (unsigned char)req->callType : ssc_profile_call_type(req->profile);
+   v->headerFormat = ssc_profile_header_format(req->profile);
+
+   v->contentType = req->contentType;
+   v->payload = req->payload;
+
+   if (!v->payload && req->body.data)
+   {
+      memset(v->pl, 0, sizeof(v->pl));
+      sip_payload_init(v->pl);
+      v->pl->pl_data = (char *)req->body.data;
+      v->pl->pl_len = req->body.len;
+      v->payload = v->pl;
+   }
+
+   v->parts = req->parts;
+   v->numParts = req->parts ? req->numParts : 0;
+   v->boundary = req->boundary;
+
+   v->p25InviteUseMultipart = 0;
+
+   priv_req_view_clear_hdrs(v);
+}
+
+static void priv_req_view_clear_hdrs (priv_req_view_t *v)
+{
+   v->h_proxy = NULL;
+   v->h_from = NULL;
+   v->h_accept = NULL;
+   v->h_allow = NULL;
+   v->h_route = NULL;
+   v->h_require = NULL;
+   v->h_accept_contact = NULL;
+   v->h_contact = NULL;
+   v->h_priority = NULL;
+   v->h_expires = NULL;
+}
+
+/* use the template's parsed header unless the request overrides the field */
+#define PRIV_TMPL_HDR(v, tmpl, req, member, field) \
+   if ((tmpl)->member && !ssc_req_has(req, field)) \
+   { \
+      (v)->h_##member = (tmpl)->member; \
+   }
+
+/**
+ * Fills a request view from a template plus per-request deltas. The
+ * string fields are resolved as for a plain request; the template's
+ * parsed headers then take over for every field not overridden.
+ */
+static void priv_req_view_from_tmpl (priv_req_view_t *v, const ssc_template_t *tmpl, const ssc_req_t *req)
+{
+   ssc_req_t r = *req;
+
+   if (!r.profile)
+      r.profile = tmpl->profile;
+
+   priv_req_view_from_req(v, &r);
+
+   PRIV_TMPL_HDR(v, tmpl, req, proxy, SSC_F_TARGET_ADDRESS);
+   PRIV_TMPL_HDR(v, tmpl, req, from, SSC_F_FROM_URI);
+   PRIV_TMPL_HDR(v, tmpl, req, accept, SSC_F_ACCEPT);
+   PRIV_TMPL_HDR(v, tmpl, req, allow, SSC_F_ALLOW);
+   PRIV_TMPL_HDR(v, tmpl, req, route, SSC_F_ROUTE);
+   PRIV_TMPL_HDR(v, tmpl, req, require, SSC_F_REQUIRE);
+   PRIV_TMPL_HDR(v, tmpl, req, accept_contact, SSC_F_ACCEPT_CONTACT);
+   PRIV_TMPL_HDR(v, tmpl, req, priority, SSC_F_PRIORITY);
+   PRIV_TMPL_HDR(v, tmpl, req, expires, SSC_F_EXPIRES);
+
+   if (tmpl->contact &&
+       !ssc_req_has(req, SSC_F_CONTACT_URI) &&
+       !ssc_req_has(req, SSC_F_CONTACT_URI_FEATURES) &&
+       !ssc_req_has(req, SSC_F_CONTACT_FEATURES))
+   {
+      v->h_contact = tmpl->contact;
+   }
+
+   if (tmpl->content_type && !v->contentType && !ssc_req_has(req, SSC_F_CONTENT_TYPE))
+   {
+      v->contentType = tmpl->content_type;
+   }
+}
+
 /**
  * Sends an outgoing OPTIONS request.
  *
@@ -952,6 +1327,9 @@ SSCDebugLow("callId - '%s'", config->callId);
 SSCDebugLow("accept - '%s'", config->accept);
 SSCDebugLow("allow - '%s'", config->allow);
 
+      op->op_times.t_req_sent = ssc_clock_us();
+
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_options);
       nua_options (op->op_handle,
                    TAG_IF((config->targetAddress[0] != '\0'), NUTAG_PROXY(config->targetAddress)),
                    TAG_IF((config->via[0] != '\0'), SIPTAG_VIA_STR(config->via)),
@@ -963,19 +1341,199 @@ SSCDebugLow("allow - '%s'", config->allow);
                    TAG_END());
 
       //op->op_callstate |= opc_sent;
-      SSCDebugHigh ("%s: OPTIONS to %s", ssc->ssc_name, op->op_ident);
+      SSCDebugHigh ("%s: OPTIONS to %s", ssc->ssc_name, ssc_oper_ident(op));
    }
    return op;
 }
 
+/**
+ * Builds the view's multipart parts into one body and points the view's
+ * payload at it. Returns 1 if a body was built. An explicit payload,
+ * payload string or body always wins over the parts.
+ */
+int priv_multipart_build (ssc_t *ssc, priv_req_view_t *v, priv_multipart_t *mp)
+{
+   mp->ct = NULL;
+   mp->mime.buf = NULL;
+   mp->mime.owned = 0;
+
+   if (v->numParts == 0 || v->payload || v->payloadStr[0] != '\0')
+   {
+      return 0;
+   }
+
+   ssc_mime_boundary_init(&mp->boundary,
+         (v->boundary && v->boundary[0] != '\0') ? v->boundary : NULL);
+
+   ssc_mime_init(&mp->mime, ssc->ssc_home, &mp->boundary, mp->buf, sizeof(mp->buf));
+
+   // an SDP set alongside the parts goes out as the first part
+   if (v->sdp[0] != '\0' &&
+       ssc_mime_part(&mp->mime, "application/sdp", v->sdp, strlen(v->sdp)) != MIME_SUCCESS)
+   {
+      SSCError("%s: failed to add SDP part", __func__);
+      priv_multipart_release(ssc, mp);
+      return 0;
+   }
+
+   if (ssc_mime_build(&mp->mime, v->parts, v->numParts, mp->pl) != MIME_SUCCESS)
+   {
+      SSCError("%s: failed to build %u part body", __func__, v->numParts);
+      priv_multipart_release(ssc, mp);
+      return 0;
+   }
+
+   // an explicit Content-Type is assumed to carry the boundary already
+   if (!v->contentType && v->contentTypeStr[0] == '\0')
+   {
+      mp->ct = ssc_mime_content_type(ssc->ssc_home, &mp->boundary);
+      v->contentType = mp->ct;
+   }
+
+   v->payload = mp->pl;
+   v->sdp = "";
+
+   return 1;
+}
+
+#ifdef _ISSI
+/**
+ * Builds the P25 ISSI multipart INVITE body (SDP + ISSI parameters)
+ * from the cached parts. Returns 1 if a body was built. An explicit
+ * payload or payload string always wins.
+ */
+int priv_issi_build (ssc_t *ssc, priv_req_view_t *v, priv_multipart_t *mp)
+{
+   sip_content_type_t *ct = NULL;
+
+   if (!v->p25InviteUseMultipart || v->payload ||
+       v->payloadStr[0] != '\0' || v->sdp[0] == '\0')
+   {
+      return 0;
+   }
+
+   ssc_mime_init(&mp->mime, ssc->ssc_home, NULL, mp->buf, sizeof(mp->buf));
+   if (ssc_issi_invite_body(ssc, &v->issi, v->sdp, strlen(v->sdp),
+                            &mp->mime, mp->pl, &ct) != ISSI_SUCCESS)
+   {
+      SSCError("%s: failed to build ISSI body", __func__);
+      priv_multipart_release(ssc, mp);
+      return 0;
+   }
+
+   // the content type is cached on the SSC; mp->ct stays NULL
+   v->contentType = ct;
+   v->payload = mp->pl;
+   v->sdp = "";
+
+   return 1;
+}
+#endif
+
+void priv_multipart_release (ssc_t *ssc, priv_multipart_t *mp)
+{
+   if (mp->mime.owned)
+   {
+      su_free(ssc->ssc_home, mp->mime.buf);
+   }
+   mp->mime.buf = NULL;
+   mp->mime.owned = 0;
+
+   su_free(ssc->ssc_home, mp->ct);
+   mp->ct = NULL;
+}
+
+/**
+ * Formats the Contact and ESChat header lines of an INVITE.
+ */
+void priv_invite_hdrs (const priv_req_view_t *v, priv_invite_hdrs_t *h)
+{
+   const char *eschatCallHeaderName = NULL;
+
+   h->contact[0] = '\0';
+   h->eschat[0] = '\0';
+   h->talkerLocation[0] = '\0';
+   h->organization[0] = '\0';
+
+   if (v->postProcessContactUri == 0)
+   {
+      snprintf(h->contact, sizeof(h->contact), "%s", v->contactUri);
+   }
+   else
+   {
+      if (v->contactUri[0] != '\0')
+      {
+         snprintf(h->contact, sizeof(h->contact), "<%s%s>%s", v->contactUri, v->contactUriFeatures, v->contactFeatures);
+      }
+   }
+
+   switch (v->headerFormat) {
+   case SIP_HEADER_FORMAT_NONE:
+      // No header
+      break;
+   case SIP_HEADER_FORMAT_ESCHAT_CALL:
+      eschatCallHeaderName = "ESChat-Call";
+      break;
+   case SIP_HEADER_FORMAT_X_ESCHAT_CALL:
+      eschatCallHeaderName = "X-ESChat-Call";
+      break;
+   }
+
+   if (eschatCallHeaderName != NULL)
+   {
+      if (v->callType == SIP_CALL_TYPE_ADHOC)
+      {
+         snprintf(
+               h->eschat,
+               sizeof(h->eschat),
+               "%s: Adhoc;;%s",
+               eschatCallHeaderName,
+               v->callId);
+      }
+      else if (v->callType == SIP_CALL_TYPE_GROUP)
+      {
+         snprintf(
+               h->eschat,
+               sizeof(h->eschat),
+               "%s: Group;%s;%s",
+               eschatCallHeaderName,
+               v->groupName,
+               v->callId);
+      }
+   }
+
+   if (v->talkerLocation[0] != '\0' &&
+       v->headerFormat != SIP_HEADER_FORMAT_NONE)
+   {
+      snprintf(h->talkerLocation,
+               sizeof(h->talkerLocation),
+               "X-ESChat-Talker-Location: %s",
+               v->talkerLocation);
+   }
+
+   if (v->customerName[0] != '\0' &&
+       v->headerFormat != SIP_HEADER_FORMAT_NONE)
+   {
+      snprintf(h->organization,
+               sizeof(h->organization),
+               "X-ESChat-Organization: %s;%s;%s",
+               v->customerName,
+               v->customerId,
+               v->departmentId);
+   }
+}
+
 /**
  * Sends an outgoing INVITE request.
  *
  * @param ssc context pointer
  * @param destination SIP URI
  */
-ssc_oper_t *ssc_invite (ssc_t * ssc, ssc_config_t *config)
+ssc_oper_t *priv_invite (ssc_t * ssc, const priv_req_view_t *view, const priv_invite_hdrs_t *hdrs)
 {
+   priv_req_view_t v[1];
+   priv_multipart_t mp[1];
+   char *paidUri = NULL;
    ssc_oper_t *op;
 
 char *branchStr, branchBuf[1024];
@@ -991,153 +1549,112 @@ SSCDebugLow("SSC Invite");
       return NULL;
    }
 
-   if (!config)
+   if (!view)
    {
       SSCError("null SSC config ptr");
       return NULL;
    }
 
-   if (config->paidDisplay && config->paidSipUri)
+   // local copy; the guards below adjust it for this request only
+   *v = *view;
+   if (v->payload == view->pl)
    {
+      v->payload = v->pl;
+   }
 
-      paid.paid_next = NULL;
-      paid.paid_display = config->paidDisplay;
-      url_d(paid.paid_url, config->paidSipUri);
+   // pick the call for verbose logging before building the request
+   int logVerbose = ssc_log_ctx_match_req(ssc, v->groupName, v->fromUri, v->callId,
+         (v->requestUri[0] != '\0') ? v->requestUri : v->toUri);
+   int logSaved = ssc_log_ctx_enter(ssc, logVerbose);
+   ssc_log_kv_t logKv = { NULL, "INVITE", 0, v->callId };
+   const ssc_log_kv_t *logKvSaved = sscLogKvPush(&logKv);
 
-      paidValid = 1;
+   if (!priv_multipart_build(ssc, v, mp))
+   {
+#ifdef _ISSI
+      priv_issi_build(ssc, v, mp);
+#endif
+   }
+
+   if (v->paidDisplay && v->paidSipUri)
+   {
+      // url_d() decodes in place, so work on a private copy
+      paidUri = su_strdup(ssc->ssc_home, v->paidSipUri);
+      if (paidUri)
+      {
+         paid.paid_next = NULL;
+         paid.paid_display = v->paidDisplay;
+         url_d(paid.paid_url, paidUri);
+
+         paidValid = 1;
+      }
    }
 
    SSCDebugLow("op create");
-   const char *reqAddr = config->requestUri;
+   const char *reqAddr = v->requestUri;
    if (!reqAddr)
    {
-      reqAddr = config->toUri;
+      reqAddr = v->toUri;
    }
 
    op = priv_oper_create(
          ssc,
          SIP_METHOD_INVITE,
          reqAddr,
-         config->toUri, config->fromUri,
+         v->toUri, v->fromUri,
          TAG_IF(paidValid, SIPTAG_P_ASSERTED_IDENTITY(&paid)),
          TAG_IF(paidValid, SIPTAG_PRIVACY_STR("id")),
          TAG_END());
 
+   su_free(ssc->ssc_home, paidUri);
+
    if (op)
    {
 		sip_request_t *sipreq = NULL;
 
       op->op_callstate &= !opc_pending;
+      op->op_log_verbose = logVerbose != 0;
+      logKv.op = op;
 
-      if (config->sdp || config->payload)
+      if (v->sdp || v->payload)
       {
-         char contactBuffer[1024];
-         char eschatSipHeader[1024];
-         char eschatTalkerLocationHeader[1024];
-         char eschatOrganizationHeader[1024];
-
-         contactBuffer[0] = '\0';
-         eschatSipHeader[0] = '\0';
-         eschatTalkerLocationHeader[0] = '\0';
-         eschatOrganizationHeader[0] = '\0';
-
-         if (config->postProcessContactUri == 0)
-         {
-            strcat(contactBuffer, config->contactUri);
-			}
-			else
-			{
-				if (config->contactUri[0] != '\0')
-				{
-					snprintf(contactBuffer, 1024, "<%s%s>%s", config->contactUri, config->contactUriFeatures, config->contactFeatures);
-				}
-			}
-
-         const char *eschatCallHeaderName = NULL;
-
-         switch (config->headerFormat) {
-         case SIP_HEADER_FORMAT_NONE:
-            // No header
-            break;
-         case SIP_HEADER_FORMAT_ESCHAT_CALL:
-            eschatCallHeaderName = "ESChat-Call";
-            break;
-         case SIP_HEADER_FORMAT_X_ESCHAT_CALL:
-            eschatCallHeaderName = "X-ESChat-Call";
-            break;
-         }
-
-         if (eschatCallHeaderName != NULL)
-         {
-            if (config->callType == SIP_CALL_TYPE_ADHOC)
-            {
-               snprintf(
-                     eschatSipHeader,
-                     sizeof(eschatSipHeader),
-                     "%s: Adhoc;;%s",
-                     eschatCallHeaderName,
-                     config->callId);
-            }
-            else if (config->callType == SIP_CALL_TYPE_GROUP)
-            {
-               snprintf(
-                     eschatSipHeader,
-                     sizeof(eschatSipHeader),
-                     "%s: Group;%s;%s",
-                     eschatCallHeaderName,
-                     config->groupName,
-                     config->callId);
-            }
-         }
-
-         if (config->talkerLocation[0] != '\0' &&
-             config->headerFormat != SIP_HEADER_FORMAT_NONE)
-         {
-            snprintf(eschatTalkerLocationHeader,
-                     sizeof(eschatTalkerLocationHeader),
-                     "X-ESChat-Talker-Location: %s",
-                     config->talkerLocation);
-         }
+         priv_invite_hdrs_t local[1];
+         const priv_invite_hdrs_t *h = hdrs;
 
-         if (config->customerName[0] != '\0' &&
-             config->headerFormat != SIP_HEADER_FORMAT_NONE)
+         if (!h)
          {
-            snprintf(eschatOrganizationHeader,
-                     sizeof(eschatOrganizationHeader),
-                     "X-ESChat-Organization: %s;%s;%s",
-                     config->customerName,
-                     config->customerId,
-                     config->departmentId);
+            priv_invite_hdrs(v, local);
+            h = local;
          }
 
-         if (config->payload)
+         if (v->payload)
 			{
-            SSCDebugHigh ("%s: about to make a call with local payload:\n%s",
-                  ssc->ssc_name, config->payload->pl_data);
+            SSCDebugHigh ("%s: about to make a call with local payload:\n%.*s",
+                  ssc->ssc_name, (int)v->payload->pl_len, v->payload->pl_data);
 				// guard: make sure SDP is not also included
-				config->sdp[0] = '\0';
+				v->sdp = "";
 			}
-         else if (config->sdp[0] != '\0')
+         else if (v->sdp[0] != '\0')
          {
             SSCDebugHigh ("%s: about to make a call with local SDP:\n%s",
-                  ssc->ssc_name, config->sdp);
+                  ssc->ssc_name, v->sdp);
          }
 
-			if (strlen(config->requestUri) > 0)
+			if (strlen(v->requestUri) > 0)
 			{
-				sipreq = sip_request_create(ssc->ssc_home, SIP_METHOD_INVITE, (const url_string_t *)config->requestUri, NULL);
+				sipreq = sip_request_create(ssc->ssc_home, SIP_METHOD_INVITE, (const url_string_t *)v->requestUri, NULL);
 			}
 
-			if (config->contentType)
+			if (v->contentType)
 			{
-				config->contentTypeStr[0] = '\0';
+				v->contentTypeStr = "";
 			}
 
 branchBuf[0] = '\0';
 branchStr = NULL;
-if (config->via)
+if (v->via)
 {
-	strcpy(branchBuf, config->via);
+	snprintf(branchBuf, sizeof(branchBuf), "%s", v->via);
 	branchStr = strstr(branchBuf, "branch=");
 	if (branchStr)
 	{
@@ -1146,62 +1663,76 @@ if (config->via)
 }
 
 SSCDebugLow("nua_invite tags:");
-SSCDebugLow("requestUri - '%s'", config->requestUri);
-SSCDebugLow("targetAddress - '%s'", config->targetAddress);
-SSCDebugLow("via - '%s'", config->via);
-SSCDebugLow("to - '%s'", config->toUri);
-SSCDebugLow("from - '%s'", config->fromUri);
-SSCDebugLow("callId - '%s'", config->callId);
-SSCDebugLow("accept - '%s'", config->accept);
-SSCDebugLow("allow - '%s'", config->allow);
-SSCDebugLow("eschat - '%s'", eschatSipHeader);
-SSCDebugLow("contact - '%s'", contactBuffer);
-SSCDebugLow("priority - '%s'", config->priority);
-SSCDebugLow("talkerLocation - '%s'", config->talkerLocation);
-SSCDebugLow("customerName - '%s'", config->customerName);
-SSCDebugLow("customerId - '%s'", config->customerId);
-SSCDebugLow("departmentId - '%s'", config->departmentId);
-SSCDebugLow("acceptContact - '%s'", config->acceptContact);
-SSCDebugLow("require - '%s'", config->require);
-SSCDebugLow("content type - <%p>", config->contentType);
-SSCDebugLow("content type_s - '%s'", config->contentTypeStr);
-SSCDebugLow("route - '%s'", config->route);
-SSCDebugLow("expires - <%p> '%s'", config->expires, config->expires);
-SSCDebugLow("payload - <%p>", config->payload);
-SSCDebugLow("payloadStr - '%s'", config->payloadStr);
-SSCDebugLow("sdp - '%s'", config->sdp);
-SSCDebugLow("contentLen - '%s'", config->contentLength);
+SSCDebugLow("requestUri - '%s'", v->requestUri);
+SSCDebugLow("targetAddress - '%s'", v->targetAddress);
+SSCDebugLow("via - '%s'", v->via);
+SSCDebugLow("to - '%s'", v->toUri);
+SSCDebugLow("from - '%s'", v->fromUri);
+SSCDebugLow("callId - '%s'", v->callId);
+SSCDebugLow("accept - '%s'", v->accept);
+SSCDebugLow("allow - '%s'", v->allow);
+SSCDebugLow("eschat - '%s'", h->eschat);
+SSCDebugLow("contact - '%s'", h->contact);
+SSCDebugLow("priority - '%s'", v->priority);
+SSCDebugLow("talkerLocation - '%s'", v->talkerLocation);
+SSCDebugLow("customerName - '%s'", v->customerName);
+SSCDebugLow("customerId - '%s'", v->customerId);
+SSCDebugLow("departmentId - '%s'", v->departmentId);
+SSCDebugLow("acceptContact - '%s'", v->acceptContact);
+SSCDebugLow("require - '%s'", v->require);
+SSCDebugLow("content type - <%p>", v->contentType);
+SSCDebugLow("content type_s - '%s'", v->contentTypeStr);
+SSCDebugLow("route - '%s'", v->route);
+SSCDebugLow("expires - <%p> '%s'", v->expires, v->expires);
+SSCDebugLow("payload - <%p>", v->payload);
+SSCDebugLow("payloadStr - '%s'", v->payloadStr);
+SSCDebugLow("sdp - '%s'", v->sdp);
+SSCDebugLow("contentLen - '%s'", v->contentLength);
 SSCDebugLow("def_branch: '%s'", branchStr?branchStr:"<nil>");
 
+         op->op_times.t_req_sent = ssc_clock_us();
+         SSC_PROBE2(invite__send, op, v->callId);
+
+         ssc_metrics_request(SSC_METRICS_TX, sip_method_invite);
          nua_invite (op->op_handle,
 			            NUTAG_AUTOANSWER(0),
 			            NUTAG_INVITE_TIMER(10),
-                     TAG_IF((config->route[0] != '\0'), SIPTAG_ROUTE_STR(config->route)),
-			            TAG_IF((config->targetAddress[0] != '\0'), NUTAG_PROXY(config->targetAddress)),
+                     TAG_IF(v->h_route, SIPTAG_ROUTE(v->h_route)),
+                     TAG_IF((!v->h_route && v->route[0] != '\0'), SIPTAG_ROUTE_STR(v->route)),
+			            TAG_IF(v->h_proxy, NUTAG_PROXY((url_string_t const *)v->h_proxy)),
+			            TAG_IF((!v->h_proxy && v->targetAddress[0] != '\0'), NUTAG_PROXY(v->targetAddress)),
 			            TAG_IF(sipreq, SIPTAG_REQUEST(sipreq)),
-			            TAG_IF((config->via[0] != '\0'), SIPTAG_VIA_STR(config->via)),
-			            TAG_IF((config->toUri[0] != '\0'), SIPTAG_TO_STR(config->toUri)),
-			            TAG_IF((config->fromUri[0] != '\0'), SIPTAG_FROM_STR(config->fromUri)),
-			            TAG_IF((config->accept[0] != '\0'), SIPTAG_ACCEPT_STR(config->accept)),
-			            TAG_IF((config->allow[0] != '\0'), SIPTAG_ALLOW_STR(config->allow)),
-			            TAG_IF((eschatSipHeader[0] != '\0'), SIPTAG_HEADER_STR(eschatSipHeader)),
-			            TAG_IF((eschatTalkerLocationHeader[0] != '\0'), SIPTAG_HEADER_STR(eschatTalkerLocationHeader)),
-			            TAG_IF((eschatOrganizationHeader[0] != '\0'), SIPTAG_HEADER_STR(eschatOrganizationHeader)),
-			            TAG_IF((contactBuffer[0] != '\0'), SIPTAG_CONTACT_STR(contactBuffer)),
-                     TAG_IF((config->priority[0] != '\0'), SIPTAG_PRIORITY_STR(config->priority)),
-			            TAG_IF((config->acceptContact[0] != '\0'), SIPTAG_ACCEPT_CONTACT_STR(config->acceptContact)),
-			            TAG_IF((config->require[0] != '\0'), SIPTAG_REQUIRE_STR(config->require)),
-			            TAG_IF(config->contentType, SIPTAG_CONTENT_TYPE(config->contentType)),
-			            TAG_IF((config->contentTypeStr[0] != '\0'), SIPTAG_CONTENT_TYPE_STR(config->contentTypeStr)),
-			            TAG_IF((config->expires && config->expires[0] != '\0'), SIPTAG_EXPIRES_STR(config->expires)),
-                     TAG_IF((config->contentLength[0] != '\0'), SIPTAG_CONTENT_LENGTH_STR(config->contentLength)),
-                     TAG_IF(config->payload, SIPTAG_PAYLOAD(config->payload)),
-                     TAG_IF((config->payloadStr[0] != '\0'), SIPTAG_PAYLOAD_STR(config->payloadStr)),
-                     TAG_IF((config->payloadStr[0] == '\0' && config->sdp[0] != '\0'), SIPTAG_PAYLOAD_STR(config->sdp)),
+			            TAG_IF((v->via[0] != '\0'), SIPTAG_VIA_STR(v->via)),
+			            TAG_IF((v->toUri[0] != '\0'), SIPTAG_TO_STR(v->toUri)),
+			            TAG_IF(v->h_from, SIPTAG_FROM(v->h_from)),
+			            TAG_IF((!v->h_from && v->fromUri[0] != '\0'), SIPTAG_FROM_STR(v->fromUri)),
+			            TAG_IF(v->h_accept, SIPTAG_ACCEPT(v->h_accept)),
+			            TAG_IF((!v->h_accept && v->accept[0] != '\0'), SIPTAG_ACCEPT_STR(v->accept)),
+			            TAG_IF(v->h_allow, SIPTAG_ALLOW(v->h_allow)),
+			            TAG_IF((!v->h_allow && v->allow[0] != '\0'), SIPTAG_ALLOW_STR(v->allow)),
+			            TAG_IF((h->eschat[0] != '\0'), SIPTAG_HEADER_STR(h->eschat)),
+			            TAG_IF((h->talkerLocation[0] != '\0'), SIPTAG_HEADER_STR(h->talkerLocation)),
+			            TAG_IF((h->organization[0] != '\0'), SIPTAG_HEADER_STR(h->organization)),
+			            TAG_IF(v->h_contact, SIPTAG_CONTACT(v->h_contact)),
+			            TAG_IF((!v->h_contact && h->contact[0] != '\0'), SIPTAG_CONTACT_STR(h->contact)),
+                     TAG_IF(v->h_priority, SIPTAG_PRIORITY(v->h_priority)),
+                     TAG_IF((!v->h_priority && v->priority[0] != '\0'), SIPTAG_PRIORITY_STR(v->priority)),
+			            TAG_IF(v->h_accept_contact, SIPTAG_ACCEPT_CONTACT(v->h_accept_contact)),
+			            TAG_IF((!v->h_accept_contact && v->acceptContact[0] != '\0'), SIPTAG_ACCEPT_CONTACT_STR(v->acceptContact)),
+			            TAG_IF(v->h_require, SIPTAG_REQUIRE(v->h_require)),
+			            TAG_IF((!v->h_require && v->require[0] != '\0'), SIPTAG_REQUIRE_STR(v->require)),
+			            TAG_IF(v->contentType, SIPTAG_CONTENT_TYPE(v->contentType)),
+			            TAG_IF((v->contentTypeStr[0] != '\0'), SIPTAG_CONTENT_TYPE_STR(v->contentTypeStr)),
+			            TAG_IF(v->h_expires, SIPTAG_EXPIRES(v->h_expires)),
+			            TAG_IF((!v->h_expires && v->expires && v->expires[0] != '\0'), SIPTAG_EXPIRES_STR(v->expires)),
+                     TAG_IF((v->contentLength[0] != '\0'), SIPTAG_CONTENT_LENGTH_STR(v->contentLength)),
+                     TAG_IF(v->payload, SIPTAG_PAYLOAD(v->payload)),
+                     TAG_IF((v->payloadStr[0] != '\0'), SIPTAG_PAYLOAD_STR(v->payloadStr)),
+                     TAG_IF((v->payloadStr[0] == '\0' && v->sdp[0] != '\0'), SIPTAG_PAYLOAD_STR(v->sdp)),
 			            TAG_END());
 
          op->op_callstate |= opc_sent;
-         SSCDebugHigh ("%s: INVITE to %s", ssc->ssc_name, op->op_ident);
+         SSCDebugHigh ("%s: INVITE to %s", ssc->ssc_name, ssc_oper_ident(op));
       }
       else
       {
@@ -1212,9 +1743,112 @@ SSCDebugLow("def_branch: '%s'", branchStr?branchStr:"<nil>");
          op = NULL;
       }
    }
+
+   priv_multipart_release(ssc, mp);
+
+   sscLogKvPop(logKvSaved);
+   ssc_log_ctx_leave(logSaved);
+
    return op;
 }
 
+ssc_oper_t *ssc_invite (ssc_t * ssc, ssc_config_t *config)
+{
+   priv_req_view_t v;
+
+   if (!config)
+   {
+      SSCError("null SSC config ptr");
+      return NULL;
+   }
+
+   priv_req_view_from_config(&v, config);
+   return priv_invite(ssc, &v, NULL);
+}
+
+ssc_oper_t *ssc_invite_req (ssc_t * ssc, const ssc_req_t *req)
+{
+   priv_req_view_t v;
+
+   if (!req)
+   {
+      SSCError("null SSC request ptr");
+      return NULL;
+   }
+
+   priv_req_view_from_req(&v, req);
+   return priv_invite(ssc, &v, NULL);
+}
+
+unsigned ssc_invite_group(
+      ssc_t *ssc,
+      const ssc_profile_t *profile,
+      const ssc_group_member_t members[],
+      unsigned n,
+      const ssc_body_t *body,
+      ssc_oper_t *ops[])
+{
+   ssc_req_t req;
+   priv_req_view_t base, leg;
+   priv_invite_hdrs_t hdrs;
+   unsigned i, sent = 0;
+
+   if (!ssc || !profile || !members || !ops)
+   {
+      SSCError("%s: NULL ssc, profile, members or ops ptr!", __func__);
+      return 0;
+   }
+
+   ssc_req_init(&req, profile);
+   if (body && body->data)
+   {
+      ssc_req_set_body(&req, body->data, body->len);
+   }
+
+   // everything but To: and the Request-URI is common to all legs
+   priv_req_view_from_req(&base, &req);
+   priv_invite_hdrs(&base, &hdrs);
+
+   // take all legs from one pool slab rather than n separate allocations.
+   // free pooled ops are used first, and the pool only grows up to
+   // SSC_OPER_POOL_MAX; legs past that are allocated on their own.
+   if (ssc->ssc_op_pool_free < n && ssc->ssc_op_pool_size < SSC_OPER_POOL_MAX)
+   {
+      unsigned grow = n - ssc->ssc_op_pool_free;
+      if (grow > SSC_OPER_POOL_MAX - ssc->ssc_op_pool_size)
+      {
+         grow = SSC_OPER_POOL_MAX - ssc->ssc_op_pool_size;
+      }
+      ssc_oper_pool_reserve(ssc, grow);
+   }
+
+   SSCDebugMed("%s: %s: inviting %u member(s) of group '%s'",
+         __func__, ssc->ssc_name, n, base.groupName ? base.groupName : "");
+
+   for (i=0; i<n; ++i)
+   {
+      leg = base;
+      leg.toUri = members[i].toUri ? members[i].toUri : "";
+      if (members[i].requestUri)
+      {
+         leg.requestUri = members[i].requestUri;
+      }
+
+      ops[i] = priv_invite(ssc, &leg, &hdrs);
+      if (ops[i])
+      {
+         ops[i]->userData = members[i].userData;
+         ++sent;
+      }
+      else
+      {
+         SSCError("%s: failed to invite '%s'", __func__, leg.toUri);
+      }
+   }
+
+   return sent;
+}
+
 /*
  * send outgoing REGISTER request
  */
@@ -1223,27 +1857,37 @@ ssc_oper_t *ssc_register(ssc_t *ssc, ssc_config_t *config)
    return ssc_register_op(ssc, config, NULL);
 }
 
-ssc_oper_t *ssc_register_op(ssc_t *ssc, ssc_config_t *config, ssc_oper_t *op)
+ssc_oper_t *priv_register_op(ssc_t *ssc, const priv_req_view_t *view, ssc_oper_t *op)
 {
+   priv_req_view_t v[1];
+   priv_multipart_t mp[1];
+
    if (!ssc)
    {
       SSCError("%s: NULL SSC context ptr!", __func__);
       return NULL;
    }
 
-   if (!config)
+   if (!view)
    {
       SSCError("%s: NULL SSC config ptr!", __func__);
       return NULL;
    }
 
+   // local copy; the multipart body is attached to it for this request only
+   *v = *view;
+   if (v->payload == view->pl)
+   {
+      v->payload = v->pl;
+   }
+
    if (!op)
    {
       op = priv_oper_create(
 	                     ssc,
 	                     SIP_METHOD_REGISTER,
-	                     config->toUri,
-                        config->toUri, config->fromUri,
+	                     v->toUri,
+                        v->toUri, v->fromUri,
 	                     TAG_END());
    }
 
@@ -1263,71 +1907,88 @@ ssc_oper_t *ssc_register_op(ssc_t *ssc, ssc_config_t *config, ssc_oper_t *op)
       op->sip = NULL;
 
 		contactBuffer[0] = '\0';
-		if (config->postProcessContactUri == 0)
+		if (v->postProcessContactUri == 0)
 		{
-			strcat(contactBuffer, config->contactUri);
+			snprintf(contactBuffer, sizeof(contactBuffer), "%s", v->contactUri);
 		}
 		else
 		{
-			if (config->contactUri[0] != '\0')
+			if (v->contactUri[0] != '\0')
 			{
 				snprintf(contactBuffer, 1024, "<%s%s>%s",
-							config->contactUri,
-							config->contactUriFeatures,
-							config->contactFeatures);
+							v->contactUri,
+							v->contactUriFeatures,
+							v->contactFeatures);
 			}
 		}
 
-		if (strlen(config->requestUri) > 0)
+		if (strlen(v->requestUri) > 0)
 		{
-			sip_req = sip_request_create(ssc->ssc_home, SIP_METHOD_REGISTER, (const url_string_t *)config->requestUri, NULL);
+			sip_req = sip_request_create(ssc->ssc_home, SIP_METHOD_REGISTER, (const url_string_t *)v->requestUri, NULL);
 		}
 
+		priv_multipart_build(ssc, v, mp);
+
 SSCDebugLow("nua_register tags:");
-SSCDebugLow("targetAddress - '%s'", config->targetAddress);
+SSCDebugLow("targetAddress - '%s'", v->targetAddress);
 SSCDebugLow("contactBuffer - '%s'", contactBuffer);
-SSCDebugLow("req - <%p> '%s'", sip_req, config->requestUri);
-SSCDebugLow("via - '%s'", config->via);
-SSCDebugLow("toUri - '%s'", config->toUri);
-SSCDebugLow("fromUri - '%s'", config->fromUri);
-SSCDebugLow("callId - '%s'", config->callId);
-SSCDebugLow("accept - '%s'", config->accept);
-SSCDebugLow("allow - '%s'", config->allow);
-SSCDebugLow("expires - '%s'", config->expires);
-SSCDebugLow("content-type - '%s'", config->contentTypeStr);
-SSCDebugLow("content-len - '%s'", config->contentLength);
+SSCDebugLow("req - <%p> '%s'", sip_req, v->requestUri);
+SSCDebugLow("via - '%s'", v->via);
+SSCDebugLow("toUri - '%s'", v->toUri);
+SSCDebugLow("fromUri - '%s'", v->fromUri);
+SSCDebugLow("callId - '%s'", v->callId);
+SSCDebugLow("accept - '%s'", v->accept);
+SSCDebugLow("allow - '%s'", v->allow);
+SSCDebugLow("expires - '%s'", v->expires);
+SSCDebugLow("content-type - '%s'", v->contentTypeStr);
+SSCDebugLow("content-len - '%s'", v->contentLength);
 
 SSCDebugLow("payload: ");
-SSCDebugLow("%s", config->payloadStr);
+SSCDebugLow("%s", v->payloadStr);
 
-		trgtAddrLen = strlen(config->targetAddress);
+		trgtAddrLen = strlen(v->targetAddress);
 		if (trgtAddrLen > 64)
 		{
 			SSCWarning("Target address too long! %u [>%u]", trgtAddrLen, 64);
 		}
 
+		op->op_times.t_req_sent = ssc_clock_us();
+		op->op_times.t_2xx = 0;
+		SSC_PROBE2(register__send, op, v->callId);
+
+		ssc_metrics_request(SSC_METRICS_TX, sip_method_register);
 		nua_register(op->op_handle,
 		             NUTAG_OUTBOUND("no-validate no-options-keepalive"),
 		             NUTAG_DIALOG(0),
 		             TAG_IF(sip_req, SIPTAG_REQUEST(sip_req)),
-                   TAG_IF((contactBuffer[0] != '\0'), SIPTAG_CONTACT_STR(contactBuffer)),
-                   TAG_IF((config->targetAddress[0] != '\0'), NUTAG_PROXY(config->targetAddress)),
-                   TAG_IF((config->via[0] != '\0'), SIPTAG_VIA_STR(config->via)),
-                   TAG_IF((config->toUri[0] != '\0'), SIPTAG_TO_STR(config->toUri)),
-                   TAG_IF((config->fromUri[0] != '\0'), SIPTAG_FROM_STR(config->fromUri)),
-                   TAG_IF((config->callId[0] != '\0'), SIPTAG_CALL_ID_STR(config->callId)),
-                   TAG_IF((config->accept[0] != '\0'), SIPTAG_ACCEPT_STR(config->accept)),
-                   TAG_IF((config->allow[0] != '\0'), SIPTAG_ALLOW_STR(config->allow)),
-                   TAG_IF((config->expires[0] != '\0'), SIPTAG_EXPIRES_STR(config->expires)),
-                   TAG_IF((config->contentTypeStr[0] != '\0'), SIPTAG_CONTENT_TYPE_STR(config->contentTypeStr)),
-                   TAG_IF((config->contentLength[0] != '\0'), SIPTAG_CONTENT_LENGTH_STR(config->contentLength)),
-                   TAG_IF((config->payloadStr[0] != '\0'), SIPTAG_PAYLOAD_STR(config->payloadStr)),
+                   TAG_IF(v->h_contact, SIPTAG_CONTACT(v->h_contact)),
+                   TAG_IF((!v->h_contact && contactBuffer[0] != '\0'), SIPTAG_CONTACT_STR(contactBuffer)),
+                   TAG_IF(v->h_proxy, NUTAG_PROXY((url_string_t const *)v->h_proxy)),
+                   TAG_IF((!v->h_proxy && v->targetAddress[0] != '\0'), NUTAG_PROXY(v->targetAddress)),
+                   TAG_IF((v->via[0] != '\0'), SIPTAG_VIA_STR(v->via)),
+                   TAG_IF((v->toUri[0] != '\0'), SIPTAG_TO_STR(v->toUri)),
+                   TAG_IF(v->h_from, SIPTAG_FROM(v->h_from)),
+                   TAG_IF((!v->h_from && v->fromUri[0] != '\0'), SIPTAG_FROM_STR(v->fromUri)),
+                   TAG_IF((v->callId[0] != '\0'), SIPTAG_CALL_ID_STR(v->callId)),
+                   TAG_IF(v->h_accept, SIPTAG_ACCEPT(v->h_accept)),
+                   TAG_IF((!v->h_accept && v->accept[0] != '\0'), SIPTAG_ACCEPT_STR(v->accept)),
+                   TAG_IF(v->h_allow, SIPTAG_ALLOW(v->h_allow)),
+                   TAG_IF((!v->h_allow && v->allow[0] != '\0'), SIPTAG_ALLOW_STR(v->allow)),
+                   TAG_IF(v->h_expires, SIPTAG_EXPIRES(v->h_expires)),
+                   TAG_IF((!v->h_expires && v->expires[0] != '\0'), SIPTAG_EXPIRES_STR(v->expires)),
+                   TAG_IF((!v->contentType && v->contentTypeStr[0] != '\0'), SIPTAG_CONTENT_TYPE_STR(v->contentTypeStr)),
+                   TAG_IF((v->contentLength[0] != '\0'), SIPTAG_CONTENT_LENGTH_STR(v->contentLength)),
+                   TAG_IF((v->payloadStr[0] != '\0'), SIPTAG_PAYLOAD_STR(v->payloadStr)),
+                   TAG_IF(v->contentType, SIPTAG_CONTENT_TYPE(v->contentType)),
+                   TAG_IF(v->payload, SIPTAG_PAYLOAD(v->payload)),
                    TAG_END());
 
 		if (sip_req)
 		{
 			su_free(ssc->ssc_home, sip_req);
 		}
+
+		priv_multipart_release(ssc, mp);
 	}
 	else
 	{
@@ -1337,6 +1998,67 @@ SSCDebugLow("%s", config->payloadStr);
 	return op;
 }
 
+ssc_oper_t *ssc_register_op(ssc_t *ssc, ssc_config_t *config, ssc_oper_t *op)
+{
+   priv_req_view_t v;
+
+   if (!config)
+   {
+      SSCError("%s: NULL SSC config ptr!", __func__);
+      return NULL;
+   }
+
+   priv_req_view_from_config(&v, config);
+
+   // registrations have only ever used the string body fields
+   v.contentType = NULL;
+   v.payload = NULL;
+
+   return priv_register_op(ssc, &v, op);
+}
+
+ssc_oper_t *ssc_register_op_req(ssc_t *ssc, const ssc_req_t *req, ssc_oper_t *op)
+{
+   priv_req_view_t v;
+
+   if (!req)
+   {
+      SSCError("%s: NULL SSC request ptr!", __func__);
+      return NULL;
+   }
+
+   priv_req_view_from_req(&v, req);
+   return priv_register_op(ssc, &v, op);
+}
+
+ssc_oper_t *ssc_invite_tmpl(ssc_t *ssc, const ssc_template_t *tmpl, const ssc_req_t *req)
+{
+   priv_req_view_t v;
+
+   if (!tmpl || !req)
+   {
+      SSCError("%s: NULL template or request ptr!", __func__);
+      return NULL;
+   }
+
+   priv_req_view_from_tmpl(&v, tmpl, req);
+   return priv_invite(ssc, &v, NULL);
+}
+
+ssc_oper_t *ssc_register_tmpl(ssc_t *ssc, const ssc_template_t *tmpl, const ssc_req_t *req, ssc_oper_t *op)
+{
+   priv_req_view_t v;
+
+   if (!tmpl || !req)
+   {
+      SSCError("%s: NULL template or request ptr!", __func__);
+      return NULL;
+   }
+
+   priv_req_view_from_tmpl(&v, tmpl, req);
+   return priv_register_op(ssc, &v, op);
+}
+
 /**
  * Callback for response to outgoing REGISTER
  */
@@ -1381,6 +2103,14 @@ void ssc_r_register (int status, const char *phrase,
 	if (status >= 200 && status <300)
 	{
       SSCDebugHigh("RX success reg resp..");
+
+      // refreshes driven by sofia itself are not timed
+      if (op->op_times.t_2xx == 0)
+      {
+         op->op_times.t_2xx = ssc_clock_us();
+         priv_latency_record(ssc, SSC_LAT_REGISTER_2XX, op->op_times.t_req_sent, op->op_times.t_2xx);
+      }
+
 		if (op->userData)
 		{
 			if (ssc->ssc_msg_ok_cb)
@@ -1517,6 +2247,12 @@ void ssc_r_options (int status, char const *phrase,
 
 	if (status >= 200 && status <300)
 	{
+      if (op->op_times.t_2xx == 0)
+      {
+         op->op_times.t_2xx = ssc_clock_us();
+         priv_latency_record(ssc, SSC_LAT_OPTIONS_2XX, op->op_times.t_req_sent, op->op_times.t_2xx);
+      }
+
 		if (op->userData)
 		{
 			if (ssc->ssc_opt_ok_cb)
@@ -1605,6 +2341,13 @@ void ssc_r_invite (int status, char const *phrase,
    }
    else if (status >= 200)
    {
+      if (op->op_times.t_2xx == 0)
+      {
+         op->op_times.t_2xx = ssc_clock_us();
+         priv_latency_record(ssc, SSC_LAT_INVITE_2XX, op->op_times.t_req_sent, op->op_times.t_2xx);
+      }
+
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_ack);
       nua_ack(op->op_handle,
             TAG_IF((sip && sip->sip_to), SIPTAG_TO(sip->sip_to)), TAG_END());
 
@@ -1653,6 +2396,12 @@ void ssc_r_invite (int status, char const *phrase,
    }
    else if (status >= 100)
    {
+      if (op->op_times.t_1xx == 0)
+      {
+         op->op_times.t_1xx = ssc_clock_us();
+         priv_latency_record(ssc, SSC_LAT_INVITE_1XX, op->op_times.t_req_sent, op->op_times.t_1xx);
+      }
+
       if (ssc->ssc_1xx_cb)
       {
          ssc->ssc_1xx_cb(op->userData, status);
@@ -1682,6 +2431,7 @@ void ssc_i_fork (int status, char const *phrase,
    tl_gets (tags, NUTAG_HANDLE_REF (nh2), TAG_END ());
    if (!nh2) return;
 
+   ssc_metrics_request(SSC_METRICS_TX, sip_method_bye);
    nua_bye (nh2, TAG_END ());
    nua_handle_destroy (nh2);
 }
@@ -1881,9 +2631,16 @@ SSCDebugLow("parse multipart..");
       if ((op = priv_oper_create_uri_with_handle (ssc, SIP_METHOD_INVITE, nh, from, to, from)))
       {
          op->op_callstate = opc_recv;
+
+         // new call; priv_callback() restores the level on return
+         if ((op->op_log_verbose = ssc_log_ctx_match_sip(ssc, sip)))
+         {
+            ssc_log_ctx_enter(ssc, 1);
+         }
       }
       else
       {
+         ssc_metrics_response(SSC_METRICS_TX, sip_method_invite, 500);
          nua_respond (nh, SIP_500_INTERNAL_SERVER_ERROR, TAG_END ());
          nua_handle_destroy (nh);
       }
@@ -1894,7 +2651,7 @@ SSCDebugLow("parse multipart..");
       if (op->op_callstate == opc_recv)
       {
          SSCDebugHigh ("%s: incoming call From: %s", ssc->ssc_name,
-               op->op_ident);
+               ssc_oper_ident(op));
          SSCDebugHigh ("   Request URI: <" URL_PRINT_FORMAT ">",
                URL_PRINT_ARGS (requestUri->rq_url));
          SSCDebugHigh ("   To URI: <" URL_PRINT_FORMAT ">",
@@ -1929,7 +2686,7 @@ SSCDebugLow("parse multipart..");
       }
       else
       {
-         SSCDebugHigh ("%s: re-INVITE from: %s", ssc->ssc_name, op->op_ident);
+         SSCDebugHigh ("%s: re-INVITE from: %s", ssc->ssc_name, ssc_oper_ident(op));
       }
    }
 }
@@ -2093,6 +2850,7 @@ void ssc_i_register (nua_t * nua, ssc_t * ssc,
    sprintf((char *)respContact->m_url[0].url_host, "01.002.ABCDE.p25dr");
    sprintf(payloadBuf, "g-rfhangt:10\r\ng-ccsetupT:32767\r\ng-intmode:0\r\ng-man90-alias:ESChat Test\r\n");
 
+   ssc_metrics_response(SSC_METRICS_TX, sip_method_register, 200);
    nua_respond(nh, 200, "OK",
          NUTAG_WITH_THIS(nua),
          SIPTAG_TO(respTo),
@@ -2111,33 +2869,44 @@ void ssc_i_register (nua_t * nua, ssc_t * ssc,
  *
  * See also ssc_i_invite().
  */
-void ssc_answer (ssc_oper_t * op, int status, char const *phrase, ssc_config_t *config)
+void priv_answer (ssc_oper_t * op, int status, char const *phrase, const priv_req_view_t *view)
 {
-   if (op != NULL && config != NULL)
+   priv_req_view_t v[1];
+   priv_multipart_t mp[1];
+
+   if (op != NULL && view != NULL)
    {
 		if (status >= 200 && status < 300)
 		{
          const char *content = NULL;
 
+         // local copy; the multipart body is attached to it for this response only
+         *v = *view;
+         if (v->payload == view->pl)
+         {
+            v->payload = v->pl;
+         }
+         priv_multipart_build(op->op_ssc, v, mp);
+
          // content contains SDP only
-         if (config->sdp[0] != '\0')
+         if (v->sdp[0] != '\0')
          {
-            content = config->sdp;
+            content = v->sdp;
          }
 
          // multipart content overrides SDP-only content
-			if (config->payloadStr[0] != '\0')
+			if (v->payloadStr[0] != '\0')
          {
-            content = config->payloadStr;
+            content = v->payloadStr;
          }
 
-         if (content)
+         if (content || v->payload)
 			{
 				char contactBuffer[1024];
 
-				if (config->contactUri[0] != '\0')
+				if (v->contactUri[0] != '\0')
 				{
-					snprintf(contactBuffer, 1024, "<%s%s>%s", config->contactUri, config->contactUriFeatures, config->contactFeatures);
+					snprintf(contactBuffer, 1024, "<%s%s>%s", v->contactUri, v->contactUriFeatures, v->contactFeatures);
 				}
 				else
 				{
@@ -2156,22 +2925,26 @@ void ssc_answer (ssc_oper_t * op, int status, char const *phrase, ssc_config_t *
 				SSCDebugHigh("response: 200 OK");
 				SSCDebugHigh("status: %d", status);
 				SSCDebugHigh("phrase: '%s'", phrase);
-				SSCDebugHigh("via: '%s'", config->via);
+				SSCDebugHigh("via: '%s'", v->via);
 				SSCDebugHigh("contactBuffer: '%s'", contactBuffer);
-				SSCDebugHigh("expires: '%s'", config->expires);
-				SSCDebugHigh("contentType_s: '%s'", config->contentTypeStr);
-				SSCDebugHigh("contentLen: '%s'", config->contentLength);
+				SSCDebugHigh("expires: '%s'", v->expires);
+				SSCDebugHigh("contentType_s: '%s'", v->contentTypeStr);
+				SSCDebugHigh("contentLen: '%s'", v->contentLength);
 				SSCDebugHigh("content: '%s'", content);
 
+				SSC_PROBE2(answer__send, op, status);
+				ssc_metrics_response(SSC_METRICS_TX, op->op_method, status);
 				nua_respond (op->op_handle, status, phrase,
 						TAG_IF(strlen(contactBuffer), SIPTAG_CONTACT_STR(contactBuffer)),
-						TAG_IF(strlen(config->expires), SIPTAG_SESSION_EXPIRES_STR(config->expires)),
-				      TAG_IF(strlen(config->via), SIPTAG_VIA_STR(config->via)),
-						//TAG_IF(strlen(config->sdp), SOATAG_USER_SDP_STR (config->sdp)),
-						//TAG_IF(strlen(config->sdp), SIPTAG_PAYLOAD_STR(config->sdp)),
-						TAG_IF(strlen(config->contentTypeStr), SIPTAG_CONTENT_TYPE_STR(config->contentTypeStr)),
-						TAG_IF(strlen(config->contentLength), SIPTAG_CONTENT_LENGTH_STR(config->contentLength)),
-                  SIPTAG_PAYLOAD_STR(content),
+						TAG_IF(strlen(v->expires), SIPTAG_SESSION_EXPIRES_STR(v->expires)),
+				      TAG_IF(strlen(v->via), SIPTAG_VIA_STR(v->via)),
+						//TAG_IF(strlen(v->sdp), SOATAG_USER_SDP_STR (v->sdp)),
+						//TAG_IF(strlen(v->sdp), SIPTAG_PAYLOAD_STR(v->sdp)),
+						TAG_IF(v->contentType, SIPTAG_CONTENT_TYPE(v->contentType)),
+						TAG_IF(!v->contentType && strlen(v->contentTypeStr), SIPTAG_CONTENT_TYPE_STR(v->contentTypeStr)),
+						TAG_IF(strlen(v->contentLength), SIPTAG_CONTENT_LENGTH_STR(v->contentLength)),
+                  TAG_IF(content, SIPTAG_PAYLOAD_STR(content)),
+                  TAG_IF(!content, SIPTAG_PAYLOAD(v->payload)),
 						//SOATAG_RTP_SORT (SOA_RTP_SORT_REMOTE),
 						//SOATAG_RTP_SELECT (SOA_RTP_SELECT_ALL),
 						TAG_END ());
@@ -2181,13 +2954,19 @@ void ssc_answer (ssc_oper_t * op, int status, char const *phrase, ssc_config_t *
 				SSCDebugHigh
 					("ERROR: no SDP provided by media subsystem, unable to answer call.");
 				op->op_callstate = opc_none;
+				SSC_PROBE2(answer__send, op, 500);
+				ssc_metrics_response(SSC_METRICS_TX, op->op_method, 500);
 				nua_respond (op->op_handle, 500, "Not Acceptable Here",
 						TAG_END ());
 			}
+
+         priv_multipart_release(op->op_ssc, mp);
 		}
 		else // status < 200 || status >= 300
       {
          /* call rejected */
+         SSC_PROBE2(answer__send, op, status);
+         ssc_metrics_response(SSC_METRICS_TX, op->op_method, status);
          nua_respond (op->op_handle, status, phrase, TAG_END ());
          priv_destroy_oper_with_disconnect (op->op_ssc, op);
          op = NULL;
@@ -2199,6 +2978,39 @@ void ssc_answer (ssc_oper_t * op, int status, char const *phrase, ssc_config_t *
    }
 }
 
+void ssc_answer (ssc_oper_t * op, int status, char const *phrase, ssc_config_t *config)
+{
+   priv_req_view_t v;
+
+   if (config == NULL)
+   {
+      SSCWarning("NULL operation object received");
+      return;
+   }
+
+   priv_req_view_from_config(&v, config);
+
+   // answers have only ever been built from the string body fields
+   v.contentType = NULL;
+   v.payload = NULL;
+
+   priv_answer(op, status, phrase, &v);
+}
+
+void ssc_answer_req (ssc_oper_t * op, int status, char const *phrase, const ssc_req_t *req)
+{
+   priv_req_view_t v;
+
+   if (req == NULL)
+   {
+      SSCWarning("NULL operation object received");
+      return;
+   }
+
+   priv_req_view_from_req(&v, req);
+   priv_answer(op, status, phrase, &v);
+}
+
 /**
  * Incoming PRACK request.
  */
@@ -2272,6 +3084,21 @@ void ssc_i_state (int status, char const *phrase,
       op->sip = sip;
    }
 
+   if (op)
+   {
+      // completing: 2xx received for our INVITE, completed: 2xx sent for theirs
+      if ((ss_state == nua_callstate_completing || ss_state == nua_callstate_completed) &&
+          op->op_times.t_2xx == 0)
+      {
+         op->op_times.t_2xx = ssc_clock_us();
+      }
+      else if (ss_state == nua_callstate_ready && op->op_times.t_ready == 0)
+      {
+         op->op_times.t_ready = ssc_clock_us();
+         priv_latency_record(ssc, SSC_LAT_2XX_ACK, op->op_times.t_2xx, op->op_times.t_ready);
+      }
+   }
+
    switch ((enum nua_callstate) ss_state)
    {
       case nua_callstate_received:
@@ -2300,7 +3127,7 @@ void ssc_i_state (int status, char const *phrase,
          if (op)
          {
             SSCDebugHigh ("%s: call to %s is terminated", ssc->ssc_name,
-                  op->op_ident);
+                  ssc_oper_ident(op));
             op->op_callstate = 0;
             priv_destroy_oper_with_disconnect (ssc, op);
             op = NULL;
@@ -2313,7 +3140,12 @@ void ssc_i_state (int status, char const *phrase,
 
    if (op)
    {
+      if (op->oc_node)
+      {
+         ssc_metrics_op_state(op, ss_state);
+      }
       op->op_prev_state = ss_state;
+      ssc_group_op_state(op, ss_state, status);
    }
 
    if (ssc->ssc_call_state_cb)
@@ -2334,7 +3166,8 @@ void ssc_ack (ssc_oper_t * op)
 
    if (op)
    {
-      SSCDebugHigh ("ACK to %s", op->op_ident);
+      SSCDebugHigh ("ACK to %s", ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_ack);
       nua_ack(op->op_handle, 
             //TAG_IF((cfg->toUri[0] != '\0'), SIPTAG_TO_STR(cfg->toUri)),
             TAG_END());
@@ -2352,7 +3185,8 @@ void ssc_ringing (ssc_oper_t * op)
 {
    if (op)
    {
-      SSCDebugHigh ("RINGING to %s", op->op_ident);
+      SSCDebugHigh ("RINGING to %s", ssc_oper_ident(op));
+      ssc_metrics_response(SSC_METRICS_TX, op->op_method, 180);
       nua_respond(op->op_handle, SIP_180_RINGING, TAG_END());
    }
    else
@@ -2364,15 +3198,16 @@ void ssc_ringing (ssc_oper_t * op)
 /**
  * Sends a BYE request to an active operation 
  */
-void ssc_bye (ssc_oper_t * op, ssc_config_t *cfg)
+void priv_bye (ssc_oper_t * op, const priv_req_view_t *v)
 {
-   if (op && cfg)
+   if (op && v)
    {
-      SSCDebugHigh ("BYE to %s [via '%s']", op->op_ident,cfg->targetAddress);
-      SSCDebugLow("to - '%s'", cfg->toUri);
+      SSCDebugHigh ("BYE to %s [via '%s']", ssc_oper_ident(op), v->targetAddress);
+      SSCDebugLow("to - '%s'", v->toUri);
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_bye);
       nua_bye (op->op_handle,
-         TAG_IF((cfg->targetAddress[0] != '\0'), NUTAG_PROXY(cfg->targetAddress)),
-         TAG_IF((cfg->toUri[0] != '\0'), SIPTAG_TO_STR(cfg->toUri)),
+         TAG_IF((v->targetAddress[0] != '\0'), NUTAG_PROXY(v->targetAddress)),
+         TAG_IF((v->toUri[0] != '\0'), SIPTAG_TO_STR(v->toUri)),
 		   TAG_END());
       op->op_callstate = 0;
    }
@@ -2382,6 +3217,34 @@ void ssc_bye (ssc_oper_t * op, ssc_config_t *cfg)
    }
 }
 
+void ssc_bye (ssc_oper_t * op, ssc_config_t *cfg)
+{
+   priv_req_view_t v;
+
+   if (!cfg)
+   {
+      SSCWarning("NULL operation object received");
+      return;
+   }
+
+   priv_req_view_from_config(&v, cfg);
+   priv_bye(op, &v);
+}
+
+void ssc_bye_req (ssc_oper_t * op, const ssc_req_t *req)
+{
+   priv_req_view_t v;
+
+   if (!req)
+   {
+      SSCWarning("NULL operation object received");
+      return;
+   }
+
+   priv_req_view_from_req(&v, req);
+   priv_bye(op, &v);
+}
+
 /**
  * Callback for an outgoing BYE request.
  */
@@ -2462,7 +3325,8 @@ void ssc_cancel (ssc_oper_t * op)
    if (op)
    {
       SSCDebugHigh ("CANCEL %s to %s",
-            op->op_method_name, op->op_ident);
+            op->op_method_name, ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_cancel);
       nua_cancel (op->op_handle, TAG_END ());
    }
    else
@@ -2522,8 +3386,9 @@ void ssc_message (ssc_t * ssc, const char *destination, const char *msg)
    if (op)
    {
 
-      SSCDebugHigh ("%s: sending message to %s", ssc->ssc_name, op->op_ident);
+      SSCDebugHigh ("%s: sending message to %s", ssc->ssc_name, ssc_oper_ident(op));
 
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_message);
       nua_message (op->op_handle,
             SIPTAG_CONTENT_TYPE_STR ("text/plain"),
             SIPTAG_PAYLOAD_STR (msg), TAG_END ());
@@ -2629,7 +3494,8 @@ void ssc_subscribe (ssc_t * ssc, char *destination)
 
    if (op)
    {
-      SSCDebugHigh ("%s: SUBSCRIBE %s to %s", ssc->ssc_name?ssc->ssc_name:"<nil>", event, op->op_ident?op->op_ident:"<nil>");
+      SSCDebugHigh ("%s: SUBSCRIBE %s to %s", ssc->ssc_name?ssc->ssc_name:"<nil>", event, ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_subscribe);
       nua_subscribe (op->op_handle,
             SIPTAG_EXPIRES_STR ("3600"),
             SIPTAG_ACCEPT_STR ("application/cpim-pidf+xml;q=0.5, "
@@ -2661,7 +3527,8 @@ void ssc_watch (ssc_t * ssc, char *event)
 
    if (op)
    {
-      SSCDebugHigh ("%s: SUBSCRIBE %s to %s", ssc->ssc_name?ssc->ssc_name:"<nil>", event, op->op_ident?op->op_ident:"<nil>");
+      SSCDebugHigh ("%s: SUBSCRIBE %s to %s", ssc->ssc_name?ssc->ssc_name:"<nil>", event, ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_subscribe);
       nua_subscribe (op->op_handle, SIPTAG_EVENT_STR (event), TAG_END ());
    }
 }
@@ -2703,6 +3570,7 @@ void ssc_notify (ssc_t * ssc, char *destination)
    {
       SSCDebugHigh ("%s: not follow refer, NOTIFY(503)", ssc->ssc_name?ssc->ssc_name:"<nil>");
 
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_cancel);
       nua_cancel (op->op_handle, TAG_END ());
       ssc_oper_destroy (ssc, op);
    }
@@ -2731,7 +3599,7 @@ void ssc_i_notify (nua_t * nua, ssc_t * ssc,
       sip_payload_t const *payload = sip->sip_payload;
 
       if (op)
-         SSCDebugHigh ("%s: NOTIFY from %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_ident?op->op_ident:"<nil>");
+         SSCDebugHigh ("%s: NOTIFY from %s", ssc->ssc_name?ssc->ssc_name:"<nil>", ssc_oper_ident(op));
       else
          SSCDebugHigh ("%s: rogue NOTIFY from " URL_PRINT_FORMAT "",
                ssc->ssc_name?ssc->ssc_name:"<nil>", URL_PRINT_ARGS (from->a_url));
@@ -2744,7 +3612,7 @@ void ssc_i_notify (nua_t * nua, ssc_t * ssc,
    }
    else if (op)
       SSCDebugHigh ("%s: SUBSCRIBE/NOTIFY timeout for %s", ssc->ssc_name?ssc->ssc_name:"<nil>",
-            op->op_ident?op->op_ident:"<nil>");
+            ssc_oper_ident(op));
 }
 
 /*---------------------------------------*/
@@ -2794,7 +3662,8 @@ void ssc_unsubscribe (ssc_t * ssc, char *destination)
 
    if (op)
    {
-      SSCDebugHigh ("%s: un-SUBSCRIBE to %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_ident?op->op_ident:"<nil>");
+      SSCDebugHigh ("%s: un-SUBSCRIBE to %s", ssc->ssc_name?ssc->ssc_name:"<nil>", ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_subscribe);
       nua_unsubscribe (op->op_handle, TAG_END ());
    }
    else
@@ -2861,7 +3730,8 @@ void ssc_publish (ssc_t * ssc, const char *note)
 
    if ((op = ssc_oper_find_by_method (ssc, sip_method_publish)))
    {
-      SSCDebugHigh ("%s: %s %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_method_name?op->op_method_name:"<nil>", op->op_ident?op->op_ident:"<nil>");
+      SSCDebugHigh ("%s: %s %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_method_name?op->op_method_name:"<nil>", ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_publish);
       nua_publish (op->op_handle,
             SIPTAG_PAYLOAD (pl),
             TAG_IF (pl,
@@ -2877,7 +3747,8 @@ void ssc_publish (ssc_t * ssc, const char *note)
    if ((op = priv_oper_create (ssc, SIP_METHOD_PUBLISH, address, "", "",
                SIPTAG_EVENT_STR ("presence"), TAG_END ())))
    {
-      SSCDebugHigh ("%s: %s %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_method_name?op->op_method_name:"<nil>", op->op_ident?op->op_ident:"<nil>");
+      SSCDebugHigh ("%s: %s %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_method_name?op->op_method_name:"<nil>", ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_publish);
       nua_publish (op->op_handle,
             SIPTAG_CONTENT_TYPE_STR ("application/cpim-pidf+xml"),
             SIPTAG_PAYLOAD (pl), TAG_END ());
@@ -2900,7 +3771,8 @@ void ssc_unpublish (ssc_t * ssc)
 
    if ((op = ssc_oper_find_by_method (ssc, sip_method_publish)))
    {
-      SSCDebugHigh ("%s: %s %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_method_name?op->op_method_name:"<nil>", op->op_ident?op->op_ident:"<nil>");
+      SSCDebugHigh ("%s: %s %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_method_name?op->op_method_name:"<nil>", ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_publish);
       nua_publish (op->op_handle, SIPTAG_EXPIRES_STR ("0"), TAG_NULL ());
       return;
    }
@@ -2911,7 +3783,8 @@ void ssc_unpublish (ssc_t * ssc)
                SIPTAG_EVENT_STR ("presence"), TAG_END ())))
    {
       SSCDebugHigh ("%s: un-%s %s", ssc->ssc_name?ssc->ssc_name:"<nil>", op->op_method_name?op->op_method_name:"<nil>",
-            op->op_ident?op->op_ident:"<nil>");
+            ssc_oper_ident(op));
+      ssc_metrics_request(SSC_METRICS_TX, sip_method_publish);
       nua_publish (op->op_handle, SIPTAG_EXPIRES_STR ("0"), TAG_END ());
    }
 
@@ -3022,6 +3895,150 @@ void ssc_r_get_params (int status, char const *phrase,
    }
 }
 
+int ssc_get_latency (ssc_t *ssc, ssc_latency_t kind, ssc_hist_t *out)
+{
+   if (!ssc || !out)
+   {
+      SSCError("%s: NULL ptr arg", __func__);
+      return -1;
+   }
+
+   if ((unsigned)kind >= SSC_LAT_COUNT)
+   {
+      SSCError("%s: latency kind out of range (val: %d)", __func__, kind);
+      return -1;
+   }
+
+   memcpy(out, &ssc->ssc_lat[kind], sizeof(*out));
+   return 0;
+}
+
+void ssc_reset_latency (ssc_t *ssc)
+{
+   unsigned i;
+
+   if (!ssc)
+      return;
+
+   for (i = 0; i < SSC_LAT_COUNT; ++i)
+      ssc_hist_reset(&ssc->ssc_lat[i]);
+}
+
+const char *ssc_latency_name (ssc_latency_t kind)
+{
+   switch (kind)
+   {
+      case SSC_LAT_INVITE_1XX:   return "invite_1xx";
+      case SSC_LAT_INVITE_2XX:   return "invite_2xx";
+      case SSC_LAT_2XX_ACK:      return "2xx_ack";
+      case SSC_LAT_REGISTER_2XX: return "register_2xx";
+      case SSC_LAT_OPTIONS_2XX:  return "options_2xx";
+      default:                   return "unknown";
+   }
+}
+
+int ssc_get_event_stats (ssc_t *ssc, nua_event_t event, ssc_event_stats_t *out)
+{
+   if (!ssc || !out)
+   {
+      SSCError("%s: NULL ptr arg", __func__);
+      return -1;
+   }
+
+   if ((unsigned)event >= SSC_EVENT_STATS_MAX)
+   {
+      SSCError("%s: event out of range (val: %d)", __func__, event);
+      return -1;
+   }
+
+   memset(out, 0, sizeof(*out));
+   if (!ssc->ssc_ev_lat)
+      return 0;
+
+   const ssc_hist_t *h = &ssc->ssc_ev_lat[event];
+   out->count = h->count;
+   out->p50_ns = ssc_hist_percentile(h, 50.0);
+   out->p99_ns = ssc_hist_percentile(h, 99.0);
+   out->max_ns = h->max;
+   return 0;
+}
+
+int ssc_get_event_hist (ssc_t *ssc, nua_event_t event, ssc_hist_t *out)
+{
+   if (!ssc || !out)
+   {
+      SSCError("%s: NULL ptr arg", __func__);
+      return -1;
+   }
+
+   if ((unsigned)event >= SSC_EVENT_STATS_MAX)
+   {
+      SSCError("%s: event out of range (val: %d)", __func__, event);
+      return -1;
+   }
+
+   if (!ssc->ssc_ev_lat)
+      ssc_hist_reset(out);
+   else
+      memcpy(out, &ssc->ssc_ev_lat[event], sizeof(*out));
+   return 0;
+}
+
+void ssc_reset_event_stats (ssc_t *ssc)
+{
+   unsigned i;
+
+   if (!ssc || !ssc->ssc_ev_lat)
+      return;
+
+   for (i = 0; i < SSC_EVENT_STATS_MAX; ++i)
+      ssc_hist_reset(&ssc->ssc_ev_lat[i]);
+}
+
+void ssc_set_event_budget (ssc_t *ssc, uint64_t budget_ns, ssc_slow_event_cb cb)
+{
+   if (!ssc)
+      return;
+
+   ssc->ssc_ev_budget_ns = cb ? budget_ns : 0;
+   ssc->ssc_slow_event_cb = budget_ns ? cb : NULL;
+}
+
+/**
+ * Adds one dispatch time to the histogram of its event and reports it
+ * if it went over the configured budget. The histograms are allocated
+ * on the first event so contexts that never dispatch do not carry them.
+ */
+static void priv_event_time_record (ssc_t *ssc, nua_event_t event, int status, uint64_t elapsed)
+{
+   if ((unsigned)event >= SSC_EVENT_STATS_MAX)
+      return;
+
+   if (!ssc->ssc_ev_lat)
+   {
+      ssc->ssc_ev_lat = su_zalloc(ssc->ssc_home, SSC_EVENT_STATS_MAX * sizeof(ssc_hist_t));
+      if (!ssc->ssc_ev_lat)
+         return;
+   }
+
+   ssc_hist_record(&ssc->ssc_ev_lat[event], elapsed);
+
+   if (ssc->ssc_slow_event_cb && elapsed > ssc->ssc_ev_budget_ns)
+      ssc->ssc_slow_event_cb(ssc, event, status, elapsed, ssc->userData);
+}
+
+/**
+ * Adds one sample to a latency histogram. Transitions whose start was
+ * never seen (e.g. a response to a request we did not time) are skipped.
+ */
+static void priv_latency_record (ssc_t *ssc, ssc_latency_t kind, uint64_t start, uint64_t end)
+{
+   if (start == 0 || end < start)
+      return;
+
+   ssc_hist_record(&ssc->ssc_lat[kind], end - start);
+}
+
 /**
  * Prints SIP message payload to stdout.
  */
@@ -46,6 +46,8 @@ typedef struct ssc_conf_s ssc_conf_t;
 
 #include "ssc_oper.h"
 #include "ssc_types.h"
+#include "ssc_stats.h"
+#include "ssc_profile.h"
 
 #include <sofia-sip/sip.h>
 #include <sofia-sip/sip_header.h>
@@ -184,6 +186,7 @@ typedef void (*ssc_event_cb)(ssc_t *ssc, nua_event_t event, void *context);
 typedef void (*ssc_auth_req_cb)(ssc_t *ssc, const ssc_auth_item_t *authitem, void *context);
 typedef void (*ssc_call_state_cb)(ssc_t *ssc, ssc_oper_t *oper, int ss_state, void *context);
 typedef void (*ssc_error_cb)(ssc_t *ssc, int status, const char *phrase, ssc_oper_t *oper);
+typedef void (*ssc_slow_event_cb)(ssc_t *ssc, nua_event_t event, int status, uint64_t elapsed_ns, void *context);
 
 /*
  * return non-0 if resource was not allocated
@@ -239,6 +242,33 @@ struct ssc_nni_type_s {
 
 typedef struct ssc_nni_type_s ssc_nni_type_t;
 
+/**
+ * Setup latencies measured per operation and collected
+ * into one histogram each on the SSC context.
+ */
+typedef enum ssc_latency_e {
+  SSC_LAT_INVITE_1XX = 0,   /**< INVITE sent to first provisional response */
+  SSC_LAT_INVITE_2XX,       /**< INVITE sent to 2xx received */
+  SSC_LAT_2XX_ACK,          /**< 2xx sent/received to call ready (ACK) */
+  SSC_LAT_REGISTER_2XX,     /**< REGISTER sent to 2xx received */
+  SSC_LAT_OPTIONS_2XX,      /**< OPTIONS sent to 2xx received */
+  SSC_LAT_COUNT
+} ssc_latency_t;
+
+/** Number of nua_event_t values timed by priv_callback; higher ones are skipped */
+#define SSC_EVENT_STATS_MAX 64
+
+/**
+ * Dispatch time summary for one nua_event_t, see ssc_get_event_stats().
+ * All times are in nanoseconds.
+ */
+typedef struct ssc_event_stats_s {
+  uint64_t      count;          /**< Events dispatched */
+  uint64_t      p50_ns;         /**< Median dispatch time */
+  uint64_t      p99_ns;         /**< 99th percentile dispatch time */
+  uint64_t      max_ns;         /**< Slowest dispatch */
+} ssc_event_stats_t;
+
 /**
  * Instance data for ssc_sip_t objects.
  */
@@ -255,9 +285,25 @@ struct ssc_s {
   void         *userData; /**< Context for callbacks */
   void         *ssc_ext; /* optional extension for protocol specific data */
   void         *ssc_oc; /* operator container */
+  void         *ssc_tw; /* operation idle timer wheel */
+  void         *ssc_issi; /* cached ISSI INVITE body parts, see ssc_issi.h */
+  void         *ssc_log_ctx; /* per-call log selection, see ssc_log_ctx.h */
+  void         *ssc_lm; /* event loop lag monitor, see ssc_loop_mon.h */
 
   ssc_nni_type_t nniType;
 
+  int           ssc_op_packed;  /**< Allocate ops with the packed layout */
+  int           ssc_fr_enabled; /**< Keep a per-op flight recorder ring, see ssc_oper_fr_record() */
+
+  ssc_oper_t   *ssc_op_free;      /**< Pooled ops ready for reuse */
+  void         *ssc_op_slabs;     /**< Op pool slabs, see ssc_oper_pool_reserve() */
+  unsigned      ssc_op_pool_size; /**< Ops reserved in the pool */
+  unsigned      ssc_op_pool_free; /**< Pooled ops not in use */
+
+  ssc_hist_t    ssc_lat[SSC_LAT_COUNT]; /**< Setup latencies in usec */
+  ssc_hist_t   *ssc_ev_lat;     /**< Per-event dispatch times in nsec, allocated on first event */
+  uint64_t      ssc_ev_budget_ns; /**< Dispatch budget for ssc_slow_event_cb, 0 = off */
+
   nua_callback_f ssc_nua_cb;
 
   ssc_exit_cb         ssc_exit_cb;        /**< Callback to signal stack shutdown */
@@ -294,6 +340,7 @@ struct ssc_s {
   ssc_oper_destroyed_cb ssc_oper_destroyed_cb;
   ssc_invite_failure_cb ssc_invite_failure_cb;
   ssc_error_cb ssc_error_cb;
+  ssc_slow_event_cb ssc_slow_event_cb;
 };
 
 /** 
@@ -312,6 +359,16 @@ struct ssc_conf_s {
   const char   *ssc_reg_bind_addr;
   const char   *ssc_call_bind_addr;
   int           ssc_flags;
+  int           ssc_op_packed;  /**< Non-zero: one allocation per op, keys inline, lazy op_ident */
+  int           ssc_flight_recorder; /**< Non-zero: record the last events of each op and dump them on failure */
+
+  /* expected number of concurrent operations per method. when any is
+   * non-zero, ssc_create() pre-allocates that many ops and the op
+   * container so that startup bursts do not hit the allocator. */
+  unsigned      ssc_expect_register;
+  unsigned      ssc_expect_invite;
+  unsigned      ssc_expect_options;
+  unsigned      ssc_expect_other;  /**< MESSAGE, SUBSCRIBE, ... */
 };
 
 #if HAVE_FUNC
@@ -329,11 +386,17 @@ void ssc_answer(ssc_oper_t *op, int status, char const *phrase, ssc_config_t *co
 void ssc_ringing (ssc_oper_t *op);
 void ssc_ack (ssc_oper_t *op);
 void ssc_bye(ssc_oper_t *op, ssc_config_t *config);
+
+// layered-config variants of ssc_answer() and ssc_bye() (see ssc_profile.h).
+void ssc_answer_req(ssc_oper_t *op, int status, char const *phrase, const ssc_req_t *req);
+void ssc_bye_req(ssc_oper_t *op, const ssc_req_t *req);
 void ssc_cancel(ssc_oper_t *op);
 
 // Builds the payloadOut and contentTypeOut from the sdp and metadata.
 // The mimeMsg is a msg_t object with the memory allocations for the 
 // sip_payload_t and the sip_content_type_t.
+// The body is written in one pass with a fresh boundary; use the
+// ssc_mime.h writer directly to reuse a boundary or supply the buffer.
 int ssc_create_siprec_mime(
       const char *sdp,
       const char *metadata,
@@ -343,6 +406,41 @@ int ssc_create_siprec_mime(
 
 ssc_oper_t *ssc_invite(ssc_t *ssc, ssc_config_t *config);
 
+// same as ssc_invite() but takes a profile plus sparse per-request
+// overrides instead of a full config (see ssc_profile.h).
+ssc_oper_t *ssc_invite_req(ssc_t *ssc, const ssc_req_t *req);
+
+// one leg of a group call, see ssc_invite_group().
+typedef struct ssc_group_member_s
+{
+   const char *toUri;       // To: URI of this leg
+   const char *requestUri;  // [optional] Request-URI of this leg. NULL == use the profile's
+   void *userData;          // stored as the userData of the leg's operation
+} ssc_group_member_t;
+
+// send an INVITE to every member of a group call.
+// the headers common to all legs (ESChat-Call, talker location,
+// organization, contact) are formatted once from @p profile and the
+// body is wrapped once and shared by every leg; only To: and the
+// Request-URI differ per leg.
+// legs are taken from the op pool, which is grown as needed up to
+// SSC_OPER_POOL_MAX ops; legs beyond that are allocated individually.
+// @param[in]  profile  call profile; holds the group name and call id
+// @param[in]  members  the legs to call
+// @param[in]  n        number of entries in @p members
+// @param[in]  body     [optional] body sent on every leg. must stay valid
+//                      until this returns.
+// @param[out] ops      receives the operation of each leg (n entries).
+//                      NULL for legs that could not be sent.
+// @return number of legs sent.
+unsigned ssc_invite_group(
+      ssc_t *ssc,
+      const ssc_profile_t *profile,
+      const ssc_group_member_t members[],
+      unsigned n,
+      const ssc_body_t *body,
+      ssc_oper_t *ops[]);
+
 // generate and send an outgoing REGISTER request.
 // this creates a new NUA handle to manage the request.
 // ( internally just a wrapper for
@@ -355,6 +453,10 @@ ssc_oper_t *ssc_register(ssc_t *ssc, ssc_config_t *config);
 // then a new operation (and new handle) will be created.
 ssc_oper_t *ssc_register_op(ssc_t *ssc, ssc_config_t *config, ssc_oper_t *op);
 
+// same as ssc_register_op() but takes a profile plus sparse per-request
+// overrides instead of a full config (see ssc_profile.h).
+ssc_oper_t *ssc_register_op_req(ssc_t *ssc, const ssc_req_t *req, ssc_oper_t *op);
+
 // generate and send an outgoing OPTIONS request.
 // this creates a new NUA handle to manage the request.
 ssc_oper_t *ssc_options(ssc_t *ssc, ssc_config_t *config);
@@ -370,6 +472,34 @@ void ssc_subscribe(ssc_t *ssc, char *destination);
 void ssc_unsubscribe(ssc_t *ssc, char *destination);
 void ssc_watch(ssc_t *ssc, char *event);
 
+// copy out the setup latency histogram of the indicated kind.
+// values are in microseconds; see ssc_stats.h for the query helpers.
+// @return 0 on success, -1 on bad args.
+int ssc_get_latency(ssc_t *ssc, ssc_latency_t kind, ssc_hist_t *out);
+
+// clear all setup latency histograms.
+void ssc_reset_latency(ssc_t *ssc);
+
+// returns a printable name for a latency kind.
+const char *ssc_latency_name(ssc_latency_t kind);
+
+// summarize the time priv_callback spent dispatching @p event, including
+// any application callbacks it invoked.
+// @return 0 on success, -1 on bad args.
+int ssc_get_event_stats(ssc_t *ssc, nua_event_t event, ssc_event_stats_t *out);
+
+// copy out the full dispatch time histogram (nsec) of @p event.
+// @return 0 on success, -1 on bad args.
+int ssc_get_event_hist(ssc_t *ssc, nua_event_t event, ssc_hist_t *out);
+
+// clear all per-event dispatch time histograms.
+void ssc_reset_event_stats(ssc_t *ssc);
+
+// report dispatches of any event that take longer than @p budget_ns
+// through @p cb, called with ssc->userData as context after the handler
+// returns. a budget of 0 or a NULL callback turns reporting off.
+void ssc_set_event_budget(ssc_t *ssc, uint64_t budget_ns, ssc_slow_event_cb cb);
+
 void ssc_print_payload(ssc_t *ssc, sip_payload_t const *pl);
 void ssc_print_settings(ssc_t *ssc);
 
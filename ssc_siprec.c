@@ -0,0 +1,951 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_siprec.h"
+
+#include <string.h>
+
+#include <sofia-sip/su_alloc.h>
+
+#include "ssc_log.h"
+#include "ssc_oper.h"
+#include "ssc_metrics.h"
+
+#define SIPREC_INITIAL_ITEMS 16
+
+// leg mark of a recorder whose metadata is not known to be current
+#define SIPREC_LEG_STALE 0
+
+// change state of a participant or stream
+enum
+{
+   SIPREC_ACTIVE = 0,   // already written
+   SIPREC_ADDED,        // added since the last write
+   SIPREC_CHANGED,      // written before, details changed since
+   SIPREC_REMOVED       // removed since the last write, still to be written
+};
+
+typedef struct ssc_siprec_part_s
+{
+   char *id;
+   char *aor;
+   char *name;
+   int state;
+   unsigned changed : 1;   // details differ from what was last written
+} ssc_siprec_part_t;
+
+typedef struct ssc_siprec_stream_s
+{
+   char *id;
+   char *label;
+   char *sender;
+   char *prev_sender;      // sender last written, while changed
+   int state;
+   unsigned changed : 1;   // details differ from what was last written
+} ssc_siprec_stream_t;
+
+struct ssc_siprec_s
+{
+   su_home_t home[1];
+
+   char *session_id;
+   char *sip_session_id;
+
+   ssc_siprec_part_t *part;
+   unsigned part_count;
+   unsigned part_size;
+
+   ssc_siprec_stream_t *stream;
+   unsigned stream_count;
+   unsigned stream_size;
+
+   unsigned pending;
+   unsigned long gen;              // bumped by every commit, never SIPREC_LEG_STALE
+
+   ssc_mime_boundary_t boundary;   // reused for every body of the session
+
+   // recorder legs; each leg's group mark is the gen it was last sent
+   ssc_group_t *legs;
+   ssc_siprec_body_t *body;        // last body sent to the legs
+};
+
+struct ssc_siprec_body_s
+{
+   su_home_t home[1];              // also holds the encoded buffer
+   sip_payload_t pl[1];
+   sip_content_type_t *ct;
+   unsigned long gen;              // session gen a recorder is at once it has this body
+   char *sdp;                      // SDP part, to catch up legs later
+   size_t sdp_len;
+};
+
+static int priv_siprec_find_part(const ssc_siprec_t *rs, const char *id);
+static int priv_siprec_find_stream(const ssc_siprec_t *rs, const char *id);
+static int priv_siprec_str_eq(const char *a, const char *b);
+static int priv_siprec_grow(ssc_siprec_t *rs, void **array, unsigned *size, size_t item);
+static int priv_siprec_sender_seen(const ssc_siprec_t *rs, unsigned upto, const char *sender);
+static void priv_siprec_sender_assoc(ssc_siprec_t *rs, ssc_rsmeta_t *md, const char *sender);
+static int priv_siprec_write_complete(ssc_siprec_t *rs, ssc_mime_t *mime);
+static int priv_siprec_write_update(ssc_siprec_t *rs, ssc_mime_t *mime);
+static int priv_siprec_partial_ok(const ssc_siprec_t *rs);
+static void priv_siprec_commit(ssc_siprec_t *rs);
+static ssc_siprec_body_t *priv_siprec_encode(ssc_siprec_t *rs, const char *sdp, size_t sdp_len,
+      int update, int commit);
+static int priv_siprec_send(ssc_siprec_t *rs, ssc_oper_t *op, ssc_siprec_body_t *body);
+static int priv_siprec_catch_up(ssc_siprec_t *rs, ssc_oper_t *op, const char *sdp, size_t sdp_len);
+static void priv_siprec_leg_state(ssc_group_t *group, ssc_oper_t *op, int state, int status, void *context);
+static int priv_siprec_is_established(const ssc_oper_t *op);
+
+ssc_siprec_t *ssc_siprec_create(const char *session_id, const char *sip_session_id)
+{
+   if (!session_id)
+   {
+      SSCError("%s: NULL session id", __func__);
+      return NULL;
+   }
+
+   ssc_siprec_t *rs = (ssc_siprec_t *)su_home_new(sizeof(ssc_siprec_t));
+   if (!rs)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_siprec_t));
+      return NULL;
+   }
+
+   rs->session_id = su_strdup(rs->home, session_id);
+   rs->sip_session_id = sip_session_id ? su_strdup(rs->home, sip_session_id) : NULL;
+
+   if (!rs->session_id || (sip_session_id && !rs->sip_session_id))
+   {
+      SSCError("%s: alloc fail - session ids", __func__);
+      su_home_unref(rs->home);
+      return NULL;
+   }
+
+   ssc_mime_boundary_init(&rs->boundary, NULL);
+   rs->gen = SIPREC_LEG_STALE + 1;
+
+   return rs;
+}
+
+void ssc_siprec_destroy(ssc_siprec_t *rs)
+{
+   if (!rs) { return; }
+
+   ssc_group_destroy(rs->legs);
+   ssc_siprec_body_unref(rs->body);
+
+   su_home_unref(rs->home);
+}
+
+int ssc_siprec_add_participant(ssc_siprec_t *rs, const char *participant_id,
+      const char *aor, const char *name)
+{
+   if (!rs || !participant_id || !aor)
+   {
+      SSCError("%s: NULL session, participant id or aor", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   int i = priv_siprec_find_part(rs, participant_id);
+   if (i >= 0)
+   {
+      ssc_siprec_part_t *p = &rs->part[i];
+      if (p->state != SIPREC_REMOVED)
+      {
+         SSCError("%s: participant '%s' already present", __func__, participant_id);
+         return SIPREC_FAILURE;
+      }
+
+      if (strcmp(p->aor, aor) == 0 && priv_siprec_str_eq(p->name, name))
+      {
+         // left and came back before an update went out; the removal is void
+         p->state = p->changed ? SIPREC_CHANGED : SIPREC_ACTIVE;
+         if (!p->changed)
+         {
+            --rs->pending;
+         }
+         return SIPREC_SUCCESS;
+      }
+
+      // came back with other details; write it again instead of the removal
+      char *new_aor = su_strdup(rs->home, aor);
+      char *new_name = name ? su_strdup(rs->home, name) : NULL;
+      if (!new_aor || (name && !new_name))
+      {
+         SSCError("%s: alloc fail - participant '%s'", __func__, participant_id);
+         su_free(rs->home, new_aor);
+         su_free(rs->home, new_name);
+         return SIPREC_FAILURE;
+      }
+
+      su_free(rs->home, p->aor);
+      su_free(rs->home, p->name);
+      p->aor = new_aor;
+      p->name = new_name;
+      p->state = SIPREC_CHANGED;
+      p->changed = 1;
+      return SIPREC_SUCCESS;
+   }
+
+   if (rs->part_count == rs->part_size &&
+       priv_siprec_grow(rs, (void **)&rs->part, &rs->part_size, sizeof(ssc_siprec_part_t)) != SIPREC_SUCCESS)
+   {
+      return SIPREC_FAILURE;
+   }
+
+   ssc_siprec_part_t *p = &rs->part[rs->part_count];
+   p->id = su_strdup(rs->home, participant_id);
+   p->aor = su_strdup(rs->home, aor);
+   p->name = name ? su_strdup(rs->home, name) : NULL;
+   p->state = SIPREC_ADDED;
+   p->changed = 0;
+
+   if (!p->id || !p->aor || (name && !p->name))
+   {
+      SSCError("%s: alloc fail - participant '%s'", __func__, participant_id);
+      su_free(rs->home, p->id);
+      su_free(rs->home, p->aor);
+      su_free(rs->home, p->name);
+      return SIPREC_FAILURE;
+   }
+
+   ++rs->part_count;
+   ++rs->pending;
+
+   return SIPREC_SUCCESS;
+}
+
+int ssc_siprec_remove_participant(ssc_siprec_t *rs, const char *participant_id)
+{
+   if (!rs || !participant_id)
+   {
+      SSCError("%s: NULL session or participant id", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   int i = priv_siprec_find_part(rs, participant_id);
+   if (i < 0 || rs->part[i].state == SIPREC_REMOVED)
+   {
+      SSCError("%s: unknown participant '%s'", __func__, participant_id);
+      return SIPREC_FAILURE;
+   }
+
+   if (rs->part[i].state == SIPREC_ADDED)
+   {
+      // never written; just forget it
+      ssc_siprec_part_t *p = &rs->part[i];
+      su_free(rs->home, p->id);
+      su_free(rs->home, p->aor);
+      su_free(rs->home, p->name);
+      *p = rs->part[--rs->part_count];
+      --rs->pending;
+      return SIPREC_SUCCESS;
+   }
+
+   if (rs->part[i].state == SIPREC_ACTIVE)
+   {
+      ++rs->pending;
+   }
+   rs->part[i].state = SIPREC_REMOVED;
+
+   return SIPREC_SUCCESS;
+}
+
+int ssc_siprec_add_stream(ssc_siprec_t *rs, const char *stream_id,
+      const char *label, const char *sender_id)
+{
+   if (!rs || !stream_id || !label)
+   {
+      SSCError("%s: NULL session, stream id or label", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   int i = priv_siprec_find_stream(rs, stream_id);
+   if (i >= 0)
+   {
+      ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state != SIPREC_REMOVED)
+      {
+         SSCError("%s: stream '%s' already present", __func__, stream_id);
+         return SIPREC_FAILURE;
+      }
+
+      if (strcmp(s->label, label) == 0 && priv_siprec_str_eq(s->sender, sender_id))
+      {
+         // removed and added back before an update went out; the removal is void
+         s->state = s->changed ? SIPREC_CHANGED : SIPREC_ACTIVE;
+         if (!s->changed)
+         {
+            --rs->pending;
+         }
+         return SIPREC_SUCCESS;
+      }
+
+      // came back with other details; write it again instead of the removal
+      char *new_label = su_strdup(rs->home, label);
+      char *new_sender = sender_id ? su_strdup(rs->home, sender_id) : NULL;
+      if (!new_label || (sender_id && !new_sender))
+      {
+         SSCError("%s: alloc fail - stream '%s'", __func__, stream_id);
+         su_free(rs->home, new_label);
+         su_free(rs->home, new_sender);
+         return SIPREC_FAILURE;
+      }
+
+      // keep the written sender so its stream set gets rewritten as well
+      if (s->changed)
+      {
+         su_free(rs->home, s->sender);
+      }
+      else
+      {
+         s->prev_sender = s->sender;
+      }
+
+      su_free(rs->home, s->label);
+      s->label = new_label;
+      s->sender = new_sender;
+      s->state = SIPREC_CHANGED;
+      s->changed = 1;
+      return SIPREC_SUCCESS;
+   }
+
+   if (rs->stream_count == rs->stream_size &&
+       priv_siprec_grow(rs, (void **)&rs->stream, &rs->stream_size, sizeof(ssc_siprec_stream_t)) != SIPREC_SUCCESS)
+   {
+      return SIPREC_FAILURE;
+   }
+
+   ssc_siprec_stream_t *s = &rs->stream[rs->stream_count];
+   s->id = su_strdup(rs->home, stream_id);
+   s->label = su_strdup(rs->home, label);
+   s->sender = sender_id ? su_strdup(rs->home, sender_id) : NULL;
+   s->prev_sender = NULL;
+   s->state = SIPREC_ADDED;
+   s->changed = 0;
+
+   if (!s->id || !s->label || (sender_id && !s->sender))
+   {
+      SSCError("%s: alloc fail - stream '%s'", __func__, stream_id);
+      su_free(rs->home, s->id);
+      su_free(rs->home, s->label);
+      su_free(rs->home, s->sender);
+      return SIPREC_FAILURE;
+   }
+
+   ++rs->stream_count;
+   ++rs->pending;
+
+   return SIPREC_SUCCESS;
+}
+
+int ssc_siprec_remove_stream(ssc_siprec_t *rs, const char *stream_id)
+{
+   if (!rs || !stream_id)
+   {
+      SSCError("%s: NULL session or stream id", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   int i = priv_siprec_find_stream(rs, stream_id);
+   if (i < 0 || rs->stream[i].state == SIPREC_REMOVED)
+   {
+      SSCError("%s: unknown stream '%s'", __func__, stream_id);
+      return SIPREC_FAILURE;
+   }
+
+   if (rs->stream[i].state == SIPREC_ADDED)
+   {
+      // never written; just forget it
+      ssc_siprec_stream_t *s = &rs->stream[i];
+      su_free(rs->home, s->id);
+      su_free(rs->home, s->label);
+      su_free(rs->home, s->sender);
+      *s = rs->stream[--rs->stream_count];
+      --rs->pending;
+      return SIPREC_SUCCESS;
+   }
+
+   if (rs->stream[i].state == SIPREC_ACTIVE)
+   {
+      ++rs->pending;
+   }
+   rs->stream[i].state = SIPREC_REMOVED;
+
+   return SIPREC_SUCCESS;
+}
+
+unsigned ssc_siprec_pending(const ssc_siprec_t *rs)
+{
+   return rs ? rs->pending : 0;
+}
+
+int ssc_siprec_write_complete(ssc_siprec_t *rs, ssc_mime_t *mime)
+{
+   if (!rs || !mime)
+   {
+      SSCError("%s: NULL session or mime writer", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   if (priv_siprec_write_complete(rs, mime) != SIPREC_SUCCESS)
+   {
+      return SIPREC_FAILURE;
+   }
+
+   priv_siprec_commit(rs);
+
+   return SIPREC_SUCCESS;
+}
+
+int ssc_siprec_write_update(ssc_siprec_t *rs, ssc_mime_t *mime)
+{
+   if (!rs || !mime)
+   {
+      SSCError("%s: NULL session or mime writer", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   if (priv_siprec_write_update(rs, mime) != SIPREC_SUCCESS)
+   {
+      return SIPREC_FAILURE;
+   }
+
+   priv_siprec_commit(rs);
+
+   return SIPREC_SUCCESS;
+}
+
+ssc_siprec_body_t *ssc_siprec_encode(ssc_siprec_t *rs, const char *sdp, size_t sdp_len, int update)
+{
+   if (!rs || !sdp)
+   {
+      SSCError("%s: NULL session or sdp", __func__);
+      return NULL;
+   }
+
+   return priv_siprec_encode(rs, sdp, sdp_len, update, 1);
+}
+
+ssc_siprec_body_t *ssc_siprec_body_ref(ssc_siprec_body_t *body)
+{
+   if (!body) { return NULL; }
+
+   su_home_ref(body->home);
+
+   return body;
+}
+
+void ssc_siprec_body_unref(ssc_siprec_body_t *body)
+{
+   if (!body) { return; }
+
+   su_home_unref(body->home);
+}
+
+sip_payload_t *ssc_siprec_body_payload(ssc_siprec_body_t *body)
+{
+   return body ? body->pl : NULL;
+}
+
+sip_content_type_t *ssc_siprec_body_content_type(ssc_siprec_body_t *body)
+{
+   return body ? body->ct : NULL;
+}
+
+unsigned ssc_siprec_start(ssc_t *ssc, ssc_siprec_t *rs, const ssc_profile_t *profile,
+      const char *const srs[], unsigned n, ssc_siprec_body_t *body, ssc_oper_t *ops[])
+{
+   ssc_req_t req;
+   unsigned i, sent = 0;
+
+   if (!ssc || !rs || !profile || !srs || !body)
+   {
+      SSCError("%s: NULL ssc, session, profile, srs or body", __func__);
+      return 0;
+   }
+
+   if (!rs->legs)
+   {
+      rs->legs = ssc_group_create(ssc, n);
+      if (!rs->legs)
+      {
+         return 0;
+      }
+      ssc_group_set_state_cb(rs->legs, priv_siprec_leg_state, rs);
+   }
+
+   // hold on to the body the legs were started with
+   ssc_siprec_body_ref(body);
+   ssc_siprec_body_unref(rs->body);
+   rs->body = body;
+
+   ssc_req_init(&req, profile);
+   req.payload = body->pl;
+   req.contentType = body->ct;
+
+   for (i=0; i<n; ++i)
+   {
+      ssc_oper_t *op = NULL;
+
+      if (srs[i] && ssc_req_set(&req, SSC_F_TO_URI, srs[i]) == SSC_REQ_SUCCESS)
+      {
+         op = ssc_invite_req(ssc, &req);
+      }
+
+      if (op && ssc_group_add(rs->legs, op) == GRP_SUCCESS)
+      {
+         ssc_group_set_mark(rs->legs, op, body->gen);
+         ++sent;
+      }
+      else
+      {
+         SSCError("%s: failed to start recording leg to '%s'", __func__, srs[i] ? srs[i] : "<nil>");
+      }
+
+      if (ops)
+      {
+         ops[i] = op;
+      }
+   }
+
+   return sent;
+}
+
+int ssc_siprec_update(ssc_siprec_t *rs, const char *sdp, size_t sdp_len)
+{
+   ssc_siprec_body_t *body = NULL;
+   unsigned i, n, sent = 0;
+
+   if (!rs || !sdp || !rs->legs)
+   {
+      SSCError("%s: NULL session or sdp, or no recording legs", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   // legs at this gen can take the partial document
+   unsigned long prev = rs->gen;
+
+   if (rs->pending)
+   {
+      body = priv_siprec_encode(rs, sdp, sdp_len, 1, 1);
+      if (!body)
+      {
+         return SIPREC_FAILURE;
+      }
+
+      ssc_siprec_body_unref(rs->body);
+      rs->body = body;
+   }
+
+   n = ssc_group_size(rs->legs);
+   for (i=0; i<n; ++i)
+   {
+      ssc_oper_t *op = ssc_group_get_op(rs->legs, i);
+
+      // a leg still being set up or in a re-INVITE catches up once ready
+      if (!priv_siprec_is_established(op))
+      {
+         continue;
+      }
+
+      unsigned long mark = ssc_group_get_mark(rs->legs, op);
+      if (body && mark == prev)
+      {
+         sent += priv_siprec_send(rs, op, body) == SIPREC_SUCCESS;
+      }
+      else if (mark != rs->gen)
+      {
+         sent += priv_siprec_catch_up(rs, op, sdp, sdp_len) == SIPREC_SUCCESS;
+      }
+   }
+
+   return (int)sent;
+}
+
+int ssc_siprec_stop(ssc_siprec_t *rs, ssc_group_done_cb cb, void *context)
+{
+   if (!rs || !rs->legs)
+   {
+      SSCError("%s: NULL session or no recording legs", __func__);
+      return SIPREC_FAILURE;
+   }
+
+   return ssc_group_bye(rs->legs, cb, context);
+}
+
+
+/** internal functions follow **/
+
+// @p commit clears the pending changes once the body is built; without it
+// the body is a one-off (a catch-up) and the session is left as it is
+ssc_siprec_body_t *priv_siprec_encode(ssc_siprec_t *rs, const char *sdp, size_t sdp_len,
+      int update, int commit)
+{
+   ssc_mime_t mime;
+
+   ssc_siprec_body_t *body = (ssc_siprec_body_t *)su_home_new(sizeof(ssc_siprec_body_t));
+   if (!body)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(ssc_siprec_body_t));
+      return NULL;
+   }
+
+   body->ct = ssc_mime_content_type(body->home, &rs->boundary);
+   body->sdp = su_strndup(body->home, sdp, sdp_len);
+   body->sdp_len = sdp_len;
+
+   // written once, straight into the body's own buffer
+   ssc_mime_init(&mime, body->home, &rs->boundary, NULL, 0);
+   ssc_mime_reserve(&mime, ssc_mime_part_size(&rs->boundary, "application/sdp", sdp_len) + 4096);
+   ssc_mime_part(&mime, "application/sdp", sdp, sdp_len);
+
+   int rc = update ? priv_siprec_write_update(rs, &mime) : priv_siprec_write_complete(rs, &mime);
+
+   if (!body->ct || !body->sdp || rc != SIPREC_SUCCESS || ssc_mime_finish(&mime, body->pl) != MIME_SUCCESS)
+   {
+      // nothing is committed, the changes go out with the next body
+      SSCError("%s: failed to encode body", __func__);
+      su_home_unref(body->home);
+      return NULL;
+   }
+
+   if (commit)
+   {
+      priv_siprec_commit(rs);
+   }
+   body->gen = rs->gen;
+
+   return body;
+}
+
+// send @p body as a re-INVITE on @p op and mark the leg with its gen
+int priv_siprec_send(ssc_siprec_t *rs, ssc_oper_t *op, ssc_siprec_body_t *body)
+{
+   ssc_metrics_request(SSC_METRICS_TX, sip_method_invite);
+   nua_invite(op->op_handle,
+         SIPTAG_CONTENT_TYPE(body->ct),
+         SIPTAG_PAYLOAD(body->pl),
+         TAG_END());
+
+   return ssc_group_set_mark(rs->legs, op, body->gen) == GRP_SUCCESS ? SIPREC_SUCCESS : SIPREC_FAILURE;
+}
+
+// bring a leg that missed updates up to date with a complete document
+int priv_siprec_catch_up(ssc_siprec_t *rs, ssc_oper_t *op, const char *sdp, size_t sdp_len)
+{
+   ssc_siprec_body_t *body = priv_siprec_encode(rs, sdp, sdp_len, 0, 0);
+   if (!body)
+   {
+      return SIPREC_FAILURE;
+   }
+
+   SSCDebugMed("%s: %s: recorder %s is behind, sending complete metadata",
+         __func__, rs->session_id, ssc_oper_ident(op));
+
+   int rc = priv_siprec_send(rs, op, body);
+
+   // nua copied the body into the request
+   ssc_siprec_body_unref(body);
+
+   return rc;
+}
+
+void priv_siprec_leg_state(ssc_group_t *group, ssc_oper_t *op, int state, int status, void *context)
+{
+   ssc_siprec_t *rs = (ssc_siprec_t *)context;
+
+   if (state != nua_callstate_ready)
+   {
+      return;
+   }
+
+   if (status >= 300)
+   {
+      // our re-INVITE was turned down; resend with the next update rather
+      // than straight away, which could just be turned down again (491)
+      ssc_group_set_mark(group, op, SIPREC_LEG_STALE);
+      return;
+   }
+
+   if (ssc_group_get_mark(group, op) != rs->gen && rs->body)
+   {
+      priv_siprec_catch_up(rs, op, rs->body->sdp, rs->body->sdp_len);
+   }
+}
+
+int priv_siprec_write_complete(ssc_siprec_t *rs, ssc_mime_t *mime)
+{
+   ssc_rsmeta_t md;
+   unsigned i;
+
+   ssc_rsmeta_begin(&md, mime, SSC_RSMETA_COMPLETE, rs->session_id, rs->sip_session_id);
+
+   for (i=0; i<rs->part_count; ++i)
+   {
+      const ssc_siprec_part_t *p = &rs->part[i];
+      if (p->state != SIPREC_REMOVED)
+      {
+         ssc_rsmeta_participant(&md, p->id, p->aor, p->name);
+      }
+   }
+
+   for (i=0; i<rs->stream_count; ++i)
+   {
+      const ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state != SIPREC_REMOVED)
+      {
+         ssc_rsmeta_stream(&md, s->id, s->label, s->sender);
+      }
+   }
+
+   return ssc_rsmeta_end(&md) == RSMETA_SUCCESS ? SIPREC_SUCCESS : SIPREC_FAILURE;
+}
+
+int priv_siprec_write_update(ssc_siprec_t *rs, ssc_mime_t *mime)
+{
+   ssc_rsmeta_t md;
+   unsigned i;
+
+   if (!priv_siprec_partial_ok(rs))
+   {
+      SSCDebugMed("%s: %s: change not expressible as partial metadata, writing complete",
+            __func__, rs->session_id);
+      return priv_siprec_write_complete(rs, mime);
+   }
+
+   ssc_rsmeta_begin(&md, mime, SSC_RSMETA_PARTIAL, rs->session_id, rs->sip_session_id);
+
+   for (i=0; i<rs->part_count; ++i)
+   {
+      const ssc_siprec_part_t *p = &rs->part[i];
+      if (p->state == SIPREC_ADDED || p->state == SIPREC_CHANGED)
+      {
+         ssc_rsmeta_participant(&md, p->id, p->aor, p->name);
+      }
+   }
+
+   for (i=0; i<rs->stream_count; ++i)
+   {
+      const ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state == SIPREC_ADDED || s->state == SIPREC_CHANGED)
+      {
+         ssc_rsmeta_stream(&md, s->id, s->label, NULL);
+      }
+   }
+
+   // rewrite the stream set of every sender whose streams changed, once;
+   // a stream that moved to another sender changes both sets
+   for (i=0; i<rs->stream_count; ++i)
+   {
+      const ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state == SIPREC_ACTIVE)
+      {
+         continue;
+      }
+
+      if (s->sender && !priv_siprec_sender_seen(rs, i, s->sender))
+      {
+         priv_siprec_sender_assoc(rs, &md, s->sender);
+      }
+
+      if (s->prev_sender && !priv_siprec_str_eq(s->prev_sender, s->sender) &&
+          !priv_siprec_sender_seen(rs, i, s->prev_sender))
+      {
+         priv_siprec_sender_assoc(rs, &md, s->prev_sender);
+      }
+   }
+
+   for (i=0; i<rs->part_count; ++i)
+   {
+      const ssc_siprec_part_t *p = &rs->part[i];
+      if (p->state == SIPREC_REMOVED)
+      {
+         ssc_rsmeta_participant_leave(&md, p->id, 0);
+      }
+   }
+
+   return ssc_rsmeta_end(&md) == RSMETA_SUCCESS ? SIPREC_SUCCESS : SIPREC_FAILURE;
+}
+
+
+// partial metadata can only drop a stream by rewriting its sender's stream
+// set, so removing a stream that has (and had) no sender needs a complete
+// document
+int priv_siprec_partial_ok(const ssc_siprec_t *rs)
+{
+   unsigned i;
+   for (i=0; i<rs->stream_count; ++i)
+   {
+      const ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state == SIPREC_REMOVED && !s->sender && !s->prev_sender)
+      {
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+int priv_siprec_find_part(const ssc_siprec_t *rs, const char *id)
+{
+   unsigned i;
+   for (i=0; i<rs->part_count; ++i)
+   {
+      if (strcmp(rs->part[i].id, id) == 0)
+      {
+         return (int)i;
+      }
+   }
+
+   return -1;
+}
+
+int priv_siprec_find_stream(const ssc_siprec_t *rs, const char *id)
+{
+   unsigned i;
+   for (i=0; i<rs->stream_count; ++i)
+   {
+      if (strcmp(rs->stream[i].id, id) == 0)
+      {
+         return (int)i;
+      }
+   }
+
+   return -1;
+}
+
+int priv_siprec_str_eq(const char *a, const char *b)
+{
+   return (!a && !b) || (a && b && strcmp(a, b) == 0);
+}
+
+int priv_siprec_grow(ssc_siprec_t *rs, void **array, unsigned *size, size_t item)
+{
+   unsigned n = *size ? *size * 2 : SIPREC_INITIAL_ITEMS;
+
+   void *a = su_realloc(rs->home, *array, n * item);
+   if (!a)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, n * item);
+      return SIPREC_FAILURE;
+   }
+
+   *array = a;
+   *size = n;
+
+   return SIPREC_SUCCESS;
+}
+
+// true if a changed stream before @p upto already has @p sender as its
+// current or last written sender, so its stream set is being rewritten
+int priv_siprec_sender_seen(const ssc_siprec_t *rs, unsigned upto, const char *sender)
+{
+   unsigned i;
+   for (i=0; i<upto; ++i)
+   {
+      const ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state != SIPREC_ACTIVE &&
+          ((s->sender && strcmp(s->sender, sender) == 0) ||
+           (s->prev_sender && strcmp(s->prev_sender, sender) == 0)))
+      {
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+void priv_siprec_sender_assoc(ssc_siprec_t *rs, ssc_rsmeta_t *md, const char *sender)
+{
+   unsigned i;
+
+   ssc_rsmeta_stream_assoc_begin(md, sender);
+
+   for (i=0; i<rs->stream_count; ++i)
+   {
+      const ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state != SIPREC_REMOVED && s->sender && strcmp(s->sender, sender) == 0)
+      {
+         ssc_rsmeta_stream_assoc_send(md, s->id);
+      }
+   }
+
+   ssc_rsmeta_stream_assoc_end(md);
+}
+
+void priv_siprec_commit(ssc_siprec_t *rs)
+{
+   unsigned i;
+
+   // drop removed entries; everything left is now written
+   for (i=0; i<rs->part_count; )
+   {
+      ssc_siprec_part_t *p = &rs->part[i];
+      if (p->state == SIPREC_REMOVED)
+      {
+         su_free(rs->home, p->id);
+         su_free(rs->home, p->aor);
+         su_free(rs->home, p->name);
+         *p = rs->part[--rs->part_count];
+         continue;
+      }
+
+      p->state = SIPREC_ACTIVE;
+      p->changed = 0;
+      ++i;
+   }
+
+   for (i=0; i<rs->stream_count; )
+   {
+      ssc_siprec_stream_t *s = &rs->stream[i];
+      if (s->state == SIPREC_REMOVED)
+      {
+         su_free(rs->home, s->id);
+         su_free(rs->home, s->label);
+         su_free(rs->home, s->sender);
+         su_free(rs->home, s->prev_sender);
+         *s = rs->stream[--rs->stream_count];
+         continue;
+      }
+
+      su_free(rs->home, s->prev_sender);
+      s->prev_sender = NULL;
+      s->state = SIPREC_ACTIVE;
+      s->changed = 0;
+      ++i;
+   }
+
+   rs->pending = 0;
+   ++rs->gen;
+   if (rs->gen == SIPREC_LEG_STALE)
+   {
+      ++rs->gen;
+   }
+}
+
+int priv_siprec_is_established(const ssc_oper_t *op)
+{
+   // a re-INVITE needs a confirmed dialog with no INVITE in progress
+   return op && op->op_handle && op->op_prev_state == nua_callstate_ready;
+}
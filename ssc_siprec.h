@@ -0,0 +1,184 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// tracks the SIPREC metadata state of one recording session so updates
+/// can be sent as partial metadata (RFC 7865 datamode "partial") that only
+/// carries what changed since the last document, instead of re-sending
+/// the whole receiver list each time a participant joins or leaves.
+///
+/// participants and streams are added and removed on the session as the
+/// call changes.  ssc_siprec_write_complete() writes the full current
+/// state (used for the initial INVITE); ssc_siprec_write_update() writes
+/// only the pending changes (used for re-INVITEs).  both clear the pending
+/// change set, but only once the document was written successfully.
+///
+/// the session can also run the recording legs: ssc_siprec_encode()
+/// builds the SDP + metadata multipart body once into a reference counted
+/// object, ssc_siprec_start() sends that same body to every recorder (SRS)
+/// and keeps the legs in one op group, ssc_siprec_update() sends the
+/// pending changes to all of them in one re-INVITE each, and
+/// ssc_siprec_stop() tears all of them down together.
+///
+/// the session tracks which metadata each leg was last sent.  a leg that
+/// misses an update (its INVITE was not answered yet, or it was in the
+/// middle of a re-INVITE) is sent the complete document as soon as it is
+/// established again.
+
+#include "ssc_sip.h"
+#include "ssc_group.h"
+#include "ssc_mime.h"
+#include "ssc_rsmeta.h"
+
+/// some simple return codes
+#define SIPREC_SUCCESS   0
+#define SIPREC_FAILURE  -1
+
+typedef struct ssc_siprec_s ssc_siprec_t;
+
+/// encoded SIPREC body, shared by reference between recorder legs.
+typedef struct ssc_siprec_body_s ssc_siprec_body_t;
+
+/// create a recording session.
+///
+/// @param[in]  session_id      recording session id
+/// @param[in]  sip_session_id  [optional] Session-ID of the recorded call
+///
+/// @return new session, or NULL on failure.
+ssc_siprec_t *ssc_siprec_create(const char *session_id, const char *sip_session_id);
+
+/// release a recording session.  recorder legs still running are detached
+/// from the session but not torn down.
+void ssc_siprec_destroy(ssc_siprec_t *rs);
+
+/// add a participant.  the strings are copied.  adding back a participant
+/// removed since the last write cancels the removal if the details are
+/// the same, otherwise the new details are written with the next update.
+///
+/// @return SIPREC_SUCCESS, or SIPREC_FAILURE on bad args, alloc failure or
+///         if the participant is already present.
+int ssc_siprec_add_participant(ssc_siprec_t *rs, const char *participant_id,
+      const char *aor, const char *name);
+
+/// remove a participant.  its streams are not removed.
+///
+/// @return SIPREC_SUCCESS, or SIPREC_FAILURE if the participant is unknown.
+int ssc_siprec_remove_participant(ssc_siprec_t *rs, const char *participant_id);
+
+/// add a stream.  the strings are copied.  adding back a stream removed
+/// since the last write cancels the removal if the label and sender are
+/// the same, otherwise the new details (and the stream sets of both the
+/// old and the new sender) are written with the next update.
+///
+/// @param[in]  sender_id   [optional] participant id of the sender
+///
+/// @return SIPREC_SUCCESS, or SIPREC_FAILURE on bad args, alloc failure or
+///         if the stream is already present.
+int ssc_siprec_add_stream(ssc_siprec_t *rs, const char *stream_id,
+      const char *label, const char *sender_id);
+
+/// remove a stream.
+///
+/// @return SIPREC_SUCCESS, or SIPREC_FAILURE if the stream is unknown.
+int ssc_siprec_remove_stream(ssc_siprec_t *rs, const char *stream_id);
+
+/// returns the number of changes not yet written.
+unsigned ssc_siprec_pending(const ssc_siprec_t *rs);
+
+/// write the full metadata document as a part of @p mime.  the pending
+/// changes are kept on failure.
+///
+/// @return SIPREC_SUCCESS, or SIPREC_FAILURE on write failure.
+int ssc_siprec_write_complete(ssc_siprec_t *rs, ssc_mime_t *mime);
+
+/// write a partial metadata document with only the changes made since the
+/// last write as a part of @p mime.  if a pending change cannot be told as
+/// partial metadata (a stream without a sender was removed) the complete
+/// document is written instead.  the pending changes are kept on failure.
+///
+/// @return SIPREC_SUCCESS, or SIPREC_FAILURE on write failure.
+int ssc_siprec_write_update(ssc_siprec_t *rs, ssc_mime_t *mime);
+
+/// encode the SDP and the metadata into one multipart body.  the
+/// metadata is written as ssc_siprec_write_complete() or, if @p update is
+/// set, ssc_siprec_write_update() would write it.  the pending changes
+/// are only cleared once the whole body was built.
+///
+/// @param[in]  rs       recording session
+/// @param[in]  sdp      SDP part body
+/// @param[in]  sdp_len  length of @p sdp
+/// @param[in]  update   write partial instead of complete metadata
+///
+/// @return new body holding one reference, or NULL on failure.
+ssc_siprec_body_t *ssc_siprec_encode(ssc_siprec_t *rs, const char *sdp, size_t sdp_len, int update);
+
+/// add a reference to a body.
+ssc_siprec_body_t *ssc_siprec_body_ref(ssc_siprec_body_t *body);
+
+/// drop a reference to a body; it is freed with the last one.
+void ssc_siprec_body_unref(ssc_siprec_body_t *body);
+
+/// returns the encoded body.  valid while a reference is held.
+sip_payload_t *ssc_siprec_body_payload(ssc_siprec_body_t *body);
+
+/// returns the multipart Content-Type of the body.  valid while a
+/// reference is held.
+sip_content_type_t *ssc_siprec_body_content_type(ssc_siprec_body_t *body);
+
+/// send an INVITE carrying @p body to each recorder.  the legs are added
+/// to the session's op group and the session keeps a reference to the
+/// body for as long as it lives (or until the next start).
+///
+/// @param[in]  ssc      ptr to SSC context to use
+/// @param[in]  rs       recording session
+/// @param[in]  profile  profile of the recording legs (From, Contact, ...)
+/// @param[in]  srs      To: URI of each recorder
+/// @param[in]  n        number of entries in @p srs
+/// @param[in]  body     body from ssc_siprec_encode()
+/// @param[out] ops      [optional] receives the operation of each leg
+///                      (n entries, NULL for legs that failed)
+///
+/// @return number of legs sent.
+unsigned ssc_siprec_start(ssc_t *ssc, ssc_siprec_t *rs, const ssc_profile_t *profile,
+      const char *const srs[], unsigned n, ssc_siprec_body_t *body, ssc_oper_t *ops[]);
+
+/// send the changes made since the last body to every established
+/// recorder leg: the SDP and a partial metadata document are encoded once
+/// and sent as a re-INVITE on each leg that has seen the previous
+/// document.  legs that are behind get the complete document instead.
+/// legs that are not established (INVITE unanswered, re-INVITE in
+/// progress) are skipped and sent the complete document once they are.
+/// with no pending changes only legs that are behind are sent anything.
+///
+/// @param[in]  rs       recording session
+/// @param[in]  sdp      SDP part body
+/// @param[in]  sdp_len  length of @p sdp
+///
+/// @return number of legs a re-INVITE was sent on, or SIPREC_FAILURE on
+///         bad args, if the session has no legs or if encoding failed.
+int ssc_siprec_update(ssc_siprec_t *rs, const char *sdp, size_t sdp_len);
+
+/// tear down every recorder leg of the session, see ssc_group_bye().
+///
+/// @return number of legs a request was sent on, or SIPREC_FAILURE.
+int ssc_siprec_stop(ssc_siprec_t *rs, ssc_group_done_cb cb, void *context);
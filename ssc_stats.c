@@ -0,0 +1,131 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_stats.h"
+
+#include <string.h>
+#include <time.h>
+
+static unsigned priv_hist_index(uint64_t v);
+static uint64_t priv_hist_bucket_mid(unsigned idx);
+
+uint64_t ssc_clock_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+uint64_t ssc_clock_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void ssc_hist_reset(ssc_hist_t *h)
+{
+   if (!h) { return; }
+
+   memset(h, 0, sizeof(*h));
+}
+
+void ssc_hist_record(ssc_hist_t *h, uint64_t v)
+{
+   if (!h) { return; }
+
+   if (h->count == 0 || v < h->min) { h->min = v; }
+   if (v > h->max) { h->max = v; }
+
+   ++h->count;
+   h->sum += v;
+   ++h->bucket[priv_hist_index(v)];
+}
+
+uint64_t ssc_hist_percentile(const ssc_hist_t *h, double pct)
+{
+   if (!h || h->count == 0) { return 0; }
+
+   if (pct <= 0.0) { return h->min; }
+   if (pct >= 100.0) { return h->max; }
+
+   uint64_t rank = (uint64_t)((pct / 100.0) * (double)h->count + 0.5);
+   if (rank == 0) { rank = 1; }
+
+   uint64_t seen = 0;
+   unsigned i;
+   for (i=0; i<SSC_HIST_BUCKETS; ++i)
+   {
+      seen += h->bucket[i];
+      if (seen >= rank)
+      {
+         uint64_t v = priv_hist_bucket_mid(i);
+         if (v < h->min) { v = h->min; }
+         if (v > h->max) { v = h->max; }
+         return v;
+      }
+   }
+
+   return h->max;
+}
+
+uint64_t ssc_hist_mean(const ssc_hist_t *h)
+{
+   if (!h || h->count == 0) { return 0; }
+
+   return h->sum / h->count;
+}
+
+
+/** internal functions follow **/
+
+// values below SSC_HIST_SUB_BUCKETS get a bucket each; above that, the
+// bucket is picked by the position of the top bit and the next
+// SSC_HIST_SUB_BITS bits below it.
+unsigned priv_hist_index(uint64_t v)
+{
+   if (v < SSC_HIST_SUB_BUCKETS)
+   {
+      return (unsigned)v;
+   }
+
+   unsigned msb = 63 - (unsigned)__builtin_clzll(v);
+   unsigned shift = msb - SSC_HIST_SUB_BITS;
+   unsigned sub = (unsigned)(v >> shift) & (SSC_HIST_SUB_BUCKETS - 1);
+
+   return (shift + 1) * SSC_HIST_SUB_BUCKETS + sub;
+}
+
+uint64_t priv_hist_bucket_mid(unsigned idx)
+{
+   if (idx < SSC_HIST_SUB_BUCKETS)
+   {
+      return idx;
+   }
+
+   unsigned shift = idx / SSC_HIST_SUB_BUCKETS - 1;
+   uint64_t sub = idx % SSC_HIST_SUB_BUCKETS;
+   uint64_t low = (SSC_HIST_SUB_BUCKETS + sub) << shift;
+
+   return low + ((1ull << shift) >> 1);
+}
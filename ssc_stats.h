@@ -0,0 +1,80 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// provides a small log-linear histogram used to collect latency
+/// distributions inside the library, plus the monotonic clock the
+/// measurements are taken with.
+///
+/// each power of two is split into SSC_HIST_SUB_BUCKETS linear buckets, so
+/// the relative error of a reported value is bounded by 1/SSC_HIST_SUB_BUCKETS
+/// regardless of magnitude.  recording is a couple of integer ops and an
+/// increment; no allocation is ever done.
+
+#include <stdint.h>
+
+/// number of linear sub-buckets per power of two
+#define SSC_HIST_SUB_BITS    3
+#define SSC_HIST_SUB_BUCKETS (1u << SSC_HIST_SUB_BITS)
+
+/// total bucket count needed to cover the full uint64_t range
+#define SSC_HIST_BUCKETS     ((64 - SSC_HIST_SUB_BITS + 1) * SSC_HIST_SUB_BUCKETS)
+
+typedef struct ssc_hist_s
+{
+   uint64_t count;   // number of recorded samples
+   uint64_t sum;     // sum of recorded samples
+   uint64_t min;     // smallest recorded sample (valid when count > 0)
+   uint64_t max;     // largest recorded sample
+   uint32_t bucket[SSC_HIST_BUCKETS];
+} ssc_hist_t;
+
+/// returns the current CLOCK_MONOTONIC time in microseconds.
+uint64_t ssc_clock_us(void);
+
+/// returns the current CLOCK_MONOTONIC time in nanoseconds.
+uint64_t ssc_clock_ns(void);
+
+/// clear all samples from a histogram.
+///
+/// @param[in]  h    histogram to clear
+void ssc_hist_reset(ssc_hist_t *h);
+
+/// add a sample to a histogram.
+///
+/// @param[in]  h    histogram to update
+/// @param[in]  v    sample value
+void ssc_hist_record(ssc_hist_t *h, uint64_t v);
+
+/// estimate a percentile of the recorded samples.
+///
+/// @param[in]  h    histogram to query
+/// @param[in]  pct  percentile in the range 0.0 - 100.0
+///
+/// @return estimated sample value, or 0 if the histogram is empty.
+uint64_t ssc_hist_percentile(const ssc_hist_t *h, double pct);
+
+/// returns the mean of the recorded samples, or 0 if the histogram is empty.
+///
+/// @param[in]  h    histogram to query
+uint64_t ssc_hist_mean(const ssc_hist_t *h);
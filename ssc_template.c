@@ -0,0 +1,195 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ssc_template.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sofia-sip/sip_header.h>
+
+#include "ssc_log.h"
+#include "ssc_sip.h"
+
+#define PRIV_TMPL_CONTACT_SIZE 1024
+
+static void priv_tmpl_destructor(void *arg);
+static void *priv_tmpl_parse(const char *name, const char *str, void *hdr);
+
+ssc_template_t *ssc_template_compile(ssc_t *ssc, const ssc_config_t *config)
+{
+   if (!ssc || !config)
+   {
+      SSCError("%s: NULL ptr arg", __func__);
+      return NULL;
+   }
+
+   ssc_template_t *tmpl = su_home_new(sizeof(*tmpl));
+   if (!tmpl)
+   {
+      SSCError("%s: alloc fail - %zu bytes", __func__, sizeof(*tmpl));
+      return NULL;
+   }
+
+   tmpl->profile = ssc_profile_create(config);
+   if (!tmpl->profile)
+   {
+      SSCError("%s: failed to create profile", __func__);
+      su_home_unref(tmpl->home);
+      return NULL;
+   }
+
+   su_home_destructor(tmpl->home, priv_tmpl_destructor);
+
+   su_home_t *home = tmpl->home;
+
+   if (config->targetAddress[0] != '\0')
+   {
+      tmpl->proxy = priv_tmpl_parse("proxy", config->targetAddress,
+            url_make(home, config->targetAddress));
+   }
+
+   if (config->fromUri[0] != '\0')
+   {
+      tmpl->from = priv_tmpl_parse("From", config->fromUri,
+            sip_from_make(home, config->fromUri));
+   }
+
+   if (config->accept[0] != '\0')
+   {
+      tmpl->accept = priv_tmpl_parse("Accept", config->accept,
+            sip_accept_make(home, config->accept));
+   }
+
+   if (config->allow[0] != '\0')
+   {
+      tmpl->allow = priv_tmpl_parse("Allow", config->allow,
+            sip_allow_make(home, config->allow));
+   }
+
+   if (config->route[0] != '\0')
+   {
+      tmpl->route = priv_tmpl_parse("Route", config->route,
+            sip_route_make(home, config->route));
+   }
+
+   if (config->require[0] != '\0')
+   {
+      tmpl->require = priv_tmpl_parse("Require", config->require,
+            sip_require_make(home, config->require));
+   }
+
+   if (config->acceptContact[0] != '\0')
+   {
+      tmpl->accept_contact = priv_tmpl_parse("Accept-Contact", config->acceptContact,
+            sip_accept_contact_make(home, config->acceptContact));
+   }
+
+   if (config->priority[0] != '\0')
+   {
+      tmpl->priority = priv_tmpl_parse("Priority", config->priority,
+            sip_priority_make(home, config->priority));
+   }
+
+   if (config->expires[0] != '\0')
+   {
+      tmpl->expires = priv_tmpl_parse("Expires", config->expires,
+            sip_expires_make(home, config->expires));
+   }
+
+   if (config->contentTypeStr[0] != '\0')
+   {
+      tmpl->content_type = priv_tmpl_parse("Content-Type", config->contentTypeStr,
+            sip_content_type_make(home, config->contentTypeStr));
+   }
+
+   // contact is assembled the same way ssc_invite() and ssc_register_op() do
+   char contact[PRIV_TMPL_CONTACT_SIZE];
+   contact[0] = '\0';
+   if (config->postProcessContactUri == 0)
+   {
+      snprintf(contact, sizeof(contact), "%s", config->contactUri);
+   }
+   else if (config->contactUri[0] != '\0')
+   {
+      snprintf(contact, sizeof(contact), "<%s%s>%s",
+            config->contactUri,
+            config->contactUriFeatures,
+            config->contactFeatures);
+   }
+
+   if (contact[0] != '\0')
+   {
+      tmpl->contact = priv_tmpl_parse("Contact", contact,
+            sip_contact_make(home, contact));
+   }
+
+   SSCDebugMed("%s: %s: template <%p> compiled", __func__, ssc->ssc_name, tmpl);
+
+   return tmpl;
+}
+
+ssc_template_t *ssc_template_ref(ssc_template_t *tmpl)
+{
+   if (tmpl)
+   {
+      su_home_ref(tmpl->home);
+   }
+
+   return tmpl;
+}
+
+void ssc_template_unref(ssc_template_t *tmpl)
+{
+   if (tmpl)
+   {
+      su_home_unref(tmpl->home);
+   }
+}
+
+const ssc_profile_t *ssc_template_profile(const ssc_template_t *tmpl)
+{
+   return tmpl ? tmpl->profile : NULL;
+}
+
+
+/** internal functions follow **/
+
+void priv_tmpl_destructor(void *arg)
+{
+   ssc_template_t *tmpl = (ssc_template_t *)arg;
+
+   ssc_profile_unref(tmpl->profile);
+   tmpl->profile = NULL;
+}
+
+void *priv_tmpl_parse(const char *name, const char *str, void *hdr)
+{
+   if (!hdr)
+   {
+      SSCWarning("%s: %s '%s' did not parse; it will be sent as a string",
+            __func__, name, str);
+   }
+
+   return hdr;
+}
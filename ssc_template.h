@@ -0,0 +1,112 @@
+#pragma once
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// provides compiled request templates.  a template is a profile (see
+/// ssc_profile.h) whose static header fields have also been parsed, once,
+/// into sofia header objects kept on the template's own long-lived home.
+///
+/// requests sent from a template hand the parsed headers to the stack
+/// instead of the corresponding SIPTAG_*_STR strings, so only the
+/// per-request deltas (To, Call-ID, body, ...) still need parsing.
+/// a field that the request overrides is sent from the override string
+/// as usual and the parsed header is skipped.
+///
+/// templates are reference counted and read-only once compiled.
+
+#include "ssc_sip.h"
+#include "ssc_profile.h"
+
+#include <sofia-sip/sip.h>
+#include <sofia-sip/su_alloc.h>
+
+typedef struct ssc_template_s
+{
+   su_home_t home[1];         // must be first; the template is its own home
+
+   ssc_profile_t *profile;    // reference held by the template
+
+   // pre-parsed headers; NULL if the field was empty or did not parse
+   url_t *proxy;
+   sip_from_t *from;
+   sip_accept_t *accept;
+   sip_allow_t *allow;
+   sip_route_t *route;
+   sip_require_t *require;
+   sip_accept_contact_t *accept_contact;
+   sip_contact_t *contact;
+   sip_priority_t *priority;
+   sip_expires_t *expires;
+   sip_content_type_t *content_type;
+} ssc_template_t;
+
+/// compile a template from the non-empty fields of a config struct.
+/// fields that fail to parse are logged and left to be sent as strings.
+///
+/// @param[in]  ssc      ptr to SSC context the template will be used with
+/// @param[in]  config   config to compile
+///
+/// @return new template holding one reference, or NULL on failure.
+ssc_template_t *ssc_template_compile(ssc_t *ssc, const ssc_config_t *config);
+
+/// take an additional reference to a template.
+///
+/// @param[in]  tmpl     template to reference
+///
+/// @return @p tmpl
+ssc_template_t *ssc_template_ref(ssc_template_t *tmpl);
+
+/// drop a reference to a template. the template (and its reference on
+/// the underlying profile) is released with the last reference.
+///
+/// @param[in]  tmpl     template to release (NULL is ignored)
+void ssc_template_unref(ssc_template_t *tmpl);
+
+/// returns the profile of a template, to be used with ssc_req_init() for
+/// requests sent from the template.
+///
+/// @param[in]  tmpl     template to query
+const ssc_profile_t *ssc_template_profile(const ssc_template_t *tmpl);
+
+/// send an INVITE from a template.  same as ssc_invite_req() except that
+/// the template's pre-parsed headers are used for every field @p req does
+/// not override.  if @p req has no profile, the template's is used.
+///
+/// @param[in]  ssc      ptr to SSC context to use
+/// @param[in]  tmpl     compiled template
+/// @param[in]  req      per-request deltas (To, Call-ID, body, ...)
+///
+/// @return new operation, or NULL on failure.
+ssc_oper_t *ssc_invite_tmpl(ssc_t *ssc, const ssc_template_t *tmpl, const ssc_req_t *req);
+
+/// send a REGISTER from a template.  same as ssc_register_op_req() except
+/// that the template's pre-parsed headers are used for every field @p req
+/// does not override.  if @p req has no profile, the template's is used.
+///
+/// @param[in]  ssc      ptr to SSC context to use
+/// @param[in]  tmpl     compiled template
+/// @param[in]  req      per-request deltas
+/// @param[in]  op       existing registration operation, or NULL for a new one
+///
+/// @return the operation used, or NULL on failure.
+ssc_oper_t *ssc_register_tmpl(ssc_t *ssc, const ssc_template_t *tmpl, const ssc_req_t *req, ssc_oper_t *op);
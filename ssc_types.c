@@ -75,7 +75,9 @@ void setSscDefaults(ssc_config_t *config)
    config->sdp[0] = '\0';
    config->payload = NULL;
    config->payloadStr[0] = '\0';
+#ifndef SSC_CONFIG_NO_RS_METADATA
    config->rsMetadata[0] = '\0';
+#endif
 
    config->mimeMsgHome = NULL;
 
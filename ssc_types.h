@@ -36,6 +36,8 @@
 #define MAX_SSC_PAYLOAD_STR_SIZE (MAX_SDP_SIZE + 256)
 
 // 157kb: includes 153kb for receiver list participant xml items.
+// new code should stream the metadata with ssc_rsmeta.h instead; define
+// SSC_CONFIG_NO_RS_METADATA to drop the buffer from ssc_config_t.
 #define MAX_RS_METADATA_SIZE 160768
 
 #define MAX_BOUNDARY_SIZE 128
@@ -137,8 +139,10 @@ typedef struct _ssc_config_t
    // ..or use payload specified as a string
    char payloadStr[MAX_SSC_PAYLOAD_STR_SIZE];
 
+#ifndef SSC_CONFIG_NO_RS_METADATA
 	// used in message content creation
    char rsMetadata[MAX_RS_METADATA_SIZE];  
+#endif
 
    // If not NULL then this is holding memory...
    msg_t *mimeMsgHome;
@@ -158,7 +162,12 @@ typedef struct _ssc_config_t
 	uint8_t isFocus;
 	uint8_t sessionType;
 
-   /* multipart content for register */
+   /* multipart content for register, invite and answer. the parts are
+    * built into one body when neither payload nor payloadStr is set. if
+    * no Content-Type is given, a multipart/mixed one carrying the
+    * boundary is added. if sdp is also set, it is sent as the first
+    * part (application/sdp) ahead of the content parts.
+    * (see ssc_mime.h for any number of parts) */
 
    // boundry string to use for multipart separator
    char contentBoundary[MAX_BOUNDARY_SIZE];
@@ -0,0 +1,321 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// ssc_blog_decode: render a binary SSC log (see ssc_blog.h) as text.
+///
+/// usage: ssc_blog_decode <file>
+///
+/// output matches the text log: "HH:MM:SS.uuuuuu [LEVEL ] file:line:: message".
+/// must run on a machine with the same word size as the one that wrote the
+/// log, since integers are passed back to printf at their recorded width.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssc_blog.h"
+
+typedef struct decode_site_s
+{
+   unsigned line;
+   int nargs;              // -1 if the site was not encodable
+   const uint8_t *sig;
+   const char *file;
+   const char *tag;
+   const char *fmt;
+} decode_site_t;
+
+static char *priv_read_file(const char *path, size_t *size);
+static int priv_decode_sites(const char *buf, size_t size, decode_site_t *sites);
+static void priv_decode_record(const decode_site_t *site, const ssc_blog_file_rec_t *rec,
+                               const char *args, const char *end);
+static const char *priv_print_spec(const char *spec, int nstar, const int *star,
+                                   uint8_t type, const char *p, const char *end);
+
+int main(int argc, char **argv)
+{
+   if (argc != 2)
+   {
+      fprintf(stderr, "usage: %s <binary log file>\n", argv[0]);
+      return 2;
+   }
+
+   size_t size;
+   char *buf = priv_read_file(argv[1], &size);
+   if (!buf)
+   {
+      return 1;
+   }
+
+   const ssc_blog_file_hdr_t *hdr = (const ssc_blog_file_hdr_t *)buf;
+   if (size < sizeof(*hdr) || memcmp(hdr->magic, SSC_BLOG_MAGIC, sizeof(hdr->magic)) != 0)
+   {
+      fprintf(stderr, "%s: not an SSC binary log\n", argv[1]);
+      return 1;
+   }
+
+   if (hdr->version != SSC_BLOG_VERSION)
+   {
+      fprintf(stderr, "%s: unsupported version %u\n", argv[1], hdr->version);
+      return 1;
+   }
+
+   decode_site_t *sites = (decode_site_t *)calloc(hdr->sites + 1, sizeof(decode_site_t));
+   if (!sites || priv_decode_sites(buf, size, sites) != 0)
+   {
+      fprintf(stderr, "%s: corrupt site table\n", argv[1]);
+      return 1;
+   }
+
+   uint64_t end = hdr->wpos < size ? hdr->wpos : size;
+   uint64_t off = hdr->recs_off;
+
+   while (off + sizeof(ssc_blog_file_rec_t) <= end)
+   {
+      const ssc_blog_file_rec_t *rec = (const ssc_blog_file_rec_t *)(buf + off);
+
+      // a writer reserved this record but never finished it
+      if (rec->len < sizeof(*rec) || off + rec->len > end)
+      {
+         fprintf(stderr, "%s: incomplete record at offset %llu, stopping\n",
+                 argv[1], (unsigned long long)off);
+         break;
+      }
+
+      if (rec->site < hdr->sites && sites[rec->site].nargs >= 0)
+      {
+         priv_decode_record(&sites[rec->site], rec, buf + off + sizeof(*rec), buf + off + rec->len);
+      }
+      else
+      {
+         fprintf(stderr, "%s: bad site %u at offset %llu\n",
+                 argv[1], rec->site, (unsigned long long)off);
+      }
+
+      off += rec->len;
+   }
+
+   if (hdr->dropped)
+   {
+      fprintf(stderr, "%s: %llu record(s) dropped, file was full\n",
+              argv[1], (unsigned long long)hdr->dropped);
+   }
+
+   free(sites);
+   free(buf);
+   return 0;
+}
+
+
+/** internal functions follow **/
+
+char *priv_read_file(const char *path, size_t *size)
+{
+   FILE *f = fopen(path, "rb");
+   if (!f)
+   {
+      perror(path);
+      return NULL;
+   }
+
+   fseek(f, 0, SEEK_END);
+   long len = ftell(f);
+   fseek(f, 0, SEEK_SET);
+
+   char *buf = (len > 0) ? (char *)malloc((size_t)len) : NULL;
+   if (!buf || fread(buf, 1, (size_t)len, f) != (size_t)len)
+   {
+      fprintf(stderr, "%s: read failed\n", path);
+      free(buf);
+      fclose(f);
+      return NULL;
+   }
+
+   fclose(f);
+   *size = (size_t)len;
+   return buf;
+}
+
+int priv_decode_sites(const char *buf, size_t size, decode_site_t *sites)
+{
+   const ssc_blog_file_hdr_t *hdr = (const ssc_blog_file_hdr_t *)buf;
+   uint64_t off = hdr->sites_off;
+   uint32_t i;
+
+   for (i = 0; i < hdr->sites; ++i)
+   {
+      if (off + sizeof(ssc_blog_file_site_t) > size) { return -1; }
+
+      const ssc_blog_file_site_t *fs = (const ssc_blog_file_site_t *)(buf + off);
+      if (fs->len < sizeof(*fs) || off + fs->len > size) { return -1; }
+
+      const char *p = buf + off + sizeof(*fs);
+      sites[i].line = fs->line;
+      sites[i].nargs = (fs->nargs == 0xffff) ? -1 : fs->nargs;
+      sites[i].sig = (const uint8_t *)p;
+      if (sites[i].nargs > 0) { p += sites[i].nargs; }
+      sites[i].file = p;
+      p += strlen(p) + 1;
+      sites[i].tag = p;
+      p += strlen(p) + 1;
+      sites[i].fmt = p;
+
+      off += fs->len;
+   }
+
+   return 0;
+}
+
+void priv_decode_record(const decode_site_t *site, const ssc_blog_file_rec_t *rec,
+                        const char *args, const char *end)
+{
+   time_t sec = (time_t)(rec->ts_ns / 1000000000u);
+   struct tm hms;
+   gmtime_r(&sec, &hms);
+   printf("%02d:%02d:%02d.%06ld [%s] %s:%u:: ",
+          hms.tm_hour, hms.tm_min, hms.tm_sec,
+          (long)(rec->ts_ns % 1000000000u / 1000u),
+          site->tag, site->file, site->line);
+
+   const char *f = site->fmt;
+   const char *p = args;
+   int a = 0;
+
+   while (*f)
+   {
+      if (*f != '%')
+      {
+         putchar(*f++);
+         continue;
+      }
+
+      if (f[1] == '%')
+      {
+         putchar('%');
+         f += 2;
+         continue;
+      }
+
+      // copy out one conversion spec, counting '*' arguments
+      char spec[32];
+      size_t n = 0;
+      int nstar = 0;
+      int star[2];
+      spec[n++] = *f++;
+      while (*f && !strchr("diouxXceEfFgGaAspn", *f) && n < sizeof(spec) - 2)
+      {
+         if (*f == '*' && nstar < 2 && a < site->nargs)
+         {
+            int32_t v = 0;
+            if (p + sizeof(v) <= end) { memcpy(&v, p, sizeof(v)); }
+            p += sizeof(v);
+            star[nstar++] = v;
+            ++a;
+         }
+         spec[n++] = *f++;
+      }
+      if (!*f) { break; }
+      spec[n++] = *f++;
+      spec[n] = '\0';
+
+      if (a >= site->nargs) { break; }
+      p = priv_print_spec(spec, nstar, star, site->sig[a++], p, end);
+   }
+
+   putchar('\n');
+}
+
+// print one argument with its own conversion spec.
+// @return position of the next argument
+const char *priv_print_spec(const char *spec, int nstar, const int *star,
+                            uint8_t type, const char *p, const char *end)
+{
+// pass the recorded '*' values ahead of the argument
+#define PRINT_ARG(v)                                                          \
+   do                                                                         \
+   {                                                                          \
+      if (nstar == 2) { printf(spec, star[0], star[1], v); }                  \
+      else if (nstar == 1) { printf(spec, star[0], v); }                      \
+      else { printf(spec, v); }                                               \
+   } while (0)
+
+   switch (type)
+   {
+      case SSC_BLOG_ARG_I32:
+      {
+         int32_t v = 0;
+         if (p + sizeof(v) <= end) { memcpy(&v, p, sizeof(v)); }
+         PRINT_ARG((int)v);
+         return p + sizeof(v);
+      }
+
+      case SSC_BLOG_ARG_I64:
+      {
+         int64_t v = 0;
+         if (p + sizeof(v) <= end) { memcpy(&v, p, sizeof(v)); }
+         PRINT_ARG((long long)v);
+         return p + sizeof(v);
+      }
+
+      case SSC_BLOG_ARG_DBL:
+      {
+         double v = 0;
+         if (p + sizeof(v) <= end) { memcpy(&v, p, sizeof(v)); }
+         PRINT_ARG(v);
+         return p + sizeof(v);
+      }
+
+      case SSC_BLOG_ARG_PTR:
+      {
+         uint64_t v = 0;
+         if (p + sizeof(v) <= end) { memcpy(&v, p, sizeof(v)); }
+         PRINT_ARG((void *)(uintptr_t)v);
+         return p + sizeof(v);
+      }
+
+      case SSC_BLOG_ARG_STR:
+      {
+         uint16_t l = 0xffff;
+         if (p + sizeof(l) <= end) { memcpy(&l, p, sizeof(l)); }
+         p += sizeof(l);
+         if (l == 0xffff)
+         {
+            PRINT_ARG("(null)");
+            return p;
+         }
+
+         char s[SSC_BLOG_STR_MAX + 1];
+         if (l > SSC_BLOG_STR_MAX || p + l > end) { l = 0; }
+         memcpy(s, p, l);
+         s[l] = '\0';
+         PRINT_ARG(s);
+         return p + l;
+      }
+   }
+
+#undef PRINT_ARG
+
+   return end;
+}
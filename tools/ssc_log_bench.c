@@ -0,0 +1,192 @@
+/// added by San Luis Aviation Inc. Not part of original SSC
+/*
+ * This file is part of the Sofia-SIP package
+ *
+ * Copyright (C) 2013-2022 San Luis Aviation Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/// ssc_log_bench: cost of the SSC log macros per simulated INVITE.
+///
+/// usage: ssc_log_bench [invites] [log file]
+///
+/// each simulated INVITE makes 30 log calls spread over the levels the way
+/// the INVITE path in ssc_sip.c does (mostly LOW, some MED and HIGH, one
+/// WARN).  the run is repeated at every runtime level set with
+/// sscSetLogLevel() and then with the calls built at a higher
+/// SSC_LOG_MIN_LEVEL.  records go to /dev/null unless a log file is given,
+/// so the numbers are formatting and write cost, not disk speed.  the
+/// SSC_LOG_NONE row has every call compiled out and is the cost of the
+/// simulated INVITE itself.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ssc_log.h"
+
+#define BENCH_DEFAULT_INVITES 100000
+
+// the log calls of one INVITE: 18 LOW, 7 MED, 4 HIGH, 1 WARN
+#define BENCH_INVITE(cid, n, op)                                                \
+   do                                                                          \
+   {                                                                           \
+      SSCDebugLow("nua_invite tags:");                                         \
+      SSCDebugLow("requestUri - '%s'", "sip:1001@pbx.example.com");            \
+      SSCDebugLow("targetAddress - '%s'", "sip:10.0.0.1:5060");                \
+      SSCDebugLow("via - '%s'", "");                                           \
+      SSCDebugLow("to - '%s'", "<sip:1001@pbx.example.com>");                  \
+      SSCDebugLow("from - '%s'", "<sip:2002@pbx.example.com>;tag=a1b2");       \
+      SSCDebugLow("callId - '%s'", cid);                                       \
+      SSCDebugLow("accept - '%s'", "application/sdp");                         \
+      SSCDebugLow("allow - '%s'", "INVITE, ACK, BYE, CANCEL, OPTIONS");        \
+      SSCDebugLow("contact - '%s'", "<sip:2002@10.0.0.2:5060>");               \
+      SSCDebugLow("priority - '%s'", "normal");                                \
+      SSCDebugLow("route - '%s'", "");                                         \
+      SSCDebugLow("payload - <%p>", op);                                       \
+      SSCDebugLow("sdp - '%s'", "v=0 o=- 1 1 IN IP4 10.0.0.2 s=- c=IN IP4 10.0.0.2"); \
+      SSCDebugLow("contentLen - '%s'", "");                                    \
+      SSCDebugLow("def_branch: '%s'", "<nil>");                                \
+      SSCDebugMed("%s: op %p created for call %u", __func__, op, n);           \
+      SSCDebugMed("%s: handle %p bound to op %p", __func__, op, op);           \
+      SSCDebugMed("%s: INVITE sent, call %s", __func__, cid);                  \
+      SSCDebugHigh("%s: event nua_r_invite status 100 Trying op %p", __func__, op); \
+      SSCDebugLow("%s: call state %s -> %s", __func__, "init", "calling");     \
+      SSCDebugMed("%s: 180 Ringing for %s", __func__, cid);                    \
+      SSCDebugHigh("%s: event nua_r_invite status 180 Ringing op %p", __func__, op); \
+      SSCDebugLow("%s: call state %s -> %s", __func__, "calling", "proceeding"); \
+      SSCDebugMed("%s: 200 OK for %s", __func__, cid);                         \
+      SSCDebugHigh("%s: event nua_r_invite status 200 OK op %p", __func__, op); \
+      SSCDebugMed("%s: ACK sent, call %s", __func__, cid);                     \
+      SSCDebugMed("%s: call state %s -> %s", __func__, "completing", "ready"); \
+      SSCDebugHigh("%s: call %u established in %u ms", __func__, n, 42u);      \
+      SSCWarning("%s: call %s has no Session-ID", __func__, cid);              \
+   } while (0)
+
+typedef void (*bench_invite_fn)(unsigned n);
+
+static void priv_bench_invite(unsigned n);
+static void priv_bench_invite_min_warn(unsigned n);
+static void priv_bench_invite_min_none(unsigned n);
+static double priv_bench_run(bench_invite_fn fn, unsigned invites);
+static uint64_t priv_bench_clock_ns(void);
+
+int main(int argc, char **argv)
+{
+   static const char *const levelName[] = { "LOW", "MED", "HIGH", "WARN", "ERROR", "NONE" };
+
+   unsigned invites = BENCH_DEFAULT_INVITES;
+   const char *path = "/dev/null";
+
+   if (argc > 3 || (argc > 1 && (invites = (unsigned)strtoul(argv[1], NULL, 10)) == 0))
+   {
+      fprintf(stderr, "usage: %s [invites] [log file]\n", argv[0]);
+      return 2;
+   }
+   if (argc > 2)
+   {
+      path = argv[2];
+   }
+
+   FILE *logFile = fopen(path, "w");
+   if (!logFile)
+   {
+      perror(path);
+      return 1;
+   }
+   sscSetLogFile(logFile);
+
+   // warm up the stamp cache and the file
+   sscSetLogLevel(SSC_LOG_LOW);
+   priv_bench_run(priv_bench_invite, invites / 10 + 1);
+
+   printf("%u INVITEs, 30 log calls each\n\n", invites);
+   printf("%-22s %-8s %12s\n", "SSC_LOG_MIN_LEVEL", "runtime", "ns/INVITE");
+
+   int level;
+   for (level = SSC_LOG_LOW; level <= SSC_LOG_NONE; ++level)
+   {
+      sscSetLogLevel(level);
+      printf("%-22s %-8s %12.1f\n", "SSC_LOG_LOW (default)", levelName[level],
+            priv_bench_run(priv_bench_invite, invites));
+   }
+
+   sscSetLogLevel(SSC_LOG_LOW);
+   printf("%-22s %-8s %12.1f\n", "SSC_LOG_WARN", "LOW",
+         priv_bench_run(priv_bench_invite_min_warn, invites));
+   printf("%-22s %-8s %12.1f\n", "SSC_LOG_NONE", "LOW",
+         priv_bench_run(priv_bench_invite_min_none, invites));
+
+   sscSetLogFile(NULL);
+   fclose(logFile);
+
+   return 0;
+}
+
+
+/** internal functions follow **/
+
+void priv_bench_invite(unsigned n)
+{
+   char cid[48];
+   snprintf(cid, sizeof(cid), "%08x-bench@10.0.0.2", n);
+   BENCH_INVITE(cid, n, (void *)&cid);
+}
+
+// same calls, built as if the library were compiled with a higher minimum
+#undef SSC_LOG_MIN_LEVEL
+#define SSC_LOG_MIN_LEVEL SSC_LOG_WARN
+
+void priv_bench_invite_min_warn(unsigned n)
+{
+   char cid[48];
+   snprintf(cid, sizeof(cid), "%08x-bench@10.0.0.2", n);
+   BENCH_INVITE(cid, n, (void *)&cid);
+}
+
+#undef SSC_LOG_MIN_LEVEL
+#define SSC_LOG_MIN_LEVEL SSC_LOG_NONE
+
+void priv_bench_invite_min_none(unsigned n)
+{
+   char cid[48];
+   snprintf(cid, sizeof(cid), "%08x-bench@10.0.0.2", n);
+   BENCH_INVITE(cid, n, (void *)&cid);
+}
+
+// @return mean ns per INVITE
+double priv_bench_run(bench_invite_fn fn, unsigned invites)
+{
+   uint64_t start = priv_bench_clock_ns();
+
+   unsigned i;
+   for (i=0; i<invites; ++i)
+   {
+      fn(i);
+   }
+
+   return (double)(priv_bench_clock_ns() - start) / invites;
+}
+
+uint64_t priv_bench_clock_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}